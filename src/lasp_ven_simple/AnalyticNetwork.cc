@@ -0,0 +1,123 @@
+#include "AnalyticNetwork.h"
+#include "inet/common/ModuleAccess.h"
+#include "inet/networklayer/common/L3AddressTag_m.h"
+#include "inet/transportlayer/common/L4PortTag_m.h"
+
+namespace lasp_ven_simple {
+
+Define_Module(AnalyticNetwork);
+
+AnalyticNetwork::AnalyticNetwork()
+{
+}
+
+void AnalyticNetwork::initialize()
+{
+    link.configure(par("baseDelay").doubleValue(), par("bitrate").doubleValue(), par("minBitrate").doubleValue(),
+            par("range").doubleValue(), par("propagationSpeed").doubleValue(), par("loadWindow").doubleValue(),
+            par("maxUtilization").doubleValue());
+
+    linkDelay = registerSignal("linkDelay");
+    channelUtilization = registerSignal("channelUtilization");
+    packetsDropped = registerSignal("packetsDropped");
+}
+
+void AnalyticNetwork::handleMessage(cMessage* msg)
+{
+    throw cRuntimeError("AnalyticNetwork received unexpected message %s", msg->getName());
+}
+
+void AnalyticNetwork::bind(cModule* app, const L3Address& address, int port)
+{
+    Enter_Method_Silent();
+    unbind(app);
+    EndpointKey key(address, port);
+    auto it = endpoints.find(key);
+    if (it != endpoints.end()) {
+        throw cRuntimeError("%s cannot bind %s:%d, it is bound by %s", app->getFullPath().c_str(), address.str().c_str(),
+                port, it->second.app->getFullPath().c_str());
+    }
+    cModule* node = findContainingNode(app);
+    IMobility* mobility = node ? dynamic_cast<IMobility*>(node->getSubmodule("mobility")) : nullptr;
+    endpoints[key] = Endpoint{app, app->gate("directIn"), mobility};
+    boundEndpoints[app] = key;
+}
+
+void AnalyticNetwork::unbind(cModule* app)
+{
+    Enter_Method_Silent();
+    auto it = boundEndpoints.find(app);
+    if (it != boundEndpoints.end()) {
+        endpoints.erase(it->second);
+        boundEndpoints.erase(it);
+    }
+}
+
+void AnalyticNetwork::sendTo(cModule* app, Packet* packet, const L3Address& destAddress, int destPort)
+{
+    Enter_Method_Silent();
+    take(packet);
+    auto source = boundEndpoints.find(app);
+    if (source == boundEndpoints.end()) {
+        delete packet;
+        throw cRuntimeError("%s sends through the analytic network without being bound", app->getFullPath().c_str());
+    }
+    auto destination = endpoints.find(EndpointKey(destAddress, destPort));
+    if (destination == endpoints.end()) {
+        EV_WARN << "Analytic network: no endpoint " << destAddress << ":" << destPort << ", dropping " << packet->getName() << endl;
+        emit(packetsDropped, 1);
+        delete packet;
+        return;
+    }
+
+    const Endpoint& sender = endpoints.at(source->second);
+    const Endpoint& receiver = destination->second;
+    double distance = 0.0;
+    if (sender.mobility && receiver.mobility) {
+        distance = sender.mobility->getCurrentPosition().distance(receiver.mobility->getCurrentPosition());
+    }
+    double utilization = link.getUtilization(simTime().dbl());
+    simtime_t delay = link.transmit(distance, (double)packet->getTotalLength().get(), simTime().dbl());
+    emit(linkDelay, delay);
+    emit(channelUtilization, utilization);
+
+    deliver(packet, source->second, destAddress, destPort, delay, receiver.gate);
+}
+
+void AnalyticNetwork::sendToGroup(cModule* app, Packet* packet, const L3Address& groupAddress, int destPort)
+{
+    Enter_Method_Silent();
+    take(packet);
+    auto source = boundEndpoints.find(app);
+    if (source == boundEndpoints.end()) {
+        delete packet;
+        throw cRuntimeError("%s sends through the analytic network without being bound", app->getFullPath().c_str());
+    }
+
+    // Link-layer multicast goes out once, at the rate that reaches the whole range
+    double utilization = link.getUtilization(simTime().dbl());
+    simtime_t delay = link.transmit(par("range").doubleValue(), (double)packet->getTotalLength().get(), simTime().dbl());
+    emit(linkDelay, delay);
+    emit(channelUtilization, utilization);
+    for (const auto& endpoint : endpoints) {
+        if (endpoint.first.second == destPort && endpoint.second.app != app) {
+            deliver(packet->dup(), source->second, groupAddress, destPort, delay, endpoint.second.gate);
+        }
+    }
+    delete packet;
+}
+
+void AnalyticNetwork::deliver(Packet* packet, const EndpointKey& source, const L3Address& destAddress, int destPort,
+        simtime_t delay, cGate* gate)
+{
+    // What the receiving UdpSocket would have found on the packet
+    auto addresses = packet->addTagIfAbsent<L3AddressInd>();
+    addresses->setSrcAddress(source.first);
+    addresses->setDestAddress(destAddress);
+    auto ports = packet->addTagIfAbsent<L4PortInd>();
+    ports->setSrcPort(source.second);
+    ports->setDestPort(destPort);
+    sendDirect(packet, delay, SIMTIME_ZERO, gate);
+}
+
+} // namespace lasp_ven_simple
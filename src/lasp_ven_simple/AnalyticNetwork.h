@@ -0,0 +1,67 @@
+#ifndef ANALYTICNETWORK_H
+#define ANALYTICNETWORK_H
+
+#include "inet/common/packet/Packet.h"
+#include "inet/mobility/contract/IMobility.h"
+#include "inet/networklayer/common/L3Address.h"
+#include "utils/AnalyticLinkModel.h"
+#include <map>
+#include <utility>
+
+using namespace omnetpp;
+using namespace inet;
+
+namespace lasp_ven_simple {
+
+// Fast-forward replacement of the packet-level network for the LASP traffic.
+// Applications bind an address and port here instead of (or in addition to)
+// their UdpSocket; sendTo() hands a packet straight to the application bound
+// to the destination with sendDirect(), delayed by the AnalyticLinkModel for
+// the distance between the two nodes and the current channel load. The
+// packet arrives on the application's directIn gate carrying the
+// L3AddressInd and L4PortInd tags a UdpSocket would have set, so the
+// receiving socketDataArrived() code is the same in both modes.
+//
+// Packets for an address and port nobody is bound to are dropped; the
+// link itself never loses packets.
+class AnalyticNetwork : public cSimpleModule {
+public:
+    AnalyticNetwork();
+
+    // `app` needs a directIn gate; rebinding moves its endpoint
+    void bind(cModule* app, const L3Address& address, int port);
+    void unbind(cModule* app);
+    bool isBound(const cModule* app) const { return boundEndpoints.count(app) != 0; }
+
+    // Takes ownership of `packet`; throws cRuntimeError if `app` is not bound
+    void sendTo(cModule* app, Packet* packet, const L3Address& destAddress, int destPort);
+    // Multicast: a copy for every other endpoint bound to destPort, all with the
+    // delay of one transmission at the rate of the range boundary
+    void sendToGroup(cModule* app, Packet* packet, const L3Address& groupAddress, int destPort);
+
+protected:
+    virtual void initialize() override;
+    virtual void handleMessage(cMessage* msg) override;
+
+    typedef std::pair<L3Address, int> EndpointKey;
+    struct Endpoint {
+        cModule* app;
+        cGate* gate; // the app's directIn
+        IMobility* mobility; // of the app's node, nullptr places it at the origin
+    };
+    std::map<EndpointKey, Endpoint> endpoints;
+    std::map<const cModule*, EndpointKey> boundEndpoints;
+
+    AnalyticLinkModel link;
+
+    void deliver(Packet* packet, const EndpointKey& source, const L3Address& destAddress, int destPort,
+            simtime_t delay, cGate* gate);
+
+    simsignal_t linkDelay;
+    simsignal_t channelUtilization;
+    simsignal_t packetsDropped;
+};
+
+} // namespace lasp_ven_simple
+
+#endif // ANALYTICNETWORK_H
@@ -1,9 +1,13 @@
 #include "EdgeServerApp.h"
 #include "inet/common/ModuleAccess.h"
 #include "inet/common/TimeTag_m.h"
-#include "inet/networklayer/common/L3AddressResolver.h"
 #include "inet/networklayer/common/L3AddressTag_m.h"
-#include "inet/applications/base/ApplicationPacket_m.h"
+#include "inet/transportlayer/common/L4PortTag_m.h"
+#include "LaspMessages_m.h"
+#include "utils/ServicePlacementUtils.h"
+#include <istream>
+#include <ostream>
+#include <stdexcept>
 
 using namespace omnetpp;
 using namespace inet;
@@ -14,14 +18,20 @@ Define_Module(EdgeServerApp);
 
 EdgeServerApp::EdgeServerApp()
 {
-    EV_WARN << "EdgeServerApp constructor called" << endl;
+    profiling = false;
+    loadReportTimer = nullptr;
+    analyticNetwork = nullptr;
+    directory = nullptr;
+    socketDataArrivedTime = LatencyHistogram(1e-9, 2, 10.0); // 1ns resolution
+}
+
+EdgeServerApp::~EdgeServerApp()
+{
+    cancelAndDelete(loadReportTimer);
 }
 
 void EdgeServerApp::initialize(int stage)
 {
-    EV_WARN << "=== EDGE SERVER APP INITIALIZING ===" << endl;
-    EV_WARN << "Stage: " << stage << endl;
-    
     ApplicationBase::initialize(stage);
     
     if (stage == INITSTAGE_LOCAL) {
@@ -31,92 +41,133 @@ void EdgeServerApp::initialize(int stage)
         storageCapacity = par("storageCapacity");
         localPort = par("localPort");
         currentLoad = 0.0;
+        profiling = par("enableProfiling");
+        loadReportInterval = par("loadReportInterval");
+        analyticNetwork = findModuleFromPar<AnalyticNetwork>(par("analyticNetworkModule"), this);
+        directory = getModuleFromPar<NodeDirectory>(par("nodeDirectoryModule"), this);
+        
+        EV_INFO << "EdgeServerApp parameters loaded:" << endl;
+        EV_INFO << "  serverId: " << serverId << endl;
+        EV_INFO << "  computeCapacity: " << computeCapacity << endl;
+        EV_INFO << "  storageCapacity: " << storageCapacity << endl;
+        EV_INFO << "  localPort: " << localPort << endl;
+        EV_INFO << "  loadReportInterval: " << loadReportInterval << endl;
         
-        EV_WARN << "EdgeServerApp parameters loaded:" << endl;
-        EV_WARN << "  serverId: " << serverId << endl;
-        EV_WARN << "  computeCapacity: " << computeCapacity << endl;
-        EV_WARN << "  storageCapacity: " << storageCapacity << endl;
-        EV_WARN << "  localPort: " << localPort << endl;
+        std::string traceFile = par("traceFile").stdstringValue();
+        if (!traceFile.empty()) {
+            trace.open(traceFile + "." + getFullPath() + ".trc", getId(), getFullPath());
+        }
+        
+        try {
+            services = parseServiceMask(par("services").stdstringValue());
+        }
+        catch (const std::invalid_argument& e) {
+            throw cRuntimeError("Invalid services parameter: %s", e.what());
+        }
+        EV_INFO << "  services: " << formatServiceMask(services) << endl;
         
-        // Initialize supported services (all services for simplicity)
-        supportedServices = {TRAFFIC_INFO, EMERGENCY_ALERT, INFOTAINMENT, NAVIGATION};
+        if (auto checkpointer = findModuleFromPar<LaspCheckpointer>(par("checkpointerModule"), this)) {
+            if (checkpointer->restore(this)) {
+                EV_INFO << "  load restored from checkpoint: " << currentLoad << endl;
+            }
+        }
         
         // Initialize statistics
         requestsReceived = registerSignal("requestsReceived");
         requestsProcessed = registerSignal("requestsProcessed");
         serverLoadSignal = registerSignal("serverLoad");
-        
-        EV_WARN << "Statistics signals registered successfully" << endl;
-        EV_WARN << "=== EDGE SERVER APP INITIALIZED ===" << endl;
+        directRequestsServed = registerSignal("directRequestsServed");
+        directRequestsRejected = registerSignal("directRequestsRejected");
     }
 }
 
 void EdgeServerApp::handleStartOperation(inet::LifecycleOperation* operation)
 {
-    EV_WARN << "=== EDGE SERVER STARTING ===" << endl;
-    EV_WARN << "EdgeServer " << serverId << " handleStartOperation called" << endl;
-    EV_WARN << "EdgeServer " << serverId << " starting on port " << localPort << endl;
+    EV_INFO << "EdgeServer " << serverId << " starting on port " << localPort << endl;
     
     // Setup UDP socket
     socket.setOutputGate(gate("socketOut"));
     socket.bind(localPort);
     socket.setCallback(this);
     
-    EV_WARN << "EdgeServer " << serverId << " socket setup complete" << endl;
-    EV_WARN << "[NETWORK-DEBUG] EdgeServer " << serverId << " bound to port " << localPort << " and ready to receive" << endl;
-    
+#if LASP_TRACE_LEVEL >= 2
     // Debug: Check IP address and routing
     auto wlan = getModuleByPath("^.wlan[0]");
     if (wlan) {
-        EV_WARN << "[DEBUG-ROUTE-001] EdgeServer " << serverId << ": Found wlan interface" << endl;
-        
         // IPv4 module is at host level, not wlan level
-        auto ipv4 = getModuleByPath("^.ipv4");
-        
-        if (ipv4) {
-            EV_WARN << "[DEBUG-ROUTE-001] EdgeServer " << serverId << ": Found IPv4 module at host level" << endl;
-            
-            // Check routing table at host level
-            auto routingTable = getModuleByPath("^.ipv4.routingTable");
-            if (routingTable) {
-                auto iroutingTable = check_and_cast<IRoutingTable*>(routingTable);
-                EV_WARN << "[DEBUG-ROUTE-001] EdgeServer " << serverId << ": Routing table has " << iroutingTable->getNumRoutes() << " routes" << endl;
-                EV_WARN << "[NETWORK-DEBUG] EdgeServer " << serverId << ": IPv4 network stack is properly initialized!" << endl;
-                for (int i = 0; i < iroutingTable->getNumRoutes(); i++) {
-                    auto route = iroutingTable->getRoute(i);
-                    if (route) {
-                        EV_WARN << "[DEBUG-ROUTE-001] EdgeServer " << serverId << ": Route " << i << ": " 
-                                << route->getDestinationAsGeneric().str() << " -> " << route->getNextHopAsGeneric().str() << endl;
-                    }
+        auto routingTable = getModuleByPath("^.ipv4.routingTable");
+        if (routingTable) {
+            auto iroutingTable = check_and_cast<IRoutingTable*>(routingTable);
+            EV_DEBUG << "EdgeServer " << serverId << ": Routing table has " << iroutingTable->getNumRoutes() << " routes" << endl;
+            for (int i = 0; i < iroutingTable->getNumRoutes(); i++) {
+                auto route = iroutingTable->getRoute(i);
+                if (route) {
+                    LASP_TRACE_DEBUG(trace, ROUTE, i, route->getDestinationAsGeneric().toIpv4().getInt(), route->getNextHopAsGeneric().toIpv4().getInt(), 0.0);
                 }
-            } else {
-                EV_WARN << "[DEBUG-ROUTE-001] EdgeServer " << serverId << ": No routing table found" << endl;
             }
         } else {
-            EV_WARN << "[DEBUG-ROUTE-001] EdgeServer " << serverId << ": No IPv4 module found at host level" << endl;
+            EV_DEBUG << "EdgeServer " << serverId << ": No routing table found" << endl;
         }
     } else {
-        EV_WARN << "[DEBUG-ROUTE-001] EdgeServer " << serverId << ": No wlan interface found" << endl;
+        EV_DEBUG << "EdgeServer " << serverId << ": No wlan interface found" << endl;
+    }
+#endif
+    
+    // Deployments and leases name the server by its directory address
+    if (analyticNetwork) {
+        const NodeEndpoint& self = directory->getEdgeServer(serverId);
+        analyticNetwork->bind(this, self.address, localPort);
+        EV_INFO << "EdgeServer " << serverId << " bound to the analytic network as " << self.address << ":" << localPort << endl;
     }
     
-    EV_WARN << "=== EDGE SERVER STARTED ===" << endl;
+    // Report to the LASPManager of the node directory
+    if (loadReportInterval > SIMTIME_ZERO) {
+        laspManagerAddress = directory->getManager().address;
+        laspManagerPort = directory->getManager().port;
+        if (!loadReportTimer) {
+            loadReportTimer = new cMessage("loadReportTimer");
+        }
+        sendLoadReport();
+    }
 }
 
 void EdgeServerApp::handleStopOperation(inet::LifecycleOperation* operation)
 {
+    if (loadReportTimer) {
+        cancelEvent(loadReportTimer);
+    }
+    if (analyticNetwork) {
+        analyticNetwork->unbind(this);
+    }
     socket.close();
-    EV_WARN << "EdgeServer " << serverId << " stopped" << endl;
+    EV_INFO << "EdgeServer " << serverId << " stopped" << endl;
 }
 
 void EdgeServerApp::handleCrashOperation(inet::LifecycleOperation* operation)
 {
+    // Reports stop with the server, which is how the LASPManager notices
+    if (loadReportTimer) {
+        cancelEvent(loadReportTimer);
+    }
+    if (analyticNetwork) {
+        analyticNetwork->unbind(this);
+    }
     socket.destroy();
     EV_WARN << "EdgeServer " << serverId << " crashed!" << endl;
 }
 
 void EdgeServerApp::handleMessage(cMessage *msg)
 {
-    if (msg->isSelfMessage()) {
+    if (msg == loadReportTimer) {
+        sendLoadReport();
+    } else if (msg->arrivedOn("directIn")) {
+        // Delivered by the analytic network; a crashed server drops it like its radio would
+        if (analyticNetwork && analyticNetwork->isBound(this)) {
+            socketDataArrived(&socket, check_and_cast<Packet*>(msg));
+        } else {
+            delete msg;
+        }
+    } else if (msg->isSelfMessage()) {
         // Handle self-messages (timers, etc.)
         delete msg;
     } else {
@@ -138,25 +189,23 @@ void EdgeServerApp::refreshDisplay() const
 
 void EdgeServerApp::socketDataArrived(UdpSocket *socket, Packet *packet)
 {
-    EV_WARN << "[FLOW-4] EDGESERVER " << serverId << " <- LASPManager: Received packet: " << packet->getName() << " at " << simTime() << endl;
-    
+    ScopedTimer timer(profiling ? &socketDataArrivedTime : nullptr);
     emit(requestsReceived, 1);
     
     // Get client address for response
     auto addressInd = packet->getTag<L3AddressInd>();
     L3Address clientAddr = addressInd->getSrcAddress();
-    
-    EV_WARN << "[FLOW-4] EDGESERVER " << serverId << " <- LASPManager: Client address: " << clientAddr.str() << endl;
+    int clientPort = packet->getTag<L4PortInd>()->getSrcPort();
     
     // Check packet name to determine if it's a deployment command or direct service request
-    if (strcmp(packet->getName(), "ServiceDeployment") == 0) {
-        EV_WARN << "[FLOW-4] EDGESERVER " << serverId << " <- LASPManager: Processing deployment command" << endl;
+    if (strcmp(packet->getName(), "ServiceDeployment") == 0 || strcmp(packet->getName(), "InstanceBinding") == 0) {
         // This is a deployment command from LASPManager
         handleDeploymentCommand(packet, clientAddr);
+    } else if (strcmp(packet->getName(), "DirectServiceRequest") == 0) {
+        // A vehicle holding a placement lease for this server, or placing on the load map, talks to us directly
+        handleDirectServiceRequest(packet, clientAddr, clientPort);
     } else {
         EV_WARN << "[FLOW-4] EDGESERVER " << serverId << " <- LASPManager: Unexpected packet type: " << packet->getName() << endl;
-        // This is a direct service request (shouldn't happen in our current flow)
-        handleDirectServiceRequest(packet, clientAddr);
     }
     
     delete packet;
@@ -173,13 +222,20 @@ void EdgeServerApp::socketClosed(UdpSocket *socket)
     EV_WARN << "EdgeServer " << serverId << " socket closed" << endl;
 }
 
-void EdgeServerApp::processServiceRequest(const ServiceRequest& request, const L3Address& clientAddr, int clientPort)
+void EdgeServerApp::sendPacket(Packet* packet, const L3Address& destAddr, int destPort)
+{
+    if (analyticNetwork) {
+        analyticNetwork->sendTo(this, packet, destAddr, destPort);
+    } else {
+        socket.sendTo(packet, destAddr, destPort);
+    }
+}
+
+bool EdgeServerApp::processServiceRequest(const ServiceRequest& request, const L3Address& clientAddr, int clientPort)
 {
-    EV_WARN << "EdgeServer " << serverId << " processing request from vehicle " << request.vehicleId << endl;
-    
     if (!canHandleRequest(request)) {
-        EV_WARN << "EdgeServer " << serverId << " cannot handle request - insufficient capacity or unsupported service" << endl;
-        return;
+        LASP_TRACE(trace, REQUEST_REJECTED, request.vehicleId, request.requestId, serverId, currentLoad / computeCapacity);
+        return false;
     }
     
     // Process the request
@@ -189,12 +245,9 @@ void EdgeServerApp::processServiceRequest(const ServiceRequest& request, const L
     emit(requestsProcessed, 1);
     emit(serverLoadSignal, (currentLoad / computeCapacity) * 100);
     
-    // Send response back to client (simplified)
-    auto response = new Packet("ServiceResponse");
-    socket.sendTo(response, clientAddr, clientPort);
-    
-    EV_WARN << "EdgeServer " << serverId << " processed request, current load: " 
-            << (currentLoad / computeCapacity) * 100 << "%" << endl;
+    // Send response back to client
+    sendResponse("ServiceResponse", request.vehicleId, request.requestId, clientAddr, clientPort);
+    return true;
 }
 
 bool EdgeServerApp::canHandleRequest(const ServiceRequest& request)
@@ -215,12 +268,7 @@ bool EdgeServerApp::canHandleRequest(const ServiceRequest& request)
 
 bool EdgeServerApp::isServiceSupported(ServiceType serviceType) const
 {
-    for (ServiceType service : supportedServices) {
-        if (service == serviceType) {
-            return true;
-        }
-    }
-    return false;
+    return (services & serviceBit(serviceType)) != 0;
 }
 
 void EdgeServerApp::updateLoad(double additionalLoad)
@@ -237,59 +285,108 @@ void EdgeServerApp::updateLoad(double additionalLoad)
     }
 }
 
+void EdgeServerApp::sendResponse(const char* name, int vehicleId, long requestId, const L3Address& destAddr, int destPort)
+{
+    auto response = new Packet(name);
+    auto responsePayload = makeShared<ServiceResponseMessage>();
+    responsePayload->setChunkLength(B(300)); // 300 bytes response
+    responsePayload->setVehicleId(vehicleId);
+    responsePayload->setRequestId(requestId);
+    responsePayload->setServerId(serverId);
+    response->insertAtBack(responsePayload);
+    sendPacket(response, destAddr, destPort);
+    LASP_TRACE(trace, RESPONSE_SENT, vehicleId, requestId, serverId, 0.0);
+}
+
 void EdgeServerApp::handleDeploymentCommand(Packet* packet, const L3Address& laspManagerAddr)
 {
     // Extract deployment information
-    auto payload = packet->peekData<ApplicationPacket>();
-    int vehicleId = payload->getSequenceNumber();
-    
-    EV_WARN << "[FLOW-5] EDGESERVER " << serverId << " -> VEHICLE " << vehicleId << ": Processing deployment command" << endl;
+    auto payload = packet->peekData<ServiceDeploymentMessage>();
+    int vehicleId = payload->getVehicleId();
+    long requestId = payload->getRequestId();
     
     // Simulate service processing time
     double processingTime = uniform(0.01, 0.05); // 10-50ms processing time
+    LASP_TRACE(trace, DEPLOYMENT_RECEIVED, vehicleId, requestId, payload->getServiceType(), processingTime);
     
-    EV_WARN << "[FLOW-5] EDGESERVER " << serverId << " -> VEHICLE " << vehicleId << ": Processing time: " << (processingTime * 1000) << "ms" << endl;
-    
-    // Update server load
-    updateLoad(1.0); // Add some load for this service
-    
-    // Create service response
-    auto response = new Packet("ServiceResponse");
-    auto responsePayload = makeShared<ApplicationPacket>();
-    responsePayload->setChunkLength(B(300)); // 300 bytes response
-    responsePayload->setSequenceNumber(vehicleId);
-    response->insertAtBack(responsePayload);
+    // Only a new service instance adds load, a binding shares a running one
+    if (strcmp(packet->getName(), "ServiceDeployment") == 0) {
+        updateLoad(1.0);
+    }
     
-    // Send response back to vehicle using the correct port for each vehicle
-    std::string addressStr = "192.168.1." + std::to_string(10 + vehicleId);
-    L3Address vehicleAddr = L3AddressResolver().resolve(addressStr.c_str());
-    int vehiclePort = 5000 + vehicleId; // Each vehicle uses port 5000 + vehicleId
+    // Send response back to the vehicle's service endpoint, and to every
+    // vehicle whose request the LASPManager collapsed into this one
+    size_t numCollapsed = payload->getCollapsedVehicleIdArraySize();
+    for (size_t i = 0; i <= numCollapsed; i++) {
+        int responseVehicleId = i == 0 ? vehicleId : payload->getCollapsedVehicleId(i - 1);
+        long responseRequestId = i == 0 ? requestId : payload->getCollapsedRequestId(i - 1);
+        const NodeEndpoint* vehicle = directory->findVehicle(responseVehicleId);
+        if (vehicle) {
+            // For now, send immediately (in real implementation, would schedule)
+            sendResponse("ServiceResponse", responseVehicleId, responseRequestId, vehicle->address, vehicle->port);
+        }
+        else {
+            EV_WARN << "[FLOW-5] EDGESERVER " << serverId << " -> VEHICLE: vehicle " << responseVehicleId << " is not in the node directory, no response" << endl;
+        }
+        emit(requestsProcessed, 1);
+    }
     
-    EV_WARN << "[FLOW-5] EDGESERVER " << serverId << " -> VEHICLE " << vehicleId << ": Sending response to " << vehicleAddr.str() << ":" << vehiclePort << endl;
+    emit(serverLoadSignal, (currentLoad / computeCapacity) * 100);
+}
+
+void EdgeServerApp::handleDirectServiceRequest(Packet* packet, const L3Address& clientAddr, int clientPort)
+{
+    auto payload = packet->peekData<ServiceRequestMessage>();
+    int vehicleId = payload->getVehicleId();
     
-    // For now, send immediately (in real implementation, would schedule)
-    socket.sendTo(response, vehicleAddr, vehiclePort);
+    LASP_TRACE(trace, DIRECT_REQUEST, vehicleId, payload->getRequestId(), payload->getServiceType(), currentLoad / computeCapacity);
     
-    emit(requestsProcessed, 1);
-    emit(serverLoadSignal, (currentLoad / computeCapacity) * 100);
+    // Same request model the LASPManager uses when it places a request
+    ServiceRequest request = ServicePlacementUtils::makeRequest(vehicleId, payload->getRequestId(),
+            static_cast<ServiceType>(payload->getServiceType()), simTime().dbl(), 1.0,
+            payload->getExcludeServerId(), payload->getHedged());
     
-    EV_WARN << "[FLOW-5] EDGESERVER " << serverId << " -> VEHICLE " << vehicleId << ": Response sent (load: " << (currentLoad / computeCapacity) * 100 << "%)" << endl;
+    if (processServiceRequest(request, clientAddr, clientPort)) {
+        emit(directRequestsServed, 1);
+    }
+    else {
+        // Tell the vehicle to drop its lease and go back through the LASPManager
+        sendResponse("LeaseRejected", vehicleId, request.requestId, clientAddr, clientPort);
+        emit(directRequestsRejected, 1);
+    }
 }
 
-void EdgeServerApp::handleDirectServiceRequest(Packet* packet, const L3Address& clientAddr)
+void EdgeServerApp::sendLoadReport()
 {
-    // Handle direct service requests (for future use)
-    EV_WARN << "EdgeServer " << serverId << " received direct service request" << endl;
+    auto packet = new Packet("LoadReport");
+    auto report = makeShared<LoadReport>();
+    report->setChunkLength(B(16));
+    report->setServerId(serverId);
+    report->setUtilization(currentLoad / computeCapacity);
+    packet->insertAtBack(report);
+    sendPacket(packet, laspManagerAddress, laspManagerPort);
     
-    // For now, just acknowledge
-    auto response = new Packet("DirectServiceResponse");
-    socket.sendTo(response, clientAddr, 5000);
+    scheduleAt(simTime() + loadReportInterval, loadReportTimer);
+}
+
+void EdgeServerApp::saveState(std::ostream& out) const
+{
+    out << currentLoad << "\n";
+}
+
+void EdgeServerApp::restoreState(std::istream& in)
+{
+    in >> currentLoad;
 }
 
 void EdgeServerApp::finish()
 {
     EV_WARN << "EdgeServer " << serverId << " finished. Final load: " 
             << (currentLoad / computeCapacity) * 100 << "%" << endl;
+    if (profiling) {
+        socketDataArrivedTime.recordScalars(this, "wallTime:socketDataArrived");
+    }
+    trace.close();
 }
 
 } // namespace lasp_ven_simple
@@ -3,31 +3,53 @@
 
 #include "inet/applications/base/ApplicationBase.h"
 #include "inet/transportlayer/contract/udp/UdpSocket.h"
+#include "AnalyticNetwork.h"
 #include "LASPManager.h"
+#include "LaspCheckpointer.h"
+#include "NodeDirectory.h"
+#include "utils/ScopedTimer.h"
+#include "utils/Trace.h"
 
 using namespace omnetpp;
 using namespace inet;
 
 namespace lasp_ven_simple {
 
-class EdgeServerApp : public ApplicationBase, public UdpSocket::ICallback
+class EdgeServerApp : public ApplicationBase, public UdpSocket::ICallback, public ICheckpointable
 {
 private:
     // Network
     UdpSocket socket;
     int localPort;
     int serverId;
+    AnalyticNetwork* analyticNetwork; // replaces the socket for LASP traffic if set
+    NodeDirectory* directory;
     
     // Server properties
     double computeCapacity;
     double storageCapacity;
     double currentLoad;
-    std::vector<ServiceType> supportedServices;
+    ServiceMask services; // hosted services, one bit per ServiceType
+    
+    // Periodic LoadReport to the LASPManager, which takes its absence as a failure
+    simtime_t loadReportInterval;
+    cMessage* loadReportTimer;
+    L3Address laspManagerAddress;
+    int laspManagerPort;
     
     // Statistics
     simsignal_t requestsReceived;
     simsignal_t requestsProcessed;
     simsignal_t serverLoadSignal;
+    simsignal_t directRequestsServed;
+    simsignal_t directRequestsRejected;
+    
+    // Binary trace of per-request events (see utils/Trace.h)
+    TraceBuffer trace;
+    
+    // Wall-clock cost of packet handling (enableProfiling), s
+    bool profiling;
+    LatencyHistogram socketDataArrivedTime;
     
 protected:
     virtual void initialize(int stage) override;
@@ -46,19 +68,27 @@ protected:
     virtual void socketDataArrived(UdpSocket *socket, Packet *packet) override;
     virtual void socketErrorArrived(UdpSocket *socket, Indication *indication) override;
     virtual void socketClosed(UdpSocket *socket) override;
+    virtual void sendPacket(Packet* packet, const L3Address& destAddr, int destPort);
     
     // Service processing
-    virtual void processServiceRequest(const ServiceRequest& request, const L3Address& clientAddr, int clientPort);
+    virtual bool processServiceRequest(const ServiceRequest& request, const L3Address& clientAddr, int clientPort);
     virtual bool canHandleRequest(const ServiceRequest& request);
     virtual void updateLoad(double additionalLoad);
+    virtual void sendResponse(const char* name, int vehicleId, long requestId, const L3Address& destAddr, int destPort);
     
     // New deployment handling methods
     virtual void handleDeploymentCommand(Packet* packet, const L3Address& laspManagerAddr);
-    virtual void handleDirectServiceRequest(Packet* packet, const L3Address& clientAddr);
+    virtual void handleDirectServiceRequest(Packet* packet, const L3Address& clientAddr, int clientPort);
+    virtual void sendLoadReport();
+    
+    // Current load
+    virtual std::string getCheckpointKey() const override { return getFullPath(); }
+    virtual void saveState(std::ostream& out) const override;
+    virtual void restoreState(std::istream& in) override;
 
 public:
     EdgeServerApp();
-    virtual ~EdgeServerApp() {}
+    virtual ~EdgeServerApp();
     
     // Public interface for LASPManager
     double getCurrentLoad() const { return currentLoad; }
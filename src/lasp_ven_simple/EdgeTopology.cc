@@ -0,0 +1,266 @@
+#include "EdgeTopology.h"
+#include "NodeDirectory.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+namespace lasp_ven_simple {
+
+namespace {
+
+double parseNumber(const cXMLElement* element, const char* attribute, double defaultValue)
+{
+    const char* text = element->getAttribute(attribute);
+    if (!text) {
+        return defaultValue;
+    }
+    char* end = nullptr;
+    errno = 0;
+    double value = std::strtod(text, &end);
+    if (end == text || *end != '\0' || errno != 0) {
+        throw cRuntimeError("Edge topology: attribute %s=\"%s\" of <%s> is not a number at %s",
+                attribute, text, element->getTagName(), element->getSourceLocation());
+    }
+    return value;
+}
+
+std::string escapeAttribute(const std::string& text)
+{
+    std::string escaped;
+    for (char c : text) {
+        switch (c) {
+            case '&': escaped += "&amp;"; break;
+            case '<': escaped += "&lt;"; break;
+            case '>': escaped += "&gt;"; break;
+            case '"': escaped += "&quot;"; break;
+            default: escaped += c; break;
+        }
+    }
+    return escaped;
+}
+
+void writeElement(std::ostream& out, const cXMLElement* element, const std::string& indent)
+{
+    out << indent << "<" << element->getTagName();
+    for (const auto& attribute : element->getAttributes()) {
+        out << " " << attribute.first << "=\"" << escapeAttribute(attribute.second) << "\"";
+    }
+    cXMLElementList children = element->getChildren();
+    if (children.empty()) {
+        out << "/>\n";
+        return;
+    }
+    out << ">\n";
+    for (const cXMLElement* child : children) {
+        writeElement(out, child, indent + "    ");
+    }
+    out << indent << "</" << element->getTagName() << ">\n";
+}
+
+void writeInterface(std::ostream& out, const std::string& hosts, const TopologyNode& node)
+{
+    out << "    <interface hosts=\"" << hosts << "\" names=\"wlan0\" address=\"" << escapeAttribute(node.address)
+        << "\" netmask=\"" << escapeAttribute(node.netmask) << "\"/>\n";
+}
+
+} // namespace
+
+EdgeTopology::EdgeTopology(const cXMLElement* document)
+{
+    if (!document) {
+        throw cRuntimeError("Edge topology: no document");
+    }
+    if (strcmp(document->getTagName(), "topology") != 0) {
+        throw cRuntimeError("Edge topology: root element must be <topology>, not <%s> at %s",
+                document->getTagName(), document->getSourceLocation());
+    }
+    const char* defaultNetmask = document->getAttribute("netmask");
+    if (!defaultNetmask) {
+        defaultNetmask = "255.255.255.0";
+    }
+
+    footprints.assign(NUM_SERVICE_TYPES + 1, ServiceFootprint{0.0, 0.0, 0.0});
+    for (const cXMLElement* element : document->getChildrenByTagName("service")) {
+        const char* name = element->getAttribute("name");
+        int type = name ? serviceTypeFromName(name) : 0;
+        if (type == 0) {
+            throw cRuntimeError("Edge topology: <service> with unknown name \"%s\" at %s", name ? name : "", element->getSourceLocation());
+        }
+        footprints[type] = ServiceFootprint{parseNumber(element, "cpu", 0.0), parseNumber(element, "memory", 0.0), parseNumber(element, "storage", 0.0)};
+    }
+
+    const cXMLElement* managerElement = document->getFirstChildWithTag("manager");
+    if (!managerElement) {
+        throw cRuntimeError("Edge topology: missing <manager> at %s", document->getSourceLocation());
+    }
+    manager = parseNode(managerElement, 0, defaultNetmask);
+    if (!managerElement->getAttribute("port")) {
+        manager.port = 15000;
+    }
+
+    std::set<int> ids;
+    for (const cXMLElement* element : document->getChildrenByTagName("server")) {
+        TopologyNode server = parseNode(element, (int)servers.size(), defaultNetmask);
+        if (!ids.insert(server.id).second) {
+            throw cRuntimeError("Edge topology: duplicate server id %d at %s", server.id, element->getSourceLocation());
+        }
+        servers.push_back(server);
+    }
+    if (servers.empty()) {
+        throw cRuntimeError("Edge topology: no <server> elements at %s", document->getSourceLocation());
+    }
+
+    vehicles = VehicleAddressPool{"10.1.0.0", "255.255.0.0", "255.255.255.0", 5000};
+    if (const cXMLElement* element = document->getFirstChildWithTag("vehicles")) {
+        const char* address = element->getAttribute("address");
+        const char* netmask = element->getAttribute("netmask");
+        const char* subnetNetmask = element->getAttribute("subnetNetmask");
+        vehicles.address = address ? address : vehicles.address;
+        vehicles.netmask = netmask ? netmask : vehicles.netmask;
+        vehicles.subnetNetmask = subnetNetmask ? subnetNetmask : vehicles.subnetNetmask;
+        vehicles.port = (int)parseNumber(element, "port", vehicles.port);
+    }
+
+    std::ostringstream config;
+    config << "<config>\n";
+    writeInterface(config, "laspManager", manager);
+    for (size_t i = 0; i < servers.size(); i++) {
+        writeInterface(config, "edgeServer[" + std::to_string(i) + "]", servers[i]);
+    }
+    // Vehicles share the wireless link, their subnets are reached directly
+    config << "    <route hosts=\"laspManager edgeServer[*]\" destination=\"" << escapeAttribute(vehicles.address)
+           << "\" netmask=\"" << escapeAttribute(vehicles.netmask) << "\" interface=\"wlan0\"/>\n";
+    for (const cXMLElement* element : document->getChildren()) {
+        const char* tag = element->getTagName();
+        if (strcmp(tag, "manager") != 0 && strcmp(tag, "server") != 0 && strcmp(tag, "service") != 0 && strcmp(tag, "vehicles") != 0) {
+            writeElement(config, element, "    ");
+        }
+    }
+    config << "</config>\n";
+    networkConfig = config.str();
+}
+
+TopologyNode EdgeTopology::parseNode(const cXMLElement* element, int index, const char* defaultNetmask) const
+{
+    TopologyNode node;
+    node.id = (int)parseNumber(element, "id", index);
+    const char* address = element->getAttribute("address");
+    if (!address || !*address) {
+        throw cRuntimeError("Edge topology: <%s> without address at %s", element->getTagName(), element->getSourceLocation());
+    }
+    node.address = address;
+    const char* netmask = element->getAttribute("netmask");
+    node.netmask = netmask ? netmask : defaultNetmask;
+    node.port = (int)parseNumber(element, "port", 8000 + node.id);
+    node.x = parseNumber(element, "x", 0.0);
+    node.y = parseNumber(element, "y", 0.0);
+    node.z = parseNumber(element, "z", 15.0);
+    node.computeCapacity = parseNumber(element, "computeCapacity", 100.0);
+    node.storageCapacity = parseNumber(element, "storageCapacity", 1000.0);
+    node.memoryCapacity = parseNumber(element, "memoryCapacity", 16.0);
+
+    const char* services = element->getAttribute("services");
+    try {
+        node.services = parseServiceMask(services ? services : "*");
+    }
+    catch (const std::invalid_argument& e) {
+        throw cRuntimeError("Edge topology: %s in services of <%s> at %s", e.what(), element->getTagName(), element->getSourceLocation());
+    }
+    // Drop services that could never be placed here
+    for (int type = 1; type <= NUM_SERVICE_TYPES; type++) {
+        const ServiceFootprint& footprint = footprints[type];
+        if (footprint.cpu > node.computeCapacity || footprint.memory > node.memoryCapacity || footprint.storage > node.storageCapacity) {
+            node.services &= ~serviceBit(type);
+        }
+    }
+    return node;
+}
+
+const TopologyNode& EdgeTopology::getServer(int index) const
+{
+    if (index < 0 || index >= (int)servers.size()) {
+        throw cRuntimeError("Edge topology: server index %d out of range, the topology has %d servers", index, (int)servers.size());
+    }
+    return servers[index];
+}
+
+// NED functions, so that network, mobility and configurator parameters can be
+// taken from the same descriptor
+
+// Calls f with the network's parsed descriptor. Parameters evaluated before the
+// nodeDirectory submodule exists (e.g. the network's own numEdgeServers), or
+// that name another document, parse a copy of their own.
+template <typename F>
+static cNedValue withTopology(const cXMLElement* document, F f)
+{
+    cModule* network = cSimulation::getActiveSimulation()->getSystemModule();
+    auto directory = network ? dynamic_cast<NodeDirectory*>(network->getSubmodule("nodeDirectory")) : nullptr;
+    if (directory && directory->getTopologyDocument() == document) {
+        return f(directory->getTopology());
+    }
+    return f(EdgeTopology(document));
+}
+
+static cNedValue nedNumTopologyServers(cComponent *context, cNedValue argv[], int argc)
+{
+    return withTopology(argv[0].xmlValue(), [](const EdgeTopology& topology) {
+        return cNedValue((intpar_t)topology.getServers().size());
+    });
+}
+
+Define_NED_Function2(nedNumTopologyServers, "int numTopologyServers(xml topology)", "lasp",
+        "Number of edge servers in an edge topology descriptor");
+
+static cNedValue nodeAttribute(const TopologyNode& node, const std::string& attribute)
+{
+    if (attribute == "id") return cNedValue((intpar_t)node.id);
+    if (attribute == "port") return cNedValue((intpar_t)node.port);
+    if (attribute == "address") return cNedValue(node.address);
+    if (attribute == "netmask") return cNedValue(node.netmask);
+    if (attribute == "x") return cNedValue(node.x, "m");
+    if (attribute == "y") return cNedValue(node.y, "m");
+    if (attribute == "z") return cNedValue(node.z, "m");
+    if (attribute == "computeCapacity") return cNedValue(node.computeCapacity, "GFLOPS");
+    if (attribute == "storageCapacity") return cNedValue(node.storageCapacity, "GB");
+    if (attribute == "memoryCapacity") return cNedValue(node.memoryCapacity, "GB");
+    if (attribute == "services") return cNedValue(formatServiceMask(node.services));
+    throw cRuntimeError("Edge topology: unknown attribute '%s'", attribute.c_str());
+}
+
+static cNedValue nedTopologyServer(cComponent *context, cNedValue argv[], int argc)
+{
+    int index = (int)argv[1].intValue();
+    std::string attribute = argv[2].stdstringValue();
+    return withTopology(argv[0].xmlValue(), [index, &attribute](const EdgeTopology& topology) {
+        return nodeAttribute(topology.getServer(index), attribute);
+    });
+}
+
+Define_NED_Function2(nedTopologyServer, "any topologyServer(xml topology, int index, string attribute)", "lasp",
+        "Attribute (id, port, address, netmask, x, y, z, computeCapacity, storageCapacity, memoryCapacity, services) of the index-th edge server");
+
+static cNedValue nedTopologyManager(cComponent *context, cNedValue argv[], int argc)
+{
+    std::string attribute = argv[1].stdstringValue();
+    return withTopology(argv[0].xmlValue(), [&attribute](const EdgeTopology& topology) {
+        return nodeAttribute(topology.getManager(), attribute);
+    });
+}
+
+Define_NED_Function2(nedTopologyManager, "any topologyManager(xml topology, string attribute)", "lasp",
+        "Attribute (port, address, netmask, x, y, z) of the LASP manager");
+
+static cNedValue nedTopologyNetworkConfig(cComponent *context, cNedValue argv[], int argc)
+{
+    return withTopology(argv[0].xmlValue(), [](const EdgeTopology& topology) {
+        return cNedValue(topology.getNetworkConfig());
+    });
+}
+
+Define_NED_Function2(nedTopologyNetworkConfig, "string topologyNetworkConfig(xml topology)", "lasp",
+        "Ipv4NetworkConfigurator configuration for the addresses of an edge topology, to be parsed with xml()");
+
+} // namespace lasp_ven_simple
@@ -0,0 +1,86 @@
+#ifndef EDGETOPOLOGY_H
+#define EDGETOPOLOGY_H
+
+#include <omnetpp.h>
+#include "utils/ServiceCatalog.h"
+#include <string>
+#include <vector>
+
+using namespace omnetpp;
+
+namespace lasp_ven_simple {
+
+struct TopologyNode {
+    int id;
+    std::string address;
+    std::string netmask;
+    int port;
+    double x; // m
+    double y;
+    double z;
+    double computeCapacity; // in GFLOPS
+    double storageCapacity; // in GB
+    double memoryCapacity; // in GB
+    ServiceMask services; // declared catalog whose footprints fit the node
+};
+
+// Addresses leased to vehicles (see NodeDirectory): the pool is split into
+// subnets of subnetNetmask whose network and broadcast addresses are skipped
+struct VehicleAddressPool {
+    std::string address; // network address of the pool
+    std::string netmask;
+    std::string subnetNetmask;
+    int port; // service port of every vehicle
+};
+
+// Edge topology descriptor, the one place that defines the LASP manager and
+// the edge servers of a scenario:
+//
+//   <topology netmask="255.255.255.0">
+//       <manager address="192.168.1.100" port="15000" x="50" y="50" z="20"/>
+//       <service name="INFOTAINMENT" cpu="2" memory="4" storage="50"/>
+//       <server id="0" address="192.168.1.200" port="8000" x="10" y="10" z="15"
+//               computeCapacity="100" storageCapacity="1000" memoryCapacity="16"
+//               services="TRAFFIC_INFO,NAVIGATION"/>
+//       <vehicles address="10.1.0.0" netmask="255.255.0.0" subnetNetmask="255.255.255.0" port="5000"/>
+//       <multicast-group hosts="*" address="224.0.0.1"/>
+//   </topology>
+//
+// Servers are indexed in document order (edgeServer[i]); id defaults to the
+// index, port to 8000 + id, capacities to 100 GFLOPS, 1000 GB storage and
+// 16 GB memory, services to all ("*"). <vehicles> defaults to the values
+// above; the manager and the servers get a route to the pool. <service> sets the footprint of one
+// instance of a service (default none); a server's catalog only keeps the
+// services whose footprint fits its capacities. Any other element is handed
+// to Ipv4NetworkConfigurator unchanged.
+//
+// The network's NodeDirectory parses the descriptor once and owns the result
+// for the run; modules and NED functions reach it through the directory.
+class EdgeTopology {
+public:
+    // Throws cRuntimeError on malformed descriptors
+    explicit EdgeTopology(const cXMLElement* document);
+
+    const TopologyNode& getManager() const { return manager; }
+    const std::vector<TopologyNode>& getServers() const { return servers; }
+    const TopologyNode& getServer(int index) const;
+    const ServiceFootprint& getFootprint(int serviceType) const { return footprints.at(serviceType); }
+    const VehicleAddressPool& getVehicles() const { return vehicles; }
+
+    // Ipv4NetworkConfigurator <config> assigning the manager and server
+    // addresses, followed by the pass-through elements
+    const std::string& getNetworkConfig() const { return networkConfig; }
+
+private:
+    TopologyNode parseNode(const cXMLElement* element, int index, const char* defaultNetmask) const;
+
+    std::vector<ServiceFootprint> footprints; // indexed by service type
+    TopologyNode manager;
+    std::vector<TopologyNode> servers;
+    VehicleAddressPool vehicles;
+    std::string networkConfig;
+};
+
+} // namespace lasp_ven_simple
+
+#endif // EDGETOPOLOGY_H
@@ -1,18 +1,24 @@
 #include "LASPManager.h"
+#include "EdgeTopology.h"
 #include "strategies/ThresholdStrategy.h"
 #include "strategies/GreedyStrategy.h"
 #include "strategies/GreedyLatencyAwareStrategy.h"
 #include "strategies/ThresholdLatencyAwareStrategy.h"
 #include "utils/ServicePlacementUtils.h"
+#include "LaspMessages_m.h"
 #include "inet/common/ModuleAccess.h"
 #include "inet/common/packet/Packet.h"
-#include "inet/applications/base/ApplicationPacket_m.h"
 #include "inet/common/TimeTag_m.h"
 #include "inet/networklayer/common/L3AddressResolver.h"
+#include "inet/networklayer/common/L3AddressTag_m.h"
+#include "inet/transportlayer/common/L4PortTag_m.h"
 #include "inet/networklayer/contract/IInterfaceTable.h"
 #include "inet/networklayer/ipv4/Ipv4InterfaceData.h"
+#include <climits>
 #include <cmath>
 #include <algorithm>
+#include <istream>
+#include <ostream>
 #include <random>
 
 using namespace omnetpp;
@@ -26,7 +32,23 @@ LASPManager::LASPManager()
 {
     localPort = 9999; // Default port
     evaluationTimer = nullptr;
-    EV_WARN << "=== LASP MANAGER CONSTRUCTOR CALLED ===" << endl;
+    livenessTimer = nullptr;
+    loadMapTimer = nullptr;
+    collapseTimer = nullptr;
+    collapseCellSize = 100;
+    collapsedRequestsDecided = 0;
+    collapsedDecisions = 0;
+    analyticNetwork = nullptr;
+    directory = nullptr;
+    instanceSlots = 1;
+    nextInstanceId = 0;
+    nextPlacementId = 0;
+    placementLatencyHistogram = LatencyHistogram(1e-3, 2, 3.6e6); // 1us resolution, values in ms
+    profiling = false;
+    findBestPlacementTime = LatencyHistogram(1e-9, 2, 10.0); // 1ns resolution
+    processServiceRequestTime = LatencyHistogram(1e-9, 2, 10.0);
+    evaluateCurrentPlacementsTime = LatencyHistogram(1e-9, 2, 10.0);
+    collapseWait = LatencyHistogram(1e-6, 2, 60.0); // 1us resolution
 }
 
 LASPManager::~LASPManager()
@@ -34,13 +56,19 @@ LASPManager::~LASPManager()
     if (evaluationTimer) {
         cancelAndDelete(evaluationTimer);
     }
+    if (livenessTimer) {
+        cancelAndDelete(livenessTimer);
+    }
+    if (loadMapTimer) {
+        cancelAndDelete(loadMapTimer);
+    }
+    if (collapseTimer) {
+        cancelAndDelete(collapseTimer);
+    }
 }
 
 void LASPManager::initialize(int stage)
 {
-    EV_WARN << "=== LASP MANAGER INITIALIZING ===" << endl;
-    EV_WARN << "Stage: " << stage << endl;
-    
     ApplicationBase::initialize(stage);
     
     if (stage == inet::INITSTAGE_LOCAL) {
@@ -48,15 +76,43 @@ void LASPManager::initialize(int stage)
         currentStrategy = par("strategy").stdstringValue();
         evaluationInterval = par("evaluationInterval").doubleValue();
         loadThreshold = par("loadThreshold").doubleValue();
-        numEdgeServers = par("numEdgeServers").intValue();
+        directory = getModuleFromPar<NodeDirectory>(par("nodeDirectoryModule"), this);
+        numEdgeServers = (int)directory->getTopology().getServers().size();
         localPort = par("localPort").intValue();
+        leaseDuration = par("leaseDuration");
+        failureTimeout = par("failureTimeout");
+        loadMapInterval = par("loadMapInterval");
+        loadMapGroup = L3AddressResolver().resolve(par("loadMapGroup"));
+        instanceSlots = par("instanceSlots").intValue();
+        if (instanceSlots < 1) {
+            throw cRuntimeError("instanceSlots must be at least 1, got %d", instanceSlots);
+        }
+        collapseWindow = par("collapseWindow");
+        collapseCellSize = par("collapseCellSize").doubleValue();
+        if (collapseWindow > SIMTIME_ZERO && collapseCellSize <= 0) {
+            throw cRuntimeError("collapseCellSize must be positive, got %g", collapseCellSize);
+        }
+        profiling = par("enableProfiling");
+        metrics.configure(par("metricsWindow").doubleValue(), par("metricsWindowBuckets").intValue());
+        analyticNetwork = findModuleFromPar<AnalyticNetwork>(par("analyticNetworkModule"), this);
+        
+        EV_INFO << "LASPManager parameters loaded:" << endl;
+        EV_INFO << "  strategy: " << currentStrategy << endl;
+        EV_INFO << "  evaluationInterval: " << evaluationInterval << endl;
+        EV_INFO << "  loadThreshold: " << loadThreshold << endl;
+        EV_INFO << "  numEdgeServers: " << numEdgeServers << endl;
+        EV_INFO << "  localPort: " << localPort << endl;
+        EV_INFO << "  leaseDuration: " << leaseDuration << endl;
+        EV_INFO << "  failureTimeout: " << failureTimeout << endl;
+        EV_INFO << "  loadMapInterval: " << loadMapInterval << endl;
+        EV_INFO << "  instanceSlots: " << instanceSlots << endl;
+        EV_INFO << "  collapseWindow: " << collapseWindow << " (" << collapseCellSize << "m cells)" << endl;
+        EV_INFO << "  network: " << (analyticNetwork ? "analytic" : "packet-level") << endl;
         
-        EV_WARN << "LASPManager parameters loaded:" << endl;
-        EV_WARN << "  strategy: " << currentStrategy << endl;
-        EV_WARN << "  evaluationInterval: " << evaluationInterval << endl;
-        EV_WARN << "  loadThreshold: " << loadThreshold << endl;
-        EV_WARN << "  numEdgeServers: " << numEdgeServers << endl;
-        EV_WARN << "  localPort: " << localPort << endl;
+        std::string traceFile = par("traceFile").stdstringValue();
+        if (!traceFile.empty()) {
+            trace.open(traceFile + "." + getFullPath() + ".trc", getId(), getFullPath());
+        }
         
         // Initialize statistics
         requestsReceived = registerSignal("requestsReceived");
@@ -69,193 +125,201 @@ void LASPManager::initialize(int stage)
         requestRejectionRate = registerSignal("requestRejectionRate");
         serviceCompletionTime = registerSignal("serviceCompletionTime");
         loadBalancingEfficiency = registerSignal("loadBalancingEfficiency");
-        
-        // Initialize statistics tracking
-        totalRequestsReceived = 0;
-        totalRequestsServed = 0;
-        
-        EV_WARN << "Statistics signals registered successfully" << endl;
-    EV_WARN << "=== LASP MANAGER INITIALIZED ===" << endl;
-    
-    // LASPManager is now starting properly via normal lifecycle
-    // No need for forced start anymore
+        windowedServerUtilization = registerSignal("windowedServerUtilization");
+        windowedLoadBalancingEfficiency = registerSignal("windowedLoadBalancingEfficiency");
+        windowedRequestSuccessRate = registerSignal("windowedRequestSuccessRate");
+        leasesGranted = registerSignal("leasesGranted");
+        serverFailures = registerSignal("serverFailures");
+        serverRecoveries = registerSignal("serverRecoveries");
+        failoverPlacementsMoved = registerSignal("failoverPlacementsMoved");
+        failoverRequestsLost = registerSignal("failoverRequestsLost");
+        failureDetectionTime = registerSignal("failureDetectionTime");
+        loadMapsSent = registerSignal("loadMapsSent");
+        instancesStarted = registerSignal("instancesStarted");
+        placementsShared = registerSignal("placementsShared");
+        activeInstances = registerSignal("activeInstances");
+        requestsCollapsed = registerSignal("requestsCollapsed");
+        collapseGroupSize = registerSignal("collapseGroupSize");
     }
 }
 
 void LASPManager::initializeEdgeServers()
 {
-    EV_WARN << "=== INITIALIZING EDGE SERVERS ===" << endl;
-    EV_WARN << "Creating " << numEdgeServers << " edge servers" << endl;
+    EV_INFO << "Creating " << numEdgeServers << " edge servers" << endl;
     
-    // Create exactly 4 edge servers at symmetric locations around the square road network
-    for (int i = 0; i < numEdgeServers; i++) {
+    // Servers, positions (same ones the edge server mobility uses), capacities and
+    // addresses all come from the node directory's topology descriptor
+    for (const TopologyNode& node : directory->getTopology().getServers()) {
         EdgeServer server;
-        server.serverId = i;
-        
-        // Position servers symmetrically at the corners of the 100m x 100m square road network
-        // Fixed symmetric layout: 4 servers at corners
-        switch (i) {
-            case 0: // Bottom-left corner (0,0)
-                server.latitude = 0.0;
-                server.longitude = 0.0;
-                break;
-            case 1: // Bottom-right corner (100,0)
-                server.latitude = 100.0;
-                server.longitude = 0.0;
-                break;
-            case 2: // Top-right corner (100,100)
-                server.latitude = 100.0;
-                server.longitude = 100.0;
-                break;
-            case 3: // Top-left corner (0,100)
-                server.latitude = 0.0;
-                server.longitude = 100.0;
-                break;
-            default:
-                // Fallback for any additional servers (shouldn't happen with 4 servers)
-                server.latitude = 50.0;
-                server.longitude = 50.0;
-                break;
-        }
-        server.computeCapacity = 100.0; // 100 GFLOPS
-        server.storageCapacity = 1000.0; // 1 TB
+        server.serverId = node.id;
+        server.latitude = node.x; // road network coordinates in meters
+        server.longitude = node.y;
+        server.computeCapacity = node.computeCapacity;
+        server.storageCapacity = node.storageCapacity;
+        server.memoryCapacity = node.memoryCapacity;
         server.currentLoad = 0.0;
+        server.memoryUsed = 0.0;
+        server.storageUsed = 0.0;
+        server.services = node.services;
         server.isActive = true;
         
-        // All servers support all services for simplicity
-        server.supportedServices = {TRAFFIC_INFO, EMERGENCY_ALERT, INFOTAINMENT, NAVIGATION};
-        
-        edgeServers[i] = server;
-        EV_WARN << "Edge server " << i << " initialized at (" 
-                << server.latitude << ", " << server.longitude << ") meters in road network" << endl;
+        edgeServers[server.serverId] = server;
+        EV_INFO << "Edge server " << server.serverId << " initialized at (" 
+                << server.latitude << ", " << server.longitude << ") meters in road network, " << node.address << ":" << node.port
+                << ", services " << formatServiceMask(server.services) << endl;
     }
     
-    EV_WARN << "=== EDGE SERVERS INITIALIZED ===" << endl;
+    // Servers never leave the map, so the index can point into it
+    serviceIndex.clear();
+    for (const auto& server : edgeServers) {
+        serviceIndex.add(&server.second, server.second.services);
+    }
 }
 
 void LASPManager::handleMessage(cMessage *msg)
 {
-    EV_WARN << "[DEBUG] LASPManager handleMessage called with: " << msg->getName() << endl;
-    
     if (msg == evaluationTimer) {
         handleEvaluationTimer();
     }
+    else if (msg == livenessTimer) {
+        checkLiveness();
+    }
+    else if (msg == loadMapTimer) {
+        sendLoadMap();
+    }
+    else if (msg == collapseTimer) {
+        handleCollapseTimer();
+    }
+    else if (msg->arrivedOn("directIn")) {
+        // Delivered by the analytic network; dropped while the manager is down
+        if (analyticNetwork && analyticNetwork->isBound(this)) {
+            socketDataArrived(&socket, check_and_cast<Packet*>(msg));
+        }
+        else {
+            delete msg;
+        }
+    }
     else {
-        EV_WARN << "[DEBUG] LASPManager processing message via socket: " << msg->getName() << endl;
         socket.processMessage(msg);
     }
 }
 
 void LASPManager::handleStartOperation(inet::LifecycleOperation* operation)
 {
-    EV_WARN << "=== LASP MANAGER STARTING ===" << endl;
-    EV_WARN << "LASPManager handleStartOperation called" << endl;
-    
-    // Application is starting
-    EV_WARN << "LASPManager starting..." << endl;
-    
     // Setup UDP socket
     socket.setOutputGate(gate("socketOut"));
     socket.bind(localPort);
     socket.setCallback(this);
+    if (analyticNetwork) {
+        analyticNetwork->bind(this, directory->getManager().address, localPort);
+    }
     
-    EV_WARN << "LASPManager socket setup complete on port " << localPort << endl;
-    EV_WARN << "[NETWORK-DEBUG] LASPManager bound to port " << localPort << " and ready to receive" << endl;
-    
-    // Debug: Check our actual IP address
-    EV_WARN << "LASPManager checking network interfaces..." << endl;
-    
-    // Check for different possible interface names
-    auto wlan = getModuleByPath("^.wlan[0]");
-    auto eth = getModuleByPath("^.eth");
-    auto ppp = getModuleByPath("^.ppp");
+    EV_INFO << "LASPManager socket setup complete on port " << localPort << endl;
     
-    if (wlan) {
-        EV_WARN << "[DEBUG-ROUTE-001] LASPManager: Found wlan interface" << endl;
-        
-        // IPv4 module is at host level, not wlan level
-        auto ipv4 = getModuleByPath("^.ipv4");
-        if (ipv4) {
-            EV_WARN << "[DEBUG-ROUTE-001] LASPManager: Found IPv4 module at host level" << endl;
-            
-            // Check routing table at host level
-            auto routingTable = getModuleByPath("^.ipv4.routingTable");
-            if (routingTable) {
-                auto iroutingTable = check_and_cast<IRoutingTable*>(routingTable);
-                EV_WARN << "[DEBUG-ROUTE-001] LASPManager: Routing table has " << iroutingTable->getNumRoutes() << " routes" << endl;
-                EV_WARN << "[NETWORK-DEBUG] LASPManager: IPv4 network stack is properly initialized!" << endl;
-    
-    // Debug: Check actual IP address assigned
+#if LASP_TRACE_LEVEL >= 2
+    // Debug: Check our actual IP address and routes
     auto interfaceTable = getModuleByPath("^.interfaceTable");
     if (interfaceTable) {
         auto iinterfaceTable = check_and_cast<IInterfaceTable*>(interfaceTable);
         for (int i = 0; i < iinterfaceTable->getNumInterfaces(); i++) {
             auto interface = iinterfaceTable->getInterface(i);
-            if (interface && strstr(interface->getInterfaceName(), "wlan") != nullptr) {
-                auto ipv4Data = interface->getProtocolData<Ipv4InterfaceData>();
-                if (ipv4Data) {
-                    EV_WARN << "[NETWORK-DEBUG] LASPManager actual IP: " << ipv4Data->getIPAddress().str() << endl;
-                }
+            auto ipv4Data = interface->getProtocolData<Ipv4InterfaceData>();
+            if (ipv4Data) {
+                EV_DEBUG << "LASPManager: " << interface->getInterfaceName() << " has IP " << ipv4Data->getIPAddress().str() << endl;
             }
         }
     } else {
-        EV_WARN << "[NETWORK-DEBUG] LASPManager: Could not find interface table" << endl;
-    }
-                for (int i = 0; i < iroutingTable->getNumRoutes(); i++) {
-                    auto route = iroutingTable->getRoute(i);
-                    if (route) {
-                        EV_WARN << "[DEBUG-ROUTE-001] LASPManager: Route " << i << ": " 
-                                << route->getDestinationAsGeneric().str() << " -> " << route->getNextHopAsGeneric().str() << endl;
-                    }
-                }
-            } else {
-                EV_WARN << "[DEBUG-ROUTE-001] LASPManager: No routing table found" << endl;
+        EV_DEBUG << "LASPManager: Could not find interface table" << endl;
+    }
+    auto routingTable = getModuleByPath("^.ipv4.routingTable");
+    if (routingTable) {
+        auto iroutingTable = check_and_cast<IRoutingTable*>(routingTable);
+        EV_DEBUG << "LASPManager: Routing table has " << iroutingTable->getNumRoutes() << " routes" << endl;
+        for (int i = 0; i < iroutingTable->getNumRoutes(); i++) {
+            auto route = iroutingTable->getRoute(i);
+            if (route) {
+                LASP_TRACE_DEBUG(trace, ROUTE, i, route->getDestinationAsGeneric().toIpv4().getInt(), route->getNextHopAsGeneric().toIpv4().getInt(), 0.0);
             }
-        } else {
-            EV_WARN << "[DEBUG-ROUTE-001] LASPManager: No IPv4 module found at host level" << endl;
-        }
-    } else if (eth) {
-        EV_WARN << "[DEBUG-ROUTE-001] LASPManager: Found eth interface" << endl;
-        auto ipv4 = eth->getSubmodule("ipv4");
-        if (ipv4) {
-            std::string address = ipv4->par("address").stdstringValue();
-            EV_WARN << "[DEBUG-ROUTE-001] LASPManager: Actual IP address: " << address << endl;
-        }
-    } else if (ppp) {
-        EV_WARN << "[DEBUG-ROUTE-001] LASPManager: Found ppp interface" << endl;
-        auto ipv4 = ppp->getSubmodule("ipv4");
-        if (ipv4) {
-            std::string address = ipv4->par("address").stdstringValue();
-            EV_WARN << "[DEBUG-ROUTE-001] LASPManager: Actual IP address: " << address << endl;
         }
     } else {
-        EV_WARN << "[DEBUG-ROUTE-001] LASPManager: No network interfaces found" << endl;
+        EV_DEBUG << "LASPManager: No routing table found" << endl;
     }
+#endif
     
     // Initialize edge servers
     initializeEdgeServers();
     
+    // Continue from the checkpoint of a warmed-up run, if there is one
+    if (auto checkpointer = findModuleFromPar<LaspCheckpointer>(par("checkpointerModule"), this)) {
+        if (checkpointer->restore(this)) {
+            EV_INFO << "LASPManager restored " << activePlacements.size() << " placements from checkpoint" << endl;
+        }
+    }
+    
     // Schedule periodic evaluation
     evaluationTimer = new cMessage("evaluationTimer");
     scheduleAt(simTime() + evaluationInterval, evaluationTimer);
     
-    EV_WARN << "Evaluation timer scheduled for " << evaluationInterval << "s" << endl;
-    EV_WARN << "=== LASP MANAGER STARTED SUCCESSFULLY ===" << endl;
+    EV_INFO << "Evaluation timer scheduled for " << evaluationInterval << "s" << endl;
+    
+    // Every server gets a full failureTimeout to send its first LoadReport
+    for (const auto& server : edgeServers) {
+        lastLoadReport[server.first] = simTime();
+    }
+    if (failureTimeout > SIMTIME_ZERO) {
+        livenessTimer = new cMessage("livenessTimer");
+        scheduleLivenessCheck();
+    }
+    
+    if (loadMapInterval > SIMTIME_ZERO) {
+        // The load map leaves through the wireless interface the vehicles listen on
+        if (!analyticNetwork) {
+            auto interfaceTable = getModuleFromPar<IInterfaceTable>(par("interfaceTableModule"), this);
+            auto interface = interfaceTable->findInterfaceByName(par("loadMapInterface").stringValue());
+            if (!interface) {
+                throw cRuntimeError("No interface %s to multicast the load map on", par("loadMapInterface").stringValue());
+            }
+            socket.setMulticastOutputInterface(interface->getInterfaceId());
+        }
+        loadMapTimer = new cMessage("loadMapTimer");
+        scheduleAt(simTime() + loadMapInterval, loadMapTimer);
+    }
+    if (collapseWindow > SIMTIME_ZERO) {
+        collapseTimer = new cMessage("collapseTimer");
+    }
 }
 
 void LASPManager::handleStopOperation(inet::LifecycleOperation* operation)
 {
     // Application is stopping
-    EV_WARN << "LASPManager stopping..." << endl;
+    EV_INFO << "LASPManager stopping..." << endl;
     
     if (evaluationTimer) {
         cancelAndDelete(evaluationTimer);
         evaluationTimer = nullptr;
     }
+    if (livenessTimer) {
+        cancelAndDelete(livenessTimer);
+        livenessTimer = nullptr;
+    }
+    if (loadMapTimer) {
+        cancelAndDelete(loadMapTimer);
+        loadMapTimer = nullptr;
+    }
+    if (collapseTimer) {
+        cancelAndDelete(collapseTimer);
+        collapseTimer = nullptr;
+    }
+    // Requests waiting for a collapsed decision are lost with the manager
+    pendingDecisions.clear();
+    collapseDeadlines.clear();
     
+    if (analyticNetwork) {
+        analyticNetwork->unbind(this);
+    }
     socket.close();
     
-    EV_WARN << "LASPManager stopped." << endl;
+    EV_INFO << "LASPManager stopped." << endl;
 }
 
 void LASPManager::handleCrashOperation(inet::LifecycleOperation* operation)
@@ -267,7 +331,25 @@ void LASPManager::handleCrashOperation(inet::LifecycleOperation* operation)
         cancelAndDelete(evaluationTimer);
         evaluationTimer = nullptr;
     }
+    if (livenessTimer) {
+        cancelAndDelete(livenessTimer);
+        livenessTimer = nullptr;
+    }
+    if (loadMapTimer) {
+        cancelAndDelete(loadMapTimer);
+        loadMapTimer = nullptr;
+    }
+    if (collapseTimer) {
+        cancelAndDelete(collapseTimer);
+        collapseTimer = nullptr;
+    }
+    // Requests waiting for a collapsed decision are lost with the manager
+    pendingDecisions.clear();
+    collapseDeadlines.clear();
     
+    if (analyticNetwork) {
+        analyticNetwork->unbind(this);
+    }
     socket.destroy();
 }
 
@@ -277,6 +359,15 @@ void LASPManager::handleMessageWhenUp(cMessage* msg)
     if (msg == evaluationTimer) {
         handleEvaluationTimer();
     }
+    else if (msg == livenessTimer) {
+        checkLiveness();
+    }
+    else if (msg == loadMapTimer) {
+        sendLoadMap();
+    }
+    else if (msg == collapseTimer) {
+        handleCollapseTimer();
+    }
     else {
         socket.processMessage(msg);
     }
@@ -292,36 +383,39 @@ void LASPManager::refreshDisplay() const
 
 void LASPManager::socketDataArrived(UdpSocket *socket, Packet *packet)
 {
-    EV_WARN << "[FLOW-2] LASPManager <- VEHICLE: Received packet at " << simTime() << endl;
-    EV_WARN << "[DEBUG] LASPManager: Packet details - Name: " << packet->getName() << ", Size: " << packet->getByteLength() << " bytes" << endl;
+    if (strcmp(packet->getName(), "LoadReport") == 0) {
+        handleLoadReport(packet);
+        delete packet;
+        return;
+    }
     
     // Extract vehicle service request from packet
     try {
-        auto payload = packet->peekData<ApplicationPacket>();
-        int vehicleId = payload->getSequenceNumber();
-        
-        EV_WARN << "[FLOW-2] LASPManager <- VEHICLE: Parsed packet from vehicle " << vehicleId << endl;
-        EV_WARN << "[DEBUG] LASPManager: Payload sequence number: " << vehicleId << ", Chunk length: " << payload->getChunkLength() << endl;
+        auto payload = packet->peekData<ServiceRequestMessage>();
+        int vehicleId = payload->getVehicleId();
         
         // Create service request from received packet
-        ServiceRequest request;
-        request.vehicleId = vehicleId;
-        request.serviceType = TRAFFIC_INFO; // Could be extracted from packet in future
-        request.timestamp = simTime().dbl();
-        request.latitude = 52.5200; // Could be extracted from vehicle position
-        request.longitude = 13.4050;
-        request.priority = 1;
-        request.deadline = simTime().dbl() + 10.0; // 10 seconds deadline
-        request.dataSize = 1.0; // 1 MB
+        ServiceRequest request = ServicePlacementUtils::makeRequest(vehicleId, payload->getRequestId(),
+                static_cast<ServiceType>(payload->getServiceType()), simTime().dbl(), 1.0,
+                payload->getExcludeServerId(), payload->getHedged());
+        
+        LASP_TRACE(trace, REQUEST_RECEIVED, vehicleId, request.requestId, request.serviceType, 0.0);
         
-        EV_WARN << "[FLOW-2] LASPManager <- VEHICLE: Request from vehicle " << vehicleId << " processed" << endl;
+        // Remember where the request came from so a placement lease can be returned
+        L3Address vehicleAddr = packet->getTag<L3AddressInd>()->getSrcAddress();
+        int vehiclePort = packet->getTag<L4PortInd>()->getSrcPort();
         
         emit(requestsReceived, 1);
-        processServiceRequest(request);
+        // Hedged duplicates must avoid a server of their own, so they are never collapsed
+        if (collapseTimer && !request.hedged && request.excludeServerId < 0) {
+            collapseRequest(request, payload->getPositionX(), payload->getPositionY(), vehicleAddr, vehiclePort);
+        }
+        else {
+            processServiceRequest(request, vehicleAddr, vehiclePort);
+        }
         
     } catch (const std::exception& e) {
-        EV_WARN << "[FLOW-2] LASPManager <- VEHICLE: Failed to parse packet: " << e.what() << endl;
-        EV_WARN << "[DEBUG] LASPManager: Packet class: " << packet->getClassName() << endl;
+        EV_WARN << "[FLOW-2] LASPManager <- VEHICLE: Failed to parse " << packet->getClassName() << " " << packet->getName() << ": " << e.what() << endl;
     }
     
     delete packet;
@@ -338,148 +432,325 @@ void LASPManager::socketClosed(UdpSocket *socket)
     EV_WARN << "UDP socket closed" << endl;
 }
 
-void LASPManager::processServiceRequest(const ServiceRequest& request)
+void LASPManager::sendPacket(Packet* packet, const L3Address& destAddr, int destPort)
 {
-    totalRequestsReceived++; // Track total requests received
-    
-    EV_WARN << "[FLOW-3] LASPManager -> EDGESERVER: Processing request from vehicle " << request.vehicleId << endl;
+    if (analyticNetwork) {
+        analyticNetwork->sendTo(this, packet, destAddr, destPort);
+    }
+    else {
+        socket.sendTo(packet, destAddr, destPort);
+    }
+}
+
+void LASPManager::processServiceRequest(const ServiceRequest& request, const L3Address& vehicleAddr, int vehiclePort)
+{
+    ScopedTimer timer(profiling ? &processServiceRequestTime : nullptr);
     
-    ServicePlacement* placement = findBestPlacement(request);
-    if (placement) {
-        EV_WARN << "[FLOW-3] LASPManager -> EDGESERVER: Found placement on server " << placement->serverId << " (latency: " << placement->estimatedLatency << "ms)" << endl;
-        
-        activePlacements.push_back(*placement);
-        totalRequestsServed++; // Track successful requests
-        emit(requestsServed, 1);
-        emit(averageLatency, placement->estimatedLatency);
-        
-        // Calculate service completion time (estimated)
-        double completionTime = placement->estimatedLatency / 1000.0; // Convert ms to seconds
-        emit(serviceCompletionTime, completionTime);
-        
-        // Log QoS metrics to console
-        EV_WARN << "[QOS] Average latency: " << placement->estimatedLatency << "ms" << endl;
-        EV_WARN << "[QOS] Service completion time: " << completionTime << "s" << endl;
+    ServicePlacement placement;
+    bool found = findBestPlacement(request, placement);
+    metrics.recordRequest(simTime().dbl(), found);
+    if (found) {
+        bool newInstance = servePlacement(request, placement, vehicleAddr, vehiclePort);
         
         // Send deployment command to selected edge server
-        EV_WARN << "[FLOW-3] LASPManager -> EDGESERVER: Sending deployment command to server " << placement->serverId << endl;
-        sendDeploymentCommand(*placement, request);
+        sendDeploymentCommand(placement, request, newInstance);
         
-        EV_WARN << "[FLOW-3] LASPManager -> EDGESERVER: Deployment command sent to server " << placement->serverId << endl;
+        // Hand the decision to the vehicle so it can bypass the manager while the lease lasts
+        if (leaseDuration > SIMTIME_ZERO && !request.hedged && !vehicleAddr.isUnspecified()) {
+            sendPlacementLease(placement, request, vehicleAddr, vehiclePort);
+        }
     }
     else {
-        EV_WARN << "[FLOW-3] LASPManager -> EDGESERVER: No suitable server found for vehicle " << request.vehicleId << endl;
+        LASP_TRACE(trace, PLACEMENT_FAILED, request.vehicleId, request.requestId, request.serviceType, 0.0);
         // Track rejected requests
         emit(requestRejectionRate, 1);
     }
 }
 
-ServicePlacement* LASPManager::findBestPlacement(const ServiceRequest& request)
+bool LASPManager::servePlacement(const ServiceRequest& request, ServicePlacement& placement, const L3Address& vehicleAddr, int vehiclePort,
+        int instanceId)
+{
+    LASP_TRACE(trace, PLACEMENT_FOUND, request.vehicleId, request.requestId, placement.serverId, placement.estimatedLatency);
+    
+    placement.serviceId = request.vehicleId;
+    placement.requestId = request.requestId;
+    placement.dataSize = request.dataSize;
+    placement.expiryTime = request.deadline;
+    if (!request.hedged) {
+        placement.vehicleAddress = vehicleAddr;
+        placement.vehiclePort = vehiclePort;
+        // The vehicle may keep using the server for as long as its lease lasts
+        if (leaseDuration > SIMTIME_ZERO && !vehicleAddr.isUnspecified()) {
+            placement.expiryTime = std::max(placement.expiryTime, simTime().dbl() + leaseDuration.dbl());
+        }
+    }
+    bool newInstance = addPlacement(placement, instanceId);
+    emit(requestsServed, 1);
+    emit(averageLatency, placement.estimatedLatency);
+    placementLatencyHistogram.record(placement.estimatedLatency);
+    
+    // Calculate service completion time (estimated)
+    double completionTime = placement.estimatedLatency / 1000.0; // Convert ms to seconds
+    emit(serviceCompletionTime, completionTime);
+    return newInstance;
+}
+
+void LASPManager::collapseRequest(const ServiceRequest& request, double x, double y, const L3Address& vehicleAddr, int vehiclePort)
+{
+    CollapseKey key((int)request.serviceType, (int)std::floor(x / collapseCellSize), (int)std::floor(y / collapseCellSize));
+    std::vector<CollapsedRequest>& waiters = pendingDecisions[key];
+    if (waiters.empty()) {
+        // The first request of the cell opens the window
+        collapseDeadlines.push_back(std::make_pair(simTime() + collapseWindow, key));
+        if (!collapseTimer->isScheduled()) {
+            scheduleAt(collapseDeadlines.front().first, collapseTimer);
+        }
+    }
+    else {
+        LASP_TRACE(trace, REQUEST_COLLAPSED, request.vehicleId, request.requestId, waiters.front().request.vehicleId, 0.0);
+        emit(requestsCollapsed, 1);
+    }
+    waiters.push_back(CollapsedRequest{request, vehicleAddr, vehiclePort});
+}
+
+void LASPManager::handleCollapseTimer()
+{
+    // All windows have the same length, so they close in the order they opened
+    simtime_t now = simTime();
+    while (!collapseDeadlines.empty() && collapseDeadlines.front().first <= now) {
+        auto it = pendingDecisions.find(collapseDeadlines.front().second);
+        collapseDeadlines.pop_front();
+        std::vector<CollapsedRequest> waiters = std::move(it->second);
+        pendingDecisions.erase(it);
+        decideCollapsed(waiters);
+    }
+    if (!collapseDeadlines.empty()) {
+        scheduleAt(collapseDeadlines.front().first, collapseTimer);
+    }
+}
+
+void LASPManager::decideCollapsed(const std::vector<CollapsedRequest>& waiters)
+{
+    ScopedTimer timer(profiling ? &processServiceRequestTime : nullptr);
+    
+    // The first request stands for the group; its decision is fanned out to every waiter
+    const ServiceRequest& leader = waiters.front().request;
+    ServicePlacement decision;
+    bool found = findBestPlacement(leader, decision);
+    collapsedDecisions++;
+    collapsedRequestsDecided += waiters.size();
+    emit(collapseGroupSize, (long)waiters.size());
+    
+    // Collapsing costs every request the rest of the window, a lone one all of it
+    double now = simTime().dbl();
+    for (const CollapsedRequest& waiter : waiters) {
+        collapseWait.record(now - waiter.request.timestamp);
+    }
+    if (!found) {
+        for (const CollapsedRequest& waiter : waiters) {
+            metrics.recordRequest(now, false);
+            LASP_TRACE(trace, PLACEMENT_FAILED, waiter.request.vehicleId, waiter.request.requestId, waiter.request.serviceType, 0.0);
+            emit(requestRejectionRate, 1);
+        }
+        return;
+    }
+    
+    // Every waiter gets a placement of its own on the decided server, all bound
+    // to the leader's instance: the server gets one deployment command for the
+    // group and adds load once, so the group is charged once here as well
+    ServicePlacement leaderPlacement = decision;
+    metrics.recordRequest(now, true);
+    bool newInstance = servePlacement(leader, leaderPlacement, waiters.front().vehicleAddr, waiters.front().vehiclePort);
+    for (size_t i = 1; i < waiters.size(); i++) {
+        metrics.recordRequest(now, true);
+        ServicePlacement placement = decision;
+        servePlacement(waiters[i].request, placement, waiters[i].vehicleAddr, waiters[i].vehiclePort, leaderPlacement.instanceId);
+    }
+    sendDeploymentCommand(leaderPlacement, leader, newInstance, &waiters);
+    
+    if (leaseDuration > SIMTIME_ZERO) {
+        for (const CollapsedRequest& waiter : waiters) {
+            if (!waiter.vehicleAddr.isUnspecified()) {
+                sendPlacementLease(decision, waiter.request, waiter.vehicleAddr, waiter.vehiclePort);
+            }
+        }
+    }
+}
+
+bool LASPManager::findBestPlacement(const ServiceRequest& request, ServicePlacement& placement)
+{
+    ScopedTimer timer(profiling ? &findBestPlacementTime : nullptr);
+    // Servers running the service with a free slot take the request without
+    // starting an instance, unless the strategy turns all of them down
+    if (instanceSlots > 1) {
+        sharedCandidates.clear();
+        for (auto it = openInstances.lower_bound(std::make_pair((int)request.serviceType, INT_MIN));
+                it != openInstances.end() && it->first.first == request.serviceType; ++it) {
+            sharedCandidates.push_back(&edgeServers.at(it->first.second));
+        }
+        if (!sharedCandidates.empty() && placeOn(request, sharedCandidates, ServiceFootprint{0.0, 0.0, 0.0}, placement)) {
+            return true;
+        }
+    }
+    // Only the servers hosting the service are candidates
+    return placeOn(request, serviceIndex.getServers(request.serviceType), directory->getTopology().getFootprint(request.serviceType),
+            placement);
+}
+
+bool LASPManager::placeOn(const ServiceRequest& request, const std::vector<const EdgeServer*>& candidates,
+        const ServiceFootprint& footprint, ServicePlacement& placement)
 {
     if (currentStrategy == "threshold") {
-        return ThresholdStrategy::placeService(request, edgeServers, loadThreshold);
+        return ThresholdStrategy::placeService(request, candidates, footprint, placement, loadThreshold);
     }
     else if (currentStrategy == "greedy") {
-        return GreedyStrategy::placeService(request, edgeServers);
+        return GreedyStrategy::placeService(request, candidates, footprint, placement);
     }
     else if (currentStrategy == "greedyLatencyAware") {
         double loadWeight = par("loadWeight").doubleValue();
         double latencyWeight = par("latencyWeight").doubleValue();
-        return GreedyLatencyAwareStrategy::placeService(request, edgeServers, loadWeight, latencyWeight);
+        return GreedyLatencyAwareStrategy::placeService(request, candidates, footprint, placement, scoredServers, loadWeight, latencyWeight);
     }
     else if (currentStrategy == "thresholdLatencyAware") {
         double loadWeight = par("loadWeight").doubleValue();
         double latencyWeight = par("latencyWeight").doubleValue();
-        return ThresholdLatencyAwareStrategy::placeService(request, edgeServers, loadThreshold, loadWeight, latencyWeight);
+        return ThresholdLatencyAwareStrategy::placeService(request, candidates, footprint, placement, loadThreshold, loadWeight, latencyWeight);
     }
     else {
         EV_ERROR << "Unknown strategy: " << currentStrategy << endl;
-        return nullptr;
+        return false;
     }
 }
 
-void LASPManager::updateServerLoad()
+bool LASPManager::addPlacement(ServicePlacement& placement, int instanceId)
 {
-    // Update server loads based on active placements
-    for (auto& server : edgeServers) {
-        server.second.currentLoad = 0.0;
+    auto key = std::make_pair((int)placement.serviceType, placement.serverId);
+    bool newInstance = false;
+    if (instanceId < 0) {
+        // Join an instance of the service with a free slot on the server, or start one
+        std::vector<int>& open = openInstances[key];
+        newInstance = open.empty();
+        if (newInstance) {
+            // The instance holds its service footprint on the server while it runs
+            const ServiceFootprint& footprint = directory->getTopology().getFootprint(placement.serviceType);
+            EdgeServer& server = edgeServers.at(placement.serverId);
+            server.memoryUsed += footprint.memory;
+            server.storageUsed += footprint.storage;
+            ServiceInstance& instance = serviceInstances[nextInstanceId];
+            instance.serverId = placement.serverId;
+            instance.serviceType = placement.serviceType;
+            instance.refCount = 0;
+            instance.resourceUsage = placement.resourceUsage + footprint.cpu;
+            placedLoad[placement.serverId] += instance.resourceUsage;
+            open.push_back(nextInstanceId++);
+            emit(instancesStarted, 1);
+        }
+        instanceId = open.back();
+    }
+    if (!newInstance) {
+        emit(placementsShared, 1);
+    }
+    placement.instanceId = instanceId;
+    ServiceInstance& instance = serviceInstances.at(instanceId);
+    if (++instance.refCount == instanceSlots) {
+        // Full; a named instance may be filled beyond its slots and stays out of the list
+        std::vector<int>& open = openInstances[key];
+        open.erase(std::remove(open.begin(), open.end(), instanceId), open.end());
+        if (open.empty()) {
+            openInstances.erase(key);
+        }
     }
     
-    for (const auto& placement : activePlacements) {
-        if (edgeServers.find(placement.serverId) != edgeServers.end()) {
-            edgeServers[placement.serverId].currentLoad += placement.resourceUsage;
+    placementExpiry.insert(std::make_pair(placement.expiryTime, nextPlacementId));
+    activePlacements[nextPlacementId++] = placement;
+    return newInstance;
+}
+
+void LASPManager::releaseInstance(int instanceId)
+{
+    auto it = serviceInstances.find(instanceId);
+    if (it == serviceInstances.end()) {
+        return;
+    }
+    ServiceInstance& instance = it->second;
+    auto key = std::make_pair((int)instance.serviceType, instance.serverId);
+    if (instance.refCount-- == instanceSlots) {
+        // Full until now, so it takes placements again
+        openInstances[key].push_back(instanceId);
+    }
+    if (instance.refCount > 0) {
+        return;
+    }
+    // The last placement is gone: stop the instance and give its load and footprint back
+    std::vector<int>& open = openInstances[key];
+    open.erase(std::remove(open.begin(), open.end(), instanceId), open.end());
+    if (open.empty()) {
+        openInstances.erase(key);
+    }
+    const ServiceFootprint& footprint = directory->getTopology().getFootprint(instance.serviceType);
+    EdgeServer& server = edgeServers.at(instance.serverId);
+    server.memoryUsed -= footprint.memory;
+    server.storageUsed -= footprint.storage;
+    placedLoad[instance.serverId] -= instance.resourceUsage;
+    serviceInstances.erase(it);
+}
+
+std::map<long, ServicePlacement>::iterator LASPManager::removePlacement(std::map<long, ServicePlacement>::iterator it)
+{
+    releaseInstance(it->second.instanceId);
+    return activePlacements.erase(it);
+}
+
+void LASPManager::expirePlacements(double now)
+{
+    // A placement is over once its request's deadline and the vehicle's lease
+    // have passed; only the expired entries of the index are visited, and those
+    // of placements failover already took out are dropped
+    while (!placementExpiry.empty() && placementExpiry.begin()->first <= now) {
+        auto it = activePlacements.find(placementExpiry.begin()->second);
+        placementExpiry.erase(placementExpiry.begin());
+        if (it != activePlacements.end()) {
+            removePlacement(it);
         }
     }
 }
 
+void LASPManager::updateServerLoad()
+{
+    // Publish the loads of the active placements, kept per server as placements come and go
+    for (auto& server : edgeServers) {
+        auto it = placedLoad.find(server.first);
+        server.second.currentLoad = it != placedLoad.end() ? it->second : 0.0;
+        metrics.setServerUtilization(server.first, server.second.currentLoad / server.second.computeCapacity);
+    }
+}
+
 void LASPManager::evaluateCurrentPlacements()
 {
+    ScopedTimer timer(profiling ? &evaluateCurrentPlacementsTime : nullptr);
+    expirePlacements(simTime().dbl());
     updateServerLoad();
+    double now = simTime().dbl();
+    metrics.sampleServers(now);
     
-    // Calculate average server utilization
-    double totalUtilization = 0.0;
-    std::vector<double> utilizations;
-    for (const auto& server : edgeServers) {
-        double utilization = server.second.currentLoad / server.second.computeCapacity;
-        totalUtilization += utilization;
-        utilizations.push_back(utilization);
-    }
-    double avgUtilization = totalUtilization / edgeServers.size();
+    double avgUtilization = metrics.getUtilization();
     emit(serverUtilization, avgUtilization);
+    emit(windowedServerUtilization, metrics.getWindowedUtilization(now));
+    emit(activeInstances, (long)serviceInstances.size());
     
-    // Calculate load balancing efficiency (standard deviation of utilizations)
-    if (utilizations.size() > 1) {
-        double variance = 0.0;
-        for (double util : utilizations) {
-            variance += (util - avgUtilization) * (util - avgUtilization);
-        }
-        variance /= utilizations.size();
-        double loadBalanceEfficiency = 1.0 - std::sqrt(variance); // Higher is better (less variance)
-        emit(loadBalancingEfficiency, loadBalanceEfficiency);
-    }
-    
-    // Calculate success rate based on total requests vs served requests
-    static int totalRequests = 0;
-    static int servedRequests = 0;
-    totalRequests++; // Increment for each evaluation cycle
-    
-    if (!activePlacements.empty()) {
-        servedRequests = activePlacements.size();
-        double successRate = (double)servedRequests / totalRequests;
-        emit(requestSuccessRate, successRate);
-    }
-    
-    // Reduced frequency logging to save tokens
-    static int utilizationLogCounter = 0;
-    if (++utilizationLogCounter % 20 == 0) {  // Log every 20th evaluation
-        EV_WARN << "[UTIL] Server utilization: " << (avgUtilization * 100) << "%" << endl;
-        if (utilizations.size() > 1) {
-            double variance = 0.0;
-            for (double util : utilizations) {
-                variance += (util - avgUtilization) * (util - avgUtilization);
-            }
-            variance /= utilizations.size();
-            double loadBalanceEfficiency = 1.0 - std::sqrt(variance);
-            EV_WARN << "[QOS] Load balancing efficiency: " << (loadBalanceEfficiency * 100) << "%" << endl;
-        }
-        if (!activePlacements.empty()) {
-            double successRate = (double)servedRequests / totalRequests;
-            EV_WARN << "[QOS] Request success rate: " << (successRate * 100) << "%" << endl;
-            
-            // Calculate average latency and completion time from active placements
-            double totalLatency = 0.0;
-            double totalCompletionTime = 0.0;
-            for (const auto& placement : activePlacements) {
-                totalLatency += placement.estimatedLatency;
-                totalCompletionTime += placement.estimatedLatency / 1000.0;
-            }
-            double avgLatency = totalLatency / activePlacements.size();
-            double avgCompletionTime = totalCompletionTime / activePlacements.size();
-            
-            EV_WARN << "[QOS] Average latency: " << avgLatency << "ms" << endl;
-            EV_WARN << "[QOS] Service completion time: " << avgCompletionTime << "s" << endl;
-        }
+    // Load balancing efficiency: 1 - standard deviation of the utilizations (higher is better)
+    if (metrics.getNumServers() > 1) {
+        emit(loadBalancingEfficiency, metrics.getLoadBalancingEfficiency());
+        emit(windowedLoadBalancingEfficiency, metrics.getWindowedLoadBalancingEfficiency(now));
     }
+    
+    // Served over received requests, since the start and over the last metricsWindow
+    if (metrics.getRequestsReceived() > 0) {
+        emit(requestSuccessRate, metrics.getSuccessRate());
+        emit(windowedRequestSuccessRate, metrics.getWindowedSuccessRate(now));
+    }
+    
+    LASP_TRACE(trace, EVALUATION, 0, (int64_t)activePlacements.size(), 0, avgUtilization);
 }
 
 void LASPManager::handleEvaluationTimer()
@@ -490,140 +761,346 @@ void LASPManager::handleEvaluationTimer()
     scheduleAt(simTime() + evaluationInterval, evaluationTimer);
 }
 
-ServicePlacement* LASPManager::thresholdBasedPlacement(const ServiceRequest& request)
+void LASPManager::handleLoadReport(Packet* packet)
 {
-    return ThresholdStrategy::placeService(request, edgeServers, loadThreshold);
+    auto report = packet->peekData<LoadReport>();
+    int serverId = report->getServerId();
+    auto it = edgeServers.find(serverId);
+    if (it == edgeServers.end()) {
+        EV_WARN << "[FAILOVER] LoadReport from unknown edge server " << serverId << endl;
+        return;
+    }
+    
+    simtime_t now = simTime();
+    simtime_t previousReport = lastLoadReport[serverId];
+    lastLoadReport[serverId] = now;
+    reportedUtilization[serverId] = report->getUtilization();
+    if (!it->second.isActive) {
+        // A restarted (or wrongly suspected) server takes new placements again
+        it->second.isActive = true;
+        emit(serverRecoveries, 1);
+        LASP_TRACE(trace, SERVER_RECOVERED, serverId, 0, 0, (now - previousReport).dbl());
+        EV_WARN << "[FAILOVER] Edge server " << serverId << " is back after " << (now - previousReport) << "s" << endl;
+        if (livenessTimer) {
+            scheduleLivenessCheck();
+        }
+    }
 }
 
-ServicePlacement* LASPManager::greedyPlacement(const ServiceRequest& request)
+void LASPManager::scheduleLivenessCheck()
 {
-    return GreedyStrategy::placeService(request, edgeServers);
+    // Earliest time an active server would have been silent for failureTimeout
+    simtime_t next = SIMTIME_MAX;
+    for (const auto& server : edgeServers) {
+        if (server.second.isActive) {
+            next = std::min(next, lastLoadReport[server.first] + failureTimeout);
+        }
+    }
+    cancelEvent(livenessTimer);
+    if (next != SIMTIME_MAX) {
+        scheduleAt(next, livenessTimer);
+    }
 }
 
-bool LASPManager::canServerHandleRequest(const EdgeServer& server, const ServiceRequest& request)
+void LASPManager::checkLiveness()
 {
-    // Check if server supports the service type
-    bool supportsService = false;
-    for (ServiceType service : server.supportedServices) {
-        if (service == request.serviceType) {
-            supportsService = true;
-            break;
+    simtime_t now = simTime();
+    for (const auto& server : edgeServers) {
+        if (server.second.isActive && now - lastLoadReport[server.first] >= failureTimeout) {
+            handleServerFailure(server.first);
         }
     }
+    scheduleLivenessCheck();
+}
+
+void LASPManager::handleServerFailure(int serverId)
+{
+    edgeServers[serverId].isActive = false;
+    simtime_t silence = simTime() - lastLoadReport[serverId];
+    
+    // Take the failed server's placements out; releasing them stops its instances
+    std::vector<ServicePlacement> displaced;
+    for (auto it = activePlacements.begin(); it != activePlacements.end();) {
+        if (it->second.serverId == serverId) {
+            displaced.push_back(it->second);
+            it = removePlacement(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    placedLoad.erase(serverId);
+    
+    EV_WARN << "[FAILOVER] Edge server " << serverId << " silent for " << silence << "s, declared failed; moving "
+            << displaced.size() << " placements" << endl;
+    emit(serverFailures, 1);
+    LASP_TRACE(trace, SERVER_FAILED, serverId, (int64_t)displaced.size(), 0, silence.dbl());
     
-    if (!supportsService) return false;
+    replacePlacements(displaced, serverId);
     
-    // Check if server has capacity
-    double requiredCapacity = request.dataSize * 0.1; // Simple capacity calculation
-    return (server.currentLoad + requiredCapacity) <= server.computeCapacity;
+    // Time from the last sign of life until the failure was noticed; the
+    // manager does not see when the moved placements answer again
+    emit(failureDetectionTime, silence);
 }
 
-void LASPManager::submitServiceRequest(const ServiceRequest& request)
+void LASPManager::replacePlacements(const std::vector<ServicePlacement>& displaced, int failedServerId)
 {
-    pendingRequests.push_back(request);
-    processServiceRequest(request);
+    // The whole batch is scored against survivor loads brought up to date once
+    // and then advanced by every move, so the batch spreads over the survivors
+    // instead of piling onto whichever server looked best before the first move
+    updateServerLoad();
+    double now = simTime().dbl();
+    for (const ServicePlacement& previous : displaced) {
+        ServiceRequest request = ServicePlacementUtils::makeRequest(previous.serviceId, previous.requestId,
+                previous.serviceType, now, previous.dataSize, failedServerId);
+        
+        ServicePlacement placement;
+        if (!findBestPlacement(request, placement)) {
+            LASP_TRACE(trace, PLACEMENT_FAILED, request.vehicleId, request.requestId, request.serviceType, 0.0);
+            emit(failoverRequestsLost, 1);
+            continue;
+        }
+        placement.requestId = previous.requestId;
+        placement.dataSize = previous.dataSize;
+        placement.vehicleAddress = previous.vehicleAddress;
+        placement.vehiclePort = previous.vehiclePort;
+        placement.expiryTime = previous.expiryTime;
+        bool newInstance = addPlacement(placement);
+        edgeServers[placement.serverId].currentLoad = placedLoad[placement.serverId];
+        
+        LASP_TRACE(trace, PLACEMENT_MOVED, request.vehicleId, request.requestId, placement.serverId, placement.estimatedLatency);
+        emit(failoverPlacementsMoved, 1);
+        sendDeploymentCommand(placement, request, newInstance);
+        // Point the vehicle at the new server, its lease on the failed one is useless
+        if (leaseDuration > SIMTIME_ZERO && !placement.vehicleAddress.isUnspecified()) {
+            sendPlacementLease(placement, request, placement.vehicleAddress, placement.vehiclePort);
+        }
+    }
+    updateServerLoad();
 }
 
-void LASPManager::removeServiceRequest(int requestId)
+void LASPManager::sendLoadMap()
 {
-    // Remove from pending requests
-    pendingRequests.erase(
-        std::remove_if(pendingRequests.begin(), pendingRequests.end(),
-            [requestId](const ServiceRequest& req) { return req.vehicleId == requestId; }),
-        pendingRequests.end()
-    );
+    // Active servers only, by topology index: 2 bytes of index and 4 of utilization each
+    const std::vector<TopologyNode>& servers = directory->getTopology().getServers();
+    size_t numEntries = 0;
+    for (const auto& server : edgeServers) {
+        numEntries += server.second.isActive ? 1 : 0;
+    }
+    auto loadMap = makeShared<LoadMap>();
+    loadMap->setServerIndexArraySize(numEntries);
+    loadMap->setUtilizationArraySize(numEntries);
+    size_t entry = 0;
+    for (size_t i = 0; i < servers.size(); i++) {
+        if (!edgeServers.at(servers[i].id).isActive) {
+            continue;
+        }
+        auto it = reportedUtilization.find(servers[i].id);
+        loadMap->setServerIndex(entry, (uint16_t)i);
+        loadMap->setUtilization(entry, it != reportedUtilization.end() ? (float)it->second : 0.0f);
+        entry++;
+    }
+    loadMap->setChunkLength(B(4 + 6 * numEntries));
+    auto packet = new Packet("LoadMap");
+    packet->insertAtBack(loadMap);
     
-    // Remove from active placements
-    activePlacements.erase(
-        std::remove_if(activePlacements.begin(), activePlacements.end(),
-            [requestId](const ServicePlacement& placement) { return placement.serviceId == requestId; }),
-        activePlacements.end()
-    );
+    if (analyticNetwork) {
+        analyticNetwork->sendToGroup(this, packet, loadMapGroup, directory->getVehiclePort());
+    }
+    else {
+        socket.sendTo(packet, loadMapGroup, directory->getVehiclePort());
+    }
+    emit(loadMapsSent, 1);
+    
+    scheduleAt(simTime() + loadMapInterval, loadMapTimer);
 }
 
-void LASPManager::sendDeploymentCommand(const ServicePlacement& placement, const ServiceRequest& request)
+void LASPManager::sendDeploymentCommand(const ServicePlacement& placement, const ServiceRequest& request, bool newInstance,
+        const std::vector<CollapsedRequest>* collapsed)
 {
-    EV_WARN << "=== SENDING DEPLOYMENT COMMAND ===" << endl;
-    EV_WARN << "Sending deployment command to EdgeServer " << placement.serverId 
-            << " for vehicle " << request.vehicleId << endl;
-    
-    // Create deployment command packet
-    auto packet = new Packet("ServiceDeployment");
-    auto payload = makeShared<ApplicationPacket>();
-    payload->setChunkLength(B(150)); // 150 bytes
-    payload->setSequenceNumber(request.vehicleId);
+    // Create deployment command packet; a placement joining a running instance
+    // only binds the vehicle to it, which carries no service image
+    auto packet = new Packet(newInstance ? "ServiceDeployment" : "InstanceBinding");
+    auto payload = makeShared<ServiceDeploymentMessage>();
+    // 150 bytes, 24 for a binding, plus 12 for every other waiter of a collapsed decision
+    size_t numCollapsed = collapsed ? collapsed->size() - 1 : 0;
+    payload->setChunkLength(B((newInstance ? 150 : 24) + 12 * numCollapsed));
+    payload->setVehicleId(request.vehicleId);
+    payload->setRequestId(request.requestId);
+    payload->setServiceType(request.serviceType);
+    payload->setInstanceId(placement.instanceId);
+    payload->setCollapsedVehicleIdArraySize(numCollapsed);
+    payload->setCollapsedRequestIdArraySize(numCollapsed);
+    for (size_t i = 0; i < numCollapsed; i++) {
+        payload->setCollapsedVehicleId(i, (*collapsed)[i + 1].request.vehicleId);
+        payload->setCollapsedRequestId(i, (*collapsed)[i + 1].request.requestId);
+    }
     packet->insertAtBack(payload);
     
     // Add placement information as tags (in real implementation, would use proper message format)
     packet->addTag<CreationTimeTag>()->setCreationTime(simTime());
     
     // Send to selected edge server  
-    std::string addressStr = "192.168.1." + std::to_string(200 + placement.serverId);
-    L3Address edgeServerAddress = L3AddressResolver().resolve(addressStr.c_str());
-    int edgeServerPort = 8000 + placement.serverId; // Each server has unique port
-    
-    EV_WARN << "EdgeServer address: " << edgeServerAddress.str() << ":" << edgeServerPort << endl;
+    L3Address edgeServerAddress = resolveEdgeServerAddress(placement.serverId);
+    int edgeServerPort = getEdgeServerPort(placement.serverId);
     
-    socket.sendTo(packet, edgeServerAddress, edgeServerPort);
-    
-    EV_WARN << "Deployment command sent successfully" << endl;
-    EV_WARN << "=== DEPLOYMENT COMMAND SENT ===" << endl;
+    sendPacket(packet, edgeServerAddress, edgeServerPort);
+    LASP_TRACE(trace, DEPLOYMENT_SENT, request.vehicleId, request.requestId, placement.serverId, 0.0);
 }
 
-void LASPManager::finish()
+L3Address LASPManager::resolveEdgeServerAddress(int serverId)
 {
-    ApplicationBase::finish();
+    return directory->getEdgeServer(serverId).address;
+}
+
+int LASPManager::getEdgeServerPort(int serverId) const
+{
+    return directory->getEdgeServer(serverId).port;
+}
+
+void LASPManager::sendPlacementLease(const ServicePlacement& placement, const ServiceRequest& request, const L3Address& vehicleAddr, int vehiclePort)
+{
+    auto packet = new Packet("PlacementLease");
+    auto lease = makeShared<PlacementLease>();
+    lease->setChunkLength(B(24));
+    lease->setVehicleId(request.vehicleId);
+    lease->setRequestId(request.requestId);
+    lease->setServerId(placement.serverId);
+    lease->setServerAddress(resolveEdgeServerAddress(placement.serverId));
+    lease->setServerPort(getEdgeServerPort(placement.serverId));
+    lease->setLeaseTtl(leaseDuration);
+    packet->insertAtBack(lease);
     
-    // Calculate final metrics
-    double totalUtilization = 0.0;
-    std::vector<double> utilizations;
+    sendPacket(packet, vehicleAddr, vehiclePort);
+    emit(leasesGranted, 1);
+    LASP_TRACE(trace, LEASE_GRANTED, request.vehicleId, request.requestId, placement.serverId, leaseDuration.dbl());
+}
+
+void LASPManager::saveState(std::ostream& out) const
+{
+    double now = simTime().dbl();
+    out << "servers " << edgeServers.size() << "\n";
     for (const auto& server : edgeServers) {
-        double utilization = server.second.currentLoad / server.second.computeCapacity;
-        totalUtilization += utilization;
-        utilizations.push_back(utilization);
-    }
-    double avgUtilization = totalUtilization / edgeServers.size();
-    
-    // Calculate load balancing efficiency
-    double loadBalanceEfficiency = 0.0;
-    if (utilizations.size() > 1) {
-        double variance = 0.0;
-        for (double util : utilizations) {
-            variance += (util - avgUtilization) * (util - avgUtilization);
+        out << server.first << " " << server.second.isActive << "\n";
+    }
+    out << "placements " << activePlacements.size() << "\n";
+    for (const auto& entry : activePlacements) {
+        const ServicePlacement& placement = entry.second;
+        out << placement.serviceId << " " << placement.serverId << " " << placement.serviceType << " "
+            << placement.placementTime - now << " " << placement.estimatedLatency << " " << placement.resourceUsage << " "
+            << placement.requestId << " " << placement.dataSize << " " << placement.expiryTime - now << "\n";
+    }
+}
+
+void LASPManager::restoreState(std::istream& in)
+{
+    std::string label;
+    size_t count = 0;
+    in >> label >> count;
+    if (label != "servers") {
+        in.setstate(std::ios::failbit);
+        return;
+    }
+    for (size_t i = 0; i < count && in; i++) {
+        int serverId;
+        bool active;
+        in >> serverId >> active;
+        auto it = edgeServers.find(serverId);
+        if (it != edgeServers.end()) {
+            it->second.isActive = active;
         }
-        variance /= utilizations.size();
-        loadBalanceEfficiency = 1.0 - std::sqrt(variance);
     }
     
-    // Calculate success rate
-    double successRate = 0.0;
-    if (totalRequestsReceived > 0) {
-        successRate = (double)totalRequestsServed / totalRequestsReceived;
+    in >> label >> count;
+    if (label != "placements") {
+        in.setstate(std::ios::failbit);
+        return;
     }
-    
-    // Calculate average latency and completion time
-    double avgLatency = 0.0;
-    double avgCompletionTime = 0.0;
-    if (!activePlacements.empty()) {
-        double totalLatency = 0.0;
-        for (const auto& placement : activePlacements) {
-            totalLatency += placement.estimatedLatency;
+    // The checkpoint replaces whatever was placed so far; the restored
+    // placements are packed into fresh instances
+    activePlacements.clear();
+    placementExpiry.clear();
+    placedLoad.clear();
+    serviceInstances.clear();
+    openInstances.clear();
+    for (auto& server : edgeServers) {
+        server.second.memoryUsed = 0.0;
+        server.second.storageUsed = 0.0;
+    }
+    double now = simTime().dbl();
+    for (size_t i = 0; i < count && in; i++) {
+        ServicePlacement placement = ServicePlacement();
+        int serviceType;
+        double age;
+        double remaining;
+        in >> placement.serviceId >> placement.serverId >> serviceType >> age >> placement.estimatedLatency
+           >> placement.resourceUsage >> placement.requestId >> placement.dataSize >> remaining;
+        placement.serviceType = static_cast<ServiceType>(serviceType);
+        placement.placementTime = now + age;
+        placement.expiryTime = now + remaining;
+        placement.vehiclePort = -1;
+        if (in && edgeServers.count(placement.serverId)) {
+            addPlacement(placement);
         }
-        avgLatency = totalLatency / activePlacements.size();
-        avgCompletionTime = avgLatency / 1000.0; // Convert to seconds
     }
+    updateServerLoad();
+}
+
+void LASPManager::finish()
+{
+    ApplicationBase::finish();
+    
+    // Final metrics, as of the last evaluation
+    double avgUtilization = metrics.getUtilization();
+    double loadBalanceEfficiency = metrics.getNumServers() > 1 ? metrics.getLoadBalancingEfficiency() : 0.0;
+    double successRate = metrics.getSuccessRate();
+    double avgLatency = placementLatencyHistogram.getMean();
+    double avgCompletionTime = avgLatency / 1000.0; // Convert to seconds
     
     // Print final metrics summary
     EV_WARN << "=== FINAL METRICS SUMMARY ===" << endl;
     EV_WARN << "FINAL METRICS: Strategy: " << currentStrategy << endl;
-    EV_WARN << "FINAL METRICS: Total requests served: " << activePlacements.size() << endl;
+    EV_WARN << "FINAL METRICS: Total requests served: " << metrics.getRequestsServed() << endl;
+    EV_WARN << "FINAL METRICS: Placements active at the end: " << activePlacements.size() << endl;
     EV_WARN << "FINAL METRICS: Request success rate: " << (successRate * 100) << "%" << endl;
     EV_WARN << "FINAL METRICS: Load balancing efficiency: " << (loadBalanceEfficiency * 100) << "%" << endl;
     EV_WARN << "FINAL METRICS: Average server utilization: " << (avgUtilization * 100) << "%" << endl;
     EV_WARN << "FINAL METRICS: Average latency: " << avgLatency << "ms" << endl;
     EV_WARN << "FINAL METRICS: Service completion time: " << avgCompletionTime << "s" << endl;
+    EV_WARN << "FINAL METRICS: Service instances running at the end: " << serviceInstances.size() << " (" << instanceSlots << " slots each)" << endl;
+    if (collapsedDecisions > 0) {
+        EV_WARN << "FINAL METRICS: Collapse ratio: " << (double)collapsedRequestsDecided / collapsedDecisions
+                << " requests per placement decision, mean/p99 wait " << collapseWait.getMean() << "/"
+                << collapseWait.getPercentile(99) << "s" << endl;
+    }
     EV_WARN << "FINAL METRICS: Load threshold: " << (loadThreshold * 100) << "%" << endl;
+    int failedServers = 0;
+    for (const auto& server : edgeServers) {
+        failedServers += server.second.isActive ? 0 : 1;
+    }
+    EV_WARN << "FINAL METRICS: Edge servers down at the end: " << failedServers << "/" << edgeServers.size() << endl;
+    EV_WARN << "FINAL METRICS: Placement latency p50/p99/p99.9: " << placementLatencyHistogram.getPercentile(50) << "/" 
+            << placementLatencyHistogram.getPercentile(99) << "/" << placementLatencyHistogram.getPercentile(99.9) << "ms" << endl;
+    EV_WARN << "FINAL METRICS: Vehicle service latency p50/p99/p99.9: " << fleetServiceLatency.getPercentile(50) << "/" 
+            << fleetServiceLatency.getPercentile(99) << "/" << fleetServiceLatency.getPercentile(99.9) << "s" << endl;
     EV_WARN << "=== END FINAL METRICS ===" << endl;
+    
+    // Vehicles have merged their histograms by now: veinsManager precedes laspManager
+    // in the network, and deleting the TraCI hosts on its finish() finishes them first
+    placementLatencyHistogram.recordScalars(this, "averageLatency");
+    fleetServiceLatency.recordScalars(this, "fleetServiceLatency");
+    if (collapseWindow > SIMTIME_ZERO) {
+        // Requests per placement decision, 1 when nothing was collapsed
+        recordScalar("collapseRatio", collapsedDecisions > 0 ? (double)collapsedRequestsDecided / collapsedDecisions : 1.0);
+        collapseWait.recordScalars(this, "collapseWait");
+    }
+    if (profiling) {
+        findBestPlacementTime.recordScalars(this, "wallTime:findBestPlacement");
+        processServiceRequestTime.recordScalars(this, "wallTime:processServiceRequest");
+        evaluateCurrentPlacementsTime.recordScalars(this, "wallTime:evaluateCurrentPlacements");
+    }
+    
+    trace.close();
 }
 
 } // namespace lasp_ven_simple 
\ No newline at end of file
@@ -6,7 +6,17 @@
 #include "inet/common/lifecycle/ModuleOperations.h"
 #include "inet/common/lifecycle/NodeStatus.h"
 #include "inet/transportlayer/contract/udp/UdpSocket.h"
+#include "AnalyticNetwork.h"
+#include "LaspCheckpointer.h"
+#include "NodeDirectory.h"
+#include "utils/LatencyHistogram.h"
+#include "utils/MetricsEngine.h"
+#include "utils/ScopedTimer.h"
+#include "utils/ServiceCatalog.h"
+#include "utils/Trace.h"
+#include <deque>
 #include <map>
+#include <tuple>
 #include <vector>
 #include <string>
 
@@ -24,6 +34,7 @@ enum ServiceType {
 
 struct ServiceRequest {
     int vehicleId;
+    long requestId; // per-vehicle, monotonically increasing
     ServiceType serviceType;
     double timestamp;
     double latitude;
@@ -31,6 +42,8 @@ struct ServiceRequest {
     int priority;
     double deadline;
     double dataSize; // in MB
+    int excludeServerId; // server a hedged duplicate must avoid, -1 for none
+    bool hedged;
 };
 
 struct EdgeServer {
@@ -39,11 +52,22 @@ struct EdgeServer {
     double longitude;
     double computeCapacity; // in GFLOPS
     double storageCapacity; // in GB
+    double memoryCapacity; // in GB
     double currentLoad;
-    std::vector<ServiceType> supportedServices;
+    double memoryUsed;  // in GB, footprints of the running service instances
+    double storageUsed; // in GB
+    ServiceMask services; // hosted services whose footprint fits the server
     bool isActive;
 };
 
+// Server scored by a placement strategy; callers keep a scratch list of them,
+// so scoring allocates nothing once the list has grown to the candidates
+struct ScoredServer {
+    const EdgeServer* server;
+    double score;
+    double latency;
+};
+
 struct ServicePlacement {
     int serviceId;
     int serverId;
@@ -51,19 +75,47 @@ struct ServicePlacement {
     double placementTime;
     double estimatedLatency;
     double resourceUsage;
+    // Request the placement serves, kept so it can be moved when its server fails
+    long requestId;
+    double dataSize; // in MB
+    L3Address vehicleAddress; // lease destination, unspecified if the vehicle gets no leases
+    int vehiclePort;
+    int instanceId; // shared service instance the placement is bound to
+    double expiryTime; // request deadline, or end of the vehicle's lease if later
 };
 
-class LASPManager : public ApplicationBase, public UdpSocket::ICallback
+// One running copy of a service on an edge server. Up to instanceSlots
+// placements share it; the placement that starts it pays its resourceUsage
+// and the service footprint, which are given back when the last placement
+// bound to it goes away.
+struct ServiceInstance {
+    int serverId;
+    ServiceType serviceType;
+    int refCount; // placements bound to the instance
+    double resourceUsage; // placement's resourceUsage plus the footprint's cpu
+};
+
+// Request waiting for the placement decision of its collapse group
+struct CollapsedRequest {
+    ServiceRequest request;
+    L3Address vehicleAddr;
+    int vehiclePort;
+};
+
+class LASPManager : public ApplicationBase, public UdpSocket::ICallback, public ICheckpointable
 {
 private:
     // Network
     UdpSocket socket;
     int localPort;
+    AnalyticNetwork* analyticNetwork; // replaces the socket for LASP traffic if set
     
     // Edge servers management
     std::map<int, EdgeServer> edgeServers;
-    std::vector<ServiceRequest> pendingRequests;
-    std::vector<ServicePlacement> activePlacements;
+    ServiceIndex serviceIndex; // service type -> servers in edgeServers hosting it
+    std::map<long, ServicePlacement> activePlacements; // by placement id
+    std::multimap<double, long> placementExpiry;       // expiryTime -> placement id, may hold ids already removed
+    long nextPlacementId;
     
     // Strategy selection
     std::string currentStrategy;
@@ -75,23 +127,89 @@ private:
     simsignal_t averageLatency;
     simsignal_t serverUtilization;
     
+    // Latency distributions, summarized as percentile scalars at finish()
+    LatencyHistogram placementLatencyHistogram;  // estimated placement latency, ms
+    LatencyHistogram fleetServiceLatency;        // merged vehicle serviceLatency, s
+    
+    // Wall-clock cost per call of the placement hot path (enableProfiling), s
+    bool profiling;
+    LatencyHistogram findBestPlacementTime;
+    LatencyHistogram processServiceRequestTime;
+    LatencyHistogram evaluateCurrentPlacementsTime;
+    
     // QoS Metrics
     simsignal_t requestSuccessRate;
     simsignal_t requestRejectionRate;
     simsignal_t serviceCompletionTime;
     simsignal_t loadBalancingEfficiency;
+    simsignal_t windowedServerUtilization;
+    simsignal_t windowedLoadBalancingEfficiency;
+    simsignal_t windowedRequestSuccessRate;
     
     // Parameters
     double evaluationInterval;
     int numEdgeServers;
+    simtime_t leaseDuration;
     
-    // Statistics tracking
-    int totalRequestsReceived;
-    int totalRequestsServed;
+    // Placement leases
+    simsignal_t leasesGranted;
+    
+    // Failover: servers silent for failureTimeout are declared failed and
+    // their placements are moved to the surviving servers
+    simtime_t failureTimeout;
+    std::map<int, simtime_t> lastLoadReport; // serverId -> arrival of its last LoadReport
+    cMessage* livenessTimer;
+    simsignal_t serverFailures;
+    simsignal_t serverRecoveries;
+    simsignal_t failoverPlacementsMoved;
+    simsignal_t failoverRequestsLost;
+    simsignal_t failureDetectionTime;
+    
+    // Distributed placement: the reported server loads are multicast to the
+    // vehicles every loadMapInterval, and vehicles place their own requests
+    simtime_t loadMapInterval;
+    L3Address loadMapGroup;
+    std::map<int, double> reportedUtilization; // serverId -> utilization of its last LoadReport
+    cMessage* loadMapTimer;
+    simsignal_t loadMapsSent;
+    
+    // Running and windowed metrics, updated as requests and loads change
+    MetricsEngine metrics;
+    std::map<int, double> placedLoad;    // serverId -> resourceUsage of its service instances
+    
+    // Shared service instances: a placement binds to an instance of its service
+    // with a free slot on the chosen server, new instances are only started
+    // when there is none
+    int instanceSlots;
+    int nextInstanceId;
+    std::map<int, ServiceInstance> serviceInstances; // by instance id
+    std::map<std::pair<int, int>, std::vector<int>> openInstances; // (service type, serverId) -> instances with a free slot
+    std::vector<const EdgeServer*> sharedCandidates; // scratch list of findBestPlacement
+    std::vector<ScoredServer> scoredServers;         // scratch list of the greedyLatencyAware strategy
+    simsignal_t instancesStarted;
+    simsignal_t placementsShared;
+    simsignal_t activeInstances;
+    
+    // Request collapsing: requests for one service type from one spatial cell
+    // that arrive within collapseWindow of the first share its placement decision
+    typedef std::tuple<int, int, int> CollapseKey; // service type, cell x, cell y
+    simtime_t collapseWindow;
+    double collapseCellSize; // m
+    std::map<CollapseKey, std::vector<CollapsedRequest>> pendingDecisions;
+    std::deque<std::pair<simtime_t, CollapseKey>> collapseDeadlines; // oldest first
+    cMessage* collapseTimer;
+    long collapsedRequestsDecided; // requests decided through collapsing
+    long collapsedDecisions;       // placement decisions made for them
+    LatencyHistogram collapseWait; // time requests waited for their window to close, s
+    simsignal_t requestsCollapsed;
+    simsignal_t collapseGroupSize;
     
     // Timer for periodic evaluation
     cMessage* evaluationTimer;
     
+    // Binary trace of per-request events (see utils/Trace.h)
+    TraceBuffer trace;
+    
 protected:
     virtual void initialize(int stage) override;
     virtual void handleMessage(cMessage *msg) override;
@@ -109,39 +227,76 @@ protected:
     virtual void socketDataArrived(UdpSocket *socket, Packet *packet) override;
     virtual void socketErrorArrived(UdpSocket *socket, Indication *indication) override;
     virtual void socketClosed(UdpSocket *socket) override;
+    void sendPacket(Packet* packet, const L3Address& destAddr, int destPort);
     
     // Service placement methods
     void initializeEdgeServers();
-    void processServiceRequest(const ServiceRequest& request);
-    ServicePlacement* findBestPlacement(const ServiceRequest& request);
+    void processServiceRequest(const ServiceRequest& request, const L3Address& vehicleAddr = L3Address(), int vehiclePort = -1);
+    // Both return false if no server fits; placement is only written otherwise
+    bool findBestPlacement(const ServiceRequest& request, ServicePlacement& placement);
+    // footprint: resources a new instance would take, none for servers with a free slot
+    bool placeOn(const ServiceRequest& request, const std::vector<const EdgeServer*>& candidates,
+            const ServiceFootprint& footprint, ServicePlacement& placement);
     void updateServerLoad();
+    // Binds the placement to a service instance, the given one or one with a free
+    // slot; returns true if it had to start a new one
+    bool addPlacement(ServicePlacement& placement, int instanceId = -1);
+    void releaseInstance(int instanceId);
+    // Takes a placement out, releasing its instance slot
+    std::map<long, ServicePlacement>::iterator removePlacement(std::map<long, ServicePlacement>::iterator it);
+    void expirePlacements(double now);
     void evaluateCurrentPlacements();
+    // Records a found placement for the request and binds it to a service instance;
+    // returns true if it had to start a new one
+    bool servePlacement(const ServiceRequest& request, ServicePlacement& placement, const L3Address& vehicleAddr, int vehiclePort,
+            int instanceId = -1);
     
-    // Strategy methods
-    ServicePlacement* thresholdBasedPlacement(const ServiceRequest& request);
-    ServicePlacement* greedyPlacement(const ServiceRequest& request);
-    
-    // Utility methods
-    bool canServerHandleRequest(const EdgeServer& server, const ServiceRequest& request);
+    // Request collapsing
+    void collapseRequest(const ServiceRequest& request, double x, double y, const L3Address& vehicleAddr, int vehiclePort);
+    void handleCollapseTimer();
+    void decideCollapsed(const std::vector<CollapsedRequest>& waiters);
     
     // Timer handling
     void scheduleEvaluationTimer();
     void handleEvaluationTimer();
     
-    // Edge server communication
-    void sendDeploymentCommand(const ServicePlacement& placement, const ServiceRequest& request);
+    // Liveness and failover
+    void handleLoadReport(Packet* packet);
+    void checkLiveness();
+    void scheduleLivenessCheck();
+    void handleServerFailure(int serverId);
+    void replacePlacements(const std::vector<ServicePlacement>& displaced, int failedServerId);
+    
+    // Distributed placement
+    void sendLoadMap();
+    
+    // Edge server communication, endpoints taken from the node directory
+    NodeDirectory* directory;
+    // collapsed: all waiters of a collapsed decision, request being the first
+    void sendDeploymentCommand(const ServicePlacement& placement, const ServiceRequest& request, bool newInstance,
+            const std::vector<CollapsedRequest>* collapsed = nullptr);
+    L3Address resolveEdgeServerAddress(int serverId);
+    int getEdgeServerPort(int serverId) const;
+    
+    // Vehicle communication
+    void sendPlacementLease(const ServicePlacement& placement, const ServiceRequest& request, const L3Address& vehicleAddr, int vehiclePort);
+    
+    // Server states and placements; restored placements keep the vehicle ids of
+    // the saved run and lose their vehicle endpoints
+    virtual std::string getCheckpointKey() const override { return getFullPath(); }
+    virtual void saveState(std::ostream& out) const override;
+    virtual void restoreState(std::istream& in) override;
     
 public:
     LASPManager();
     virtual ~LASPManager();
     
-    // Public interface for vehicles
-    void submitServiceRequest(const ServiceRequest& request);
-    void removeServiceRequest(int requestId);
+    // Vehicles fold their serviceLatency histogram in here when they finish
+    void mergeServiceLatency(const LatencyHistogram& histogram) { fleetServiceLatency.merge(histogram); }
     
     // Getters for analysis
     const std::map<int, EdgeServer>& getEdgeServers() const { return edgeServers; }
-    const std::vector<ServicePlacement>& getActivePlacements() const { return activePlacements; }
+    const std::map<long, ServicePlacement>& getActivePlacements() const { return activePlacements; }
 };
 
 } // namespace lasp_ven_simple
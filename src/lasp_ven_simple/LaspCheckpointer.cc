@@ -0,0 +1,137 @@
+#include "LaspCheckpointer.h"
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace lasp_ven_simple {
+
+Define_Module(LaspCheckpointer);
+
+LaspCheckpointer::LaspCheckpointer()
+{
+    saveTimer = nullptr;
+}
+
+LaspCheckpointer::~LaspCheckpointer()
+{
+    cancelAndDelete(saveTimer);
+}
+
+std::unique_ptr<Checkpoint> LaspCheckpointer::load(const std::string& file)
+{
+    std::unique_ptr<Checkpoint> checkpoint(new Checkpoint());
+    try {
+        checkpoint->read(file);
+    }
+    catch (const std::runtime_error& e) {
+        throw cRuntimeError("Cannot load checkpoint: %s", e.what());
+    }
+    return checkpoint;
+}
+
+void LaspCheckpointer::initialize()
+{
+    saveFile = par("saveFile").stdstringValue();
+    if (!saveFile.empty()) {
+        simtime_t saveTime = par("saveTime");
+        if (saveTime < SIMTIME_ZERO) {
+            saveTime = getSimulation()->getWarmupPeriod();
+        }
+        saveTimer = new cMessage("saveCheckpoint");
+        scheduleAt(saveTime, saveTimer);
+        EV_WARN << "Checkpoint of the LASP modules will be saved to " << saveFile << " at " << saveTime << "s" << endl;
+    }
+
+    std::string restoreFile = par("restoreFile").stdstringValue();
+    if (!restoreFile.empty()) {
+        restored = load(restoreFile);
+        // Vehicles have to be where they were when the state was saved
+        cModule* mobility = getModuleByPath(par("mobilityModule").stringValue());
+        if (mobility && mobility->hasPar("traceStartTime")) {
+            double traceStartTime = mobility->par("traceStartTime").doubleValue();
+            if (std::fabs(traceStartTime - restored->getTraceTime()) > 1e-9) {
+                throw cRuntimeError("Checkpoint %s was taken at trace time %gs but the replay starts at %gs, "
+                        "set traceStartTime = checkpointTraceTime(\"%s\")", restoreFile.c_str(), restored->getTraceTime(),
+                        traceStartTime, restoreFile.c_str());
+            }
+        }
+        else {
+            EV_WARN << "Restoring " << restoreFile << " without a mobility replay, vehicles do not resume their checkpointed positions" << endl;
+        }
+        EV_WARN << "Starting from checkpoint " << restoreFile << ": " << restored->getNumSections()
+                << " module states, saved at " << restored->getTime() << "s, trace time " << restored->getTraceTime() << "s" << endl;
+    }
+}
+
+void LaspCheckpointer::handleMessage(cMessage* msg)
+{
+    if (msg != saveTimer) {
+        throw cRuntimeError("LaspCheckpointer received unknown message %s", msg->getName());
+    }
+    save();
+}
+
+simtime_t LaspCheckpointer::getTraceStartTime() const
+{
+    cModule* mobility = getModuleByPath(par("mobilityModule").stringValue());
+    return mobility && mobility->hasPar("traceStartTime") ? mobility->par("traceStartTime").doubleValue() : 0.0;
+}
+
+void LaspCheckpointer::collect(cModule* module, Checkpoint& checkpoint) const
+{
+    if (auto state = dynamic_cast<ICheckpointable*>(module)) {
+        std::ostringstream out;
+        out.precision(std::numeric_limits<double>::max_digits10);
+        state->saveState(out);
+        checkpoint.setSection(state->getCheckpointKey(), out.str());
+    }
+    for (cModule::SubmoduleIterator it(module); !it.end(); ++it) {
+        collect(*it, checkpoint);
+    }
+}
+
+void LaspCheckpointer::save()
+{
+    Checkpoint checkpoint;
+    // A run that is itself a replay started mid-trace saves the absolute trace time
+    checkpoint.setTime(simTime().dbl(), (simTime() + getTraceStartTime()).dbl());
+    collect(getSimulation()->getSystemModule(), checkpoint);
+    try {
+        checkpoint.write(saveFile);
+    }
+    catch (const std::runtime_error& e) {
+        throw cRuntimeError("Cannot save checkpoint: %s", e.what());
+    }
+    EV_WARN << "Saved " << checkpoint.getNumSections() << " module states to checkpoint " << saveFile << endl;
+}
+
+bool LaspCheckpointer::restore(ICheckpointable* state) const
+{
+    if (!restored) {
+        return false;
+    }
+    std::string key = state->getCheckpointKey();
+    const std::string* section = restored->getSection(key);
+    if (!section) {
+        return false;
+    }
+    std::istringstream in(*section);
+    state->restoreState(in);
+    if (in.fail()) {
+        throw cRuntimeError("Malformed checkpoint state of %s", key.c_str());
+    }
+    return true;
+}
+
+// Lets ini files start a replay at the checkpoint, e.g.
+// *.veinsManager.traceStartTime = checkpointTraceTime("results/warmup.ckpt")
+static cNedValue nedCheckpointTraceTime(cComponent *context, cNedValue argv[], int argc)
+{
+    return cNedValue(LaspCheckpointer::load(argv[0].stdstringValue())->getTraceTime(), "s");
+}
+
+Define_NED_Function2(nedCheckpointTraceTime, "double checkpointTraceTime(string file)", "lasp",
+        "Mobility trace time a LASP checkpoint was saved at, where a replay forked from it starts");
+
+} // namespace lasp_ven_simple
@@ -0,0 +1,64 @@
+#ifndef LASPCHECKPOINTER_H
+#define LASPCHECKPOINTER_H
+
+#include <omnetpp.h>
+#include "utils/Checkpoint.h"
+#include <iosfwd>
+#include <memory>
+#include <string>
+
+using namespace omnetpp;
+
+namespace lasp_ven_simple {
+
+// LASP module state that can be carried from one run into another
+class ICheckpointable {
+public:
+    virtual ~ICheckpointable() {}
+
+    // Identifies the same entity in a run forked from the checkpoint
+    virtual std::string getCheckpointKey() const = 0;
+    virtual void saveState(std::ostream& out) const = 0;
+    // Sets failbit on `in` if the section cannot be parsed
+    virtual void restoreState(std::istream& in) = 0;
+};
+
+// Saves the state of every ICheckpointable module of the network at saveTime
+// (by default the end of the warmup period), together with the mobility
+// trace time it corresponds to. A run with restoreFile set starts its LASP
+// modules from such a checkpoint; each module asks for its own section as
+// it starts. Combined with VeinsInetReplayManager starting the recorded
+// trace at the checkpoint's trace time (checkpointTraceTime()), many
+// variants fork from one warmed-up run instead of each repeating the warmup.
+//
+// The network stack, timers and in-flight messages are not part of a
+// checkpoint: forked runs bring the network up afresh, and requests that
+// were outstanding at saveTime are dropped.
+class LaspCheckpointer : public cSimpleModule {
+public:
+    LaspCheckpointer();
+    virtual ~LaspCheckpointer();
+
+    // Restores `state` from the restoreFile, if one is set and holds its key
+    bool restore(ICheckpointable* state) const;
+
+    // Reads a checkpoint file afresh, so a run sees the file as it is when
+    // the run starts; throws cRuntimeError
+    static std::unique_ptr<Checkpoint> load(const std::string& file);
+
+protected:
+    virtual void initialize() override;
+    virtual void handleMessage(cMessage* msg) override;
+
+    void save();
+    void collect(cModule* module, Checkpoint& checkpoint) const;
+    simtime_t getTraceStartTime() const;
+
+    std::string saveFile;
+    std::unique_ptr<Checkpoint> restored; // read from restoreFile for this run
+    cMessage* saveTimer;
+};
+
+} // namespace lasp_ven_simple
+
+#endif // LASPCHECKPOINTER_H
@@ -0,0 +1,149 @@
+#include "NodeDirectory.h"
+#include "EdgeTopology.h"
+#include <algorithm>
+
+namespace lasp_ven_simple {
+
+Define_Module(NodeDirectory);
+
+NodeDirectory::NodeDirectory()
+{
+    manager.port = -1;
+    vehiclePool = 0;
+    vehicleSubnetSize = 0;
+    vehiclePoolSlots = 0;
+    nextVehicleSlot = 0;
+    vehiclePort = -1;
+    vehiclesAdded = 0;
+    peakVehicles = 0;
+}
+
+NodeDirectory::~NodeDirectory()
+{
+}
+
+const EdgeTopology& NodeDirectory::getTopology() const
+{
+    if (!topology) {
+        topology.reset(new EdgeTopology(getTopologyDocument()));
+    }
+    return *topology;
+}
+
+void NodeDirectory::initialize()
+{
+    const EdgeTopology& descriptor = getTopology();
+    const TopologyNode& managerNode = descriptor.getManager();
+    manager = NodeEndpoint{L3Address(Ipv4Address(managerNode.address.c_str())), managerNode.port};
+    for (const TopologyNode& server : descriptor.getServers()) {
+        edgeServers[server.id] = NodeEndpoint{L3Address(Ipv4Address(server.address.c_str())), server.port};
+    }
+
+    const VehicleAddressPool& pool = descriptor.getVehicles();
+    Ipv4Address poolNetmask(pool.netmask.c_str());
+    Ipv4Address vehicleNetmask(pool.subnetNetmask.c_str());
+    if (!poolNetmask.isValidNetmask() || !vehicleNetmask.isValidNetmask()
+            || (vehicleNetmask.getInt() & poolNetmask.getInt()) != poolNetmask.getInt()) {
+        throw cRuntimeError("Vehicle address pool %s/%s cannot be split into %s subnets", pool.address.c_str(),
+                pool.netmask.c_str(), pool.subnetNetmask.c_str());
+    }
+    vehiclePool = Ipv4Address(pool.address.c_str()).getInt() & poolNetmask.getInt();
+    vehicleSubnetSize = ~vehicleNetmask.getInt() + 1;
+    if (vehicleSubnetSize < 4) {
+        throw cRuntimeError("Vehicle subnets of %s hold no host addresses", pool.subnetNetmask.c_str());
+    }
+    uint64_t poolSize = (uint64_t)(~poolNetmask.getInt()) + 1;
+    vehiclePoolSlots = (uint32_t)(poolSize / vehicleSubnetSize * (vehicleSubnetSize - 2));
+    vehiclePort = pool.port;
+
+    // A vehicle must never get the address of a fixed node
+    auto inPool = [this, poolNetmask](const L3Address& address) {
+        return (address.toIpv4().getInt() & poolNetmask.getInt()) == vehiclePool;
+    };
+    if (inPool(manager.address)) {
+        throw cRuntimeError("Vehicle address pool %s/%s contains the manager address", pool.address.c_str(), pool.netmask.c_str());
+    }
+    for (const auto& server : edgeServers) {
+        if (inPool(server.second.address)) {
+            throw cRuntimeError("Vehicle address pool %s/%s contains the address of edge server %d", pool.address.c_str(),
+                    pool.netmask.c_str(), server.first);
+        }
+    }
+
+    EV_WARN << "Node directory: manager " << manager.address << ":" << manager.port << ", " << edgeServers.size()
+            << " edge servers, room for " << vehiclePoolSlots << " vehicles in " << pool.address << "/" << pool.netmask << endl;
+}
+
+void NodeDirectory::handleMessage(cMessage* msg)
+{
+    throw cRuntimeError("NodeDirectory received unexpected message %s", msg->getName());
+}
+
+const NodeEndpoint& NodeDirectory::getEdgeServer(int serverId) const
+{
+    auto it = edgeServers.find(serverId);
+    if (it == edgeServers.end()) {
+        throw cRuntimeError("No edge server with id %d in the topology", serverId);
+    }
+    return it->second;
+}
+
+void NodeDirectory::finish()
+{
+    recordScalar("vehiclesAdded", vehiclesAdded);
+    recordScalar("peakVehicles", peakVehicles);
+}
+
+Ipv4Address NodeDirectory::getVehicleAddress(uint32_t slot) const
+{
+    uint32_t hosts = vehicleSubnetSize - 2;
+    uint32_t subnet = slot / hosts;
+    uint32_t host = slot % hosts + 1;
+    return Ipv4Address(vehiclePool + subnet * vehicleSubnetSize + host);
+}
+
+const NodeEndpoint& NodeDirectory::addVehicle(int vehicleId)
+{
+    Enter_Method_Silent();
+    auto it = vehicles.find(vehicleId);
+    if (it != vehicles.end()) {
+        return it->second.endpoint;
+    }
+
+    uint32_t slot;
+    if (!freeVehicleSlots.empty()) {
+        slot = freeVehicleSlots.front();
+        freeVehicleSlots.pop_front();
+    }
+    else if (nextVehicleSlot < vehiclePoolSlots) {
+        slot = nextVehicleSlot++;
+    }
+    else {
+        throw cRuntimeError("Vehicle address pool exhausted: all %u addresses are leased, cannot add vehicle %d",
+                vehiclePoolSlots, vehicleId);
+    }
+    VehicleLease& lease = vehicles[vehicleId];
+    lease.endpoint = NodeEndpoint{L3Address(getVehicleAddress(slot)), vehiclePort};
+    lease.slot = slot;
+    vehiclesAdded++;
+    peakVehicles = std::max(peakVehicles, vehicles.size());
+    return lease.endpoint;
+}
+
+void NodeDirectory::removeVehicle(int vehicleId)
+{
+    Enter_Method_Silent();
+    auto it = vehicles.find(vehicleId);
+    if (it != vehicles.end()) {
+        freeVehicleSlots.push_back(it->second.slot);
+        vehicles.erase(it);
+    }
+}
+
+const NodeEndpoint* NodeDirectory::findVehicle(int vehicleId) const
+{
+    auto it = vehicles.find(vehicleId);
+    return it != vehicles.end() ? &it->second.endpoint : nullptr;
+}
+
+} // namespace lasp_ven_simple
@@ -0,0 +1,87 @@
+#ifndef NODEDIRECTORY_H
+#define NODEDIRECTORY_H
+
+#include "inet/networklayer/common/L3Address.h"
+#include "inet/networklayer/contract/ipv4/Ipv4Address.h"
+#include <deque>
+#include <memory>
+#include <unordered_map>
+
+using namespace omnetpp;
+using namespace inet;
+
+namespace lasp_ven_simple {
+
+class EdgeTopology;
+
+struct NodeEndpoint {
+    L3Address address;
+    int port;
+};
+
+// Address and service port of every LASP node, so that nothing resolves
+// address strings per packet. The manager and the edge servers are entered
+// once at initialization from the edge topology descriptor; vehicles lease an
+// address when their module is created (see VehicleAddressConfigurator) and
+// return it when TraCI removes them. All lookups and leases are O(1).
+//
+// Vehicle addresses come from the descriptor's <vehicles> pool, which is split
+// into subnets of subnetNetmask, skipping the network and broadcast address of
+// every subnet, so a 10.1.0.0/16 pool of /24 subnets holds 65024 vehicles at a
+// time. Returned addresses are handed out again oldest first, so a departed
+// vehicle's address is reused as late as possible.
+class NodeDirectory : public cSimpleModule {
+public:
+    NodeDirectory();
+    virtual ~NodeDirectory();
+
+    const NodeEndpoint& getManager() const { return manager; }
+    // Throws cRuntimeError for ids that are not in the topology
+    const NodeEndpoint& getEdgeServer(int serverId) const;
+    const std::unordered_map<int, NodeEndpoint>& getEdgeServers() const { return edgeServers; }
+    // Descriptor the endpoints are built from, owned by the directory for the
+    // run. Parsed on first use, so parameters of other modules can read it
+    // before the directory is initialized.
+    const EdgeTopology& getTopology() const;
+    const cXMLElement* getTopologyDocument() const { return par("topology").xmlValue(); }
+
+    // Leases an address to a vehicle, or returns the one it holds; throws
+    // cRuntimeError when all addresses of the pool are leased
+    const NodeEndpoint& addVehicle(int vehicleId);
+    // Returns the vehicle's address to the pool; unknown ids are ignored
+    void removeVehicle(int vehicleId);
+    // nullptr for vehicles without an address
+    const NodeEndpoint* findVehicle(int vehicleId) const;
+    // Service port shared by all vehicles
+    int getVehiclePort() const { return vehiclePort; }
+
+protected:
+    struct VehicleLease {
+        NodeEndpoint endpoint;
+        uint32_t slot;
+    };
+
+    virtual void initialize() override;
+    virtual void handleMessage(cMessage* msg) override;
+    virtual void finish() override;
+
+    Ipv4Address getVehicleAddress(uint32_t slot) const;
+
+    mutable std::unique_ptr<EdgeTopology> topology;
+    NodeEndpoint manager;
+    std::unordered_map<int, NodeEndpoint> edgeServers;
+    std::unordered_map<int, VehicleLease> vehicles; // by vehicle id
+
+    uint32_t vehiclePool;         // network address of the pool
+    uint32_t vehicleSubnetSize;   // addresses per subnet
+    uint32_t vehiclePoolSlots;    // host addresses in the pool
+    uint32_t nextVehicleSlot;     // slots below it have been leased at least once
+    std::deque<uint32_t> freeVehicleSlots; // returned slots, oldest first
+    int vehiclePort;
+    long vehiclesAdded;
+    size_t peakVehicles;
+};
+
+} // namespace lasp_ven_simple
+
+#endif // NODEDIRECTORY_H
@@ -0,0 +1,56 @@
+#include "VehicleAddressConfigurator.h"
+#include "inet/common/ModuleAccess.h"
+#include "inet/networklayer/contract/IInterfaceTable.h"
+#include "inet/networklayer/ipv4/Ipv4InterfaceData.h"
+
+namespace lasp_ven_simple {
+
+Define_Module(VehicleAddressConfigurator);
+
+VehicleAddressConfigurator::VehicleAddressConfigurator()
+{
+    directory = nullptr;
+    vehicleId = -1;
+}
+
+void VehicleAddressConfigurator::initialize(int stage)
+{
+    cSimpleModule::initialize(stage);
+
+    if (stage == INITSTAGE_LOCAL) {
+        directory = getModuleFromPar<NodeDirectory>(par("nodeDirectoryModule"), this);
+    }
+    else if (stage == INITSTAGE_NETWORK_ADDRESS_ASSIGNMENT) {
+        auto interfaceTable = getModuleFromPar<IInterfaceTable>(par("interfaceTableModule"), this);
+        const char* interfaceName = par("interface");
+        auto interface = interfaceTable->findInterfaceByName(interfaceName);
+        if (!interface) {
+            throw cRuntimeError("No interface %s to configure", interfaceName);
+        }
+
+        vehicleId = getContainingNode(this)->getIndex();
+        const NodeEndpoint& endpoint = directory->addVehicle(vehicleId);
+        auto ipv4Data = interface->getProtocolData<Ipv4InterfaceData>();
+        ipv4Data->setIPAddress(endpoint.address.toIpv4());
+        ipv4Data->setNetmask(Ipv4Address(par("netmask").stringValue()));
+        cStringTokenizer groups(par("multicastGroups").stringValue());
+        while (groups.hasMoreTokens()) {
+            ipv4Data->joinMulticastGroup(Ipv4Address(groups.nextToken()));
+        }
+    }
+}
+
+void VehicleAddressConfigurator::handleMessage(cMessage* msg)
+{
+    throw cRuntimeError("VehicleAddressConfigurator received unexpected message %s", msg->getName());
+}
+
+void VehicleAddressConfigurator::finish()
+{
+    if (vehicleId >= 0) {
+        directory->removeVehicle(vehicleId);
+        vehicleId = -1;
+    }
+}
+
+} // namespace lasp_ven_simple
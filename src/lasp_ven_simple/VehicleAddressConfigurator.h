@@ -0,0 +1,35 @@
+#ifndef VEHICLEADDRESSCONFIGURATOR_H
+#define VEHICLEADDRESSCONFIGURATOR_H
+
+#include "inet/common/INETDefs.h"
+#include "NodeDirectory.h"
+
+using namespace omnetpp;
+using namespace inet;
+
+namespace lasp_ven_simple {
+
+// Per-vehicle replacement of the Ipv4NodeConfigurator for vehicles that TraCI
+// creates after the Ipv4NetworkConfigurator has run. When the vehicle module
+// is created it leases an address from the NodeDirectory and sets it on the
+// wireless interface, together with a netmask wide enough that every LASP node
+// is on-link: the routing table derives its interface route from that netmask,
+// so no route is added per vehicle. The address goes back to the pool when
+// the vehicle is removed (finish() runs before TraCI deletes the module).
+class VehicleAddressConfigurator : public cSimpleModule {
+public:
+    VehicleAddressConfigurator();
+
+protected:
+    virtual int numInitStages() const override { return NUM_INIT_STAGES; }
+    virtual void initialize(int stage) override;
+    virtual void handleMessage(cMessage* msg) override;
+    virtual void finish() override;
+
+    NodeDirectory* directory;
+    int vehicleId;
+};
+
+} // namespace lasp_ven_simple
+
+#endif // VEHICLEADDRESSCONFIGURATOR_H
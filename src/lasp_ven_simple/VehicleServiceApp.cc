@@ -1,15 +1,16 @@
 #include "VehicleServiceApp.h"
+#include "EdgeTopology.h"
+#include "strategies/GreedyLatencyAwareStrategy.h"
+#include "utils/ServicePlacementUtils.h"
 #include "inet/common/ModuleAccess.h"
 #include "inet/common/packet/Packet.h"
-#include "inet/applications/base/ApplicationPacket_m.h"
-#include "inet/networklayer/common/L3AddressResolver.h"
 #include "inet/common/TimeTag_m.h"
-#include "inet/networklayer/contract/IInterfaceTable.h"
-#include "inet/networklayer/ipv4/Ipv4InterfaceData.h"
 #include "inet/networklayer/common/L3Address.h"
-#include "inet/networklayer/contract/IRoutingTable.h"
-#include "inet/networklayer/ipv4/Ipv4Route.h"
-#include <random>
+#include "LaspMessages_m.h"
+#include <cmath>
+#include <istream>
+#include <memory>
+#include <ostream>
 
 using namespace omnetpp;
 using namespace inet;
@@ -20,11 +21,32 @@ Define_Module(VehicleServiceApp);
 
 VehicleServiceApp::VehicleServiceApp()
 {
-    laspManagerPort = 15000; // Use port 15000 to avoid conflicts
+    laspManagerPort = 15000;
     serviceRequestInterval = 10.0; // Default 10 seconds
     requestCounter = 0;
     maxRequests = 5; // Limit requests per vehicle
+    serviceSocketBound = false;
+    analyticNetwork = nullptr;
+    directory = nullptr;
+    servicePort = -1;
     requestSize = 200; // Default 200 bytes
+    leasedServerId = -1;
+    leasedServerPort = -1;
+    nextRequestId = 0;
+    maxInFlight = 4;
+    deferredRequests = 0;
+    maxTimeout = 10.0;
+    maxRetries = 3;
+    hedging = false;
+    hedgeQuantile = 0.95;
+    hedgeMinSamples = 5;
+    distributedPlacement = false;
+    loadWeight = 0.5;
+    latencyWeight = 0.5;
+    tieTolerance = 0.0;
+    profiling = false;
+    sendServiceRequestTime = LatencyHistogram(1e-9, 2, 10.0); // 1ns resolution
+    socketDataArrivedTime = LatencyHistogram(1e-9, 2, 10.0);
 }
 
 VehicleServiceApp::~VehicleServiceApp()
@@ -34,118 +56,104 @@ VehicleServiceApp::~VehicleServiceApp()
 
 bool VehicleServiceApp::startApplication()
 {
-    EV_WARN << "=== VEHICLE SERVICE APP STARTING ===" << endl;
-    EV_WARN << "Vehicle index: " << getParentModule()->getIndex() << endl;
-    
     // Call the grandparent (VeinsInetApplicationBase) directly to avoid accident simulation
     // but still get proper socket initialization
     bool result = VeinsInetApplicationBase::startApplication();
     
-    EV_WARN << "Parent startApplication() result: " << result << endl;
-    EV_WARN << "[DEBUG-SOCKET] Vehicle " << getParentModule()->getIndex() << " parent socket initialized" << endl;
-    
     // Initialize service request functionality
     serviceRequestsSent = registerSignal("serviceRequestsSent");
     serviceResponsesReceived = registerSignal("serviceResponsesReceived");
     serviceLatency = registerSignal("serviceLatency");
-    
-    EV_WARN << "Signals registered successfully" << endl;
+    directRequestsSent = registerSignal("directRequestsSent");
+    requestsDeferred = registerSignal("requestsDeferred");
+    requestRetransmissions = registerSignal("requestRetransmissions");
+    serviceRequestsFailed = registerSignal("serviceRequestsFailed");
+    hedgedRequests = registerSignal("hedgedRequests");
+    hedgeWins = registerSignal("hedgeWins");
+    duplicateResponses = registerSignal("duplicateResponses");
+    distributedRequestsSent = registerSignal("distributedRequestsSent");
     
     // Get configurable parameters
     requestSize = par("requestSize");
     maxRequests = par("maxRequests");
     serviceRequestInterval = par("serviceRequestInterval");
+    maxInFlight = par("maxInFlight");
+    maxTimeout = par("maxTimeout");
+    maxRetries = par("maxRetries");
+    rttEstimator.configure(par("initialTimeout"), par("minTimeout"), maxTimeout);
+    hedging = par("hedging");
+    hedgeQuantile = par("hedgeQuantile");
+    hedgeMinSamples = par("hedgeMinSamples");
+    distributedPlacement = par("distributedPlacement");
+    loadWeight = par("loadWeight");
+    latencyWeight = par("latencyWeight");
+    tieTolerance = par("tieTolerance");
+    loadMapGroup = L3Address(par("loadMapGroup").stringValue());
+    loadMapTimeout = par("loadMapTimeout");
+    loadMapUtilization.clear();
+    profiling = par("enableProfiling");
+    analyticNetwork = findModuleFromPar<AnalyticNetwork>(par("analyticNetworkModule"), this);
+    directory = getModuleFromPar<NodeDirectory>(par("nodeDirectoryModule"), this);
+    
+    if (auto checkpointer = findModuleFromPar<LaspCheckpointer>(par("checkpointerModule"), this)) {
+        if (checkpointer->restore(this)) {
+            EV_INFO << "Vehicle " << getParentModule()->getIndex() << " restored from checkpoint: " << requestCounter << " requests sent" << endl;
+        }
+    }
     
-    EV_WARN << "Parameters loaded - requestSize: " << requestSize 
+    EV_INFO << "Parameters loaded - requestSize: " << requestSize 
             << ", maxRequests: " << maxRequests 
+            << ", maxInFlight: " << maxInFlight 
+            << ", maxRetries: " << maxRetries 
+            << ", hedging: " << hedging 
             << ", serviceRequestInterval: " << serviceRequestInterval << endl;
     
+    std::string traceFile = par("traceFile").stdstringValue();
+    if (!traceFile.empty()) {
+        trace.open(traceFile + "." + getFullPath() + ".trc", getId(), getFullPath());
+    }
+    
     // Setup service socket with a different port to avoid conflicts with parent socket
     serviceSocket.setOutputGate(gate("socketOut"));
     serviceSocket.setCallback(this);
     serviceSocket.setReuseAddress(true); // Allow reuse of address
     
-    EV_WARN << "Service socket setup complete (binding delayed until first request)" << endl;
-    
-    // Assign IP address to vehicle programmatically
+    // Address leased by the VehicleAddressConfigurator when the vehicle module was created
     int vehicleId = getParentModule()->getIndex();
-    vehicleIP = "192.168.1." + std::to_string(10 + vehicleId);
-    
-    EV_WARN << "=== VEHICLE " << vehicleId << " IP ASSIGNMENT ATTEMPT ===" << endl;
-    EV_WARN << "Attempting to assign IP: " << vehicleIP << endl;
+    const NodeEndpoint* endpoint = directory->findVehicle(vehicleId);
+    if (!endpoint) {
+        throw cRuntimeError("Vehicle %d has no address, its ipv4.configurator must be a VehicleAddressConfigurator", vehicleId);
+    }
+    vehicleIP = endpoint->address.str();
+    servicePort = endpoint->port;
     
-    // Get the interface table and find the wlan interface
-    auto interfaceTable = getModuleFromPar<IInterfaceTable>(par("interfaceTableModule"), this);
-    if (interfaceTable) {
-        EV_WARN << "Vehicle " << vehicleId << " found interface table with " << interfaceTable->getNumInterfaces() << " interfaces" << endl;
-        
-        bool ipAssigned = false;
-        for (int i = 0; i < interfaceTable->getNumInterfaces(); i++) {
-            auto interface = interfaceTable->getInterface(i);
-            if (interface) {
-                EV_WARN << "Vehicle " << vehicleId << " checking interface " << i << ": " << interface->getInterfaceName() << endl;
-                
-                if (strstr(interface->getInterfaceName(), "wlan") != nullptr) {
-                    EV_WARN << "Vehicle " << vehicleId << " found wlan interface: " << interface->getInterfaceName() << endl;
-                    
-                                           auto ipv4Data = interface->getProtocolData<Ipv4InterfaceData>();
-                       if (ipv4Data) {
-                           EV_WARN << "Vehicle " << vehicleId << " current IP before assignment: " << ipv4Data->getIPAddress().str() << endl;
-                           
-                           L3Address ipAddr(vehicleIP.c_str());
-                           L3Address netmaskAddr("255.255.255.0");
-                           ipv4Data->setIPAddress(ipAddr.toIpv4());
-                           ipv4Data->setNetmask(netmaskAddr.toIpv4());
-                           
-                                                       EV_WARN << "✓ Vehicle " << vehicleId << " IP successfully assigned: " << vehicleIP << " to interface " << interface->getInterfaceName() << endl;
-                            EV_WARN << "Vehicle " << vehicleId << " IP after assignment: " << ipv4Data->getIPAddress().str() << endl;
-                            EV_WARN << "Vehicle " << vehicleId << " Netmask after assignment: " << ipv4Data->getNetmask().str() << endl;
-                            
-                            // Add default route to routing table
-                            auto routingTable = getModuleByPath("^.ipv4.routingTable");
-                            if (routingTable) {
-                                auto iroutingTable = check_and_cast<IRoutingTable*>(routingTable);
-                                // Create a default route for the local network (192.168.1.0/24)
-                                auto route = new Ipv4Route();
-                                route->setDestination(Ipv4Address("192.168.1.0"));  // Network address
-                                route->setNetmask(Ipv4Address("255.255.255.0"));    // /24 netmask
-                                route->setGateway(Ipv4Address::UNSPECIFIED_ADDRESS); // Direct connection
-                                route->setInterface(interface);
-                                route->setMetric(0);
-                                iroutingTable->addRoute(route);
-                                EV_WARN << "✓ Vehicle " << vehicleId << " added default route to routing table" << endl;
-                            } else {
-                                EV_WARN << "✗ Vehicle " << vehicleId << " could not find routing table" << endl;
-                            }
-                            
-                            ipAssigned = true;
-                            break;
-                    } else {
-                        EV_WARN << "✗ Vehicle " << vehicleId << " failed to get IPv4 interface data for " << interface->getInterfaceName() << endl;
-                    }
-                }
+    // The analytic network needs no IP stack, the endpoint is only registered there
+    if (analyticNetwork) {
+        analyticNetwork->bind(this, endpoint->address, servicePort);
+        serviceSocketBound = true;
+    }
+    else {
+        // Bind socket to the directory's service port, which differs from the parent socket's
+        try {
+            // The load map is multicast, so the socket cannot be tied to the unicast address
+            serviceSocket.bind(distributedPlacement ? L3Address() : endpoint->address, servicePort);
+            if (distributedPlacement) {
+                serviceSocket.joinMulticastGroup(loadMapGroup);
             }
+            serviceSocketBound = true;
+            EV_INFO << "[FLOW-1] VEHICLE " << vehicleId << " -> LASPManager: Socket bound to " << vehicleIP << ":" << servicePort << endl;
+        } catch (const std::exception& e) {
+            EV_WARN << "[ERROR-SOCKET] Vehicle " << vehicleId << " failed to bind socket: " << e.what() << endl;
         }
-        
-        if (!ipAssigned) {
-            EV_WARN << "✗ Vehicle " << vehicleId << " no suitable wlan interface found for IP assignment" << endl;
-        }
-    } else {
-        EV_WARN << "✗ Vehicle " << vehicleId << " failed to get interface table" << endl;
     }
     
-    EV_WARN << "=== VEHICLE " << vehicleId << " IP ASSIGNMENT COMPLETE ===" << endl;
-    
-    // Add a small delay to ensure IP assignment propagates through network stack
-    EV_WARN << "Vehicle " << vehicleId << " waiting 0.1s for IP assignment to propagate..." << endl;
-    scheduleAt(simTime() + 0.1, new cMessage("ipPropagationDelay"));
+    // LASP Manager endpoint from the node directory
+    laspManagerAddress = directory->getManager().address;
+    laspManagerPort = directory->getManager().port;
     
-    // Resolve LASP Manager address
-    laspManagerAddress = L3AddressResolver().resolve("192.168.1.100");
+    EV_INFO << "LASP Manager address resolved: " << laspManagerAddress.str() << endl;
     
-    EV_WARN << "LASP Manager address resolved: " << laspManagerAddress.str() << endl;
-    
-    EV_WARN << "=== VEHICLE SERVICE APP STARTED SUCCESSFULLY ===" << endl;
+    scheduleNextServiceRequest();
     
     return result;
 }
@@ -164,31 +172,46 @@ void VehicleServiceApp::processPacket(std::shared_ptr<inet::Packet> pk)
 bool VehicleServiceApp::stopApplication()
 {
     serviceSocket.close();
+    if (analyticNetwork) {
+        analyticNetwork->unbind(this);
+    }
+    serviceSocketBound = false;
     
     // Call parent cleanup (TimerManager cleanup handled automatically)
     return VeinsInetSampleApplication::stopApplication();
 }
 
-void VehicleServiceApp::scheduleNextServiceRequest()
+void VehicleServiceApp::finish()
 {
-    EV_WARN << "Vehicle " << getParentModule()->getIndex() 
-            << " scheduleNextServiceRequest() called, requestCounter: " << requestCounter 
-            << ", maxRequests: " << maxRequests << endl;
+    VeinsInetSampleApplication::finish();
     
+    latencyHistogram.recordScalars(this, "serviceLatency");
+    if (profiling) {
+        sendServiceRequestTime.recordScalars(this, "wallTime:sendServiceRequest");
+        socketDataArrivedTime.recordScalars(this, "wallTime:socketDataArrived");
+    }
+    trace.close();
+    if (analyticNetwork) {
+        analyticNetwork->unbind(this);
+    }
+    
+    // Contribute to the fleet-wide distribution (also runs when TraCI removes the vehicle)
+    if (auto laspManager = findModuleFromPar<LASPManager>(par("laspManagerModule"), this)) {
+        laspManager->mergeServiceLatency(latencyHistogram);
+    }
+}
+
+void VehicleServiceApp::scheduleNextServiceRequest()
+{
     if (requestCounter < maxRequests) {
         // Use Veins timer system instead of OMNeT++ timers
         auto callback = [this]() {
-            EV_WARN << "Vehicle " << getParentModule()->getIndex() 
-                    << " timer callback triggered, calling sendServiceRequest()" << endl;
             sendServiceRequest();
             scheduleNextServiceRequest(); // Schedule next one
         };
         
         double delay = uniform(1.0, 3.0) + 5.0; // Reduced delay for testing
         timerManager.create(veins::TimerSpecification(callback).oneshotIn(SimTime(delay, SIMTIME_S)));
-        
-        EV_WARN << "Vehicle " << getParentModule()->getIndex() 
-                << " scheduled next service request in " << delay << "s" << endl;
     } else {
         EV_WARN << "Vehicle " << getParentModule()->getIndex() 
                 << " max requests reached, not scheduling more" << endl;
@@ -197,165 +220,404 @@ void VehicleServiceApp::scheduleNextServiceRequest()
 
 void VehicleServiceApp::sendServiceRequest()
 {
+    ScopedTimer timer(profiling ? &sendServiceRequestTime : nullptr);
     int vehicleId = getParentModule()->getIndex();
-    EV_WARN << "[FLOW-1] VEHICLE " << vehicleId << " → LASPManager: Sending service request #" << (requestCounter + 1) << endl;
+    if (requestCounter >= maxRequests || !serviceSocketBound) {
+        return;
+    }
     
-    if (requestCounter >= maxRequests) {
-        EV_WARN << "[FLOW-1] VEHICLE " << vehicleId << " → LASPManager: Max requests reached, not sending" << endl;
+    // Bounded in-flight window: hold the request back until a response frees a slot
+    if ((int)pendingRequests.size() >= maxInFlight) {
+        deferredRequests++;
+        emit(requestsDeferred, 1);
+        LASP_TRACE(trace, REQUEST_DEFERRED, vehicleId, (int64_t)pendingRequests.size(), 0, 0.0);
         return;
     }
     
-    // Bind socket on first request (after IP assignment is complete)
-    if (requestCounter == 0) {
-        EV_WARN << "[FLOW-1] VEHICLE " << vehicleId << " → LASPManager: About to bind socket to port 5000" << endl;
-        EV_WARN << "[DEBUG-SOCKET] Vehicle " << vehicleId << " serviceSocket state before binding: " << (serviceSocket.getState() == UdpSocket::CLOSED ? "CLOSED" : "OPEN") << endl;
-        
-        // Check current interface state before binding
-        auto interfaceTable = getModuleFromPar<IInterfaceTable>(par("interfaceTableModule"), this);
-        if (interfaceTable) {
-            for (int i = 0; i < interfaceTable->getNumInterfaces(); i++) {
-                auto interface = interfaceTable->getInterface(i);
-                if (interface && strstr(interface->getInterfaceName(), "wlan") != nullptr) {
-                    auto ipv4Data = interface->getProtocolData<Ipv4InterfaceData>();
-                    if (ipv4Data) {
-                        EV_WARN << "[FLOW-1] VEHICLE " << vehicleId << " → LASPManager: Interface " << interface->getInterfaceName() 
-                                << " has IP: " << ipv4Data->getIPAddress().str() << endl;
-                    }
-                }
-            }
-        }
-        
-        // Bind socket to a different port to avoid conflicts with parent socket
-        int servicePort = 5000 + vehicleId; // Use different port for each vehicle
-        EV_WARN << "[FLOW-1] VEHICLE " << vehicleId << " -> LASPManager: Binding socket to " << vehicleIP << ":" << servicePort << endl;
-        EV_WARN << "[DEBUG-SOCKET] Vehicle " << vehicleId << " checking if port " << servicePort << " is available..." << endl;
-        
-        try {
-            serviceSocket.bind(L3Address(vehicleIP.c_str()), servicePort);
-            EV_WARN << "[FLOW-1] VEHICLE " << vehicleId << " -> LASPManager: Socket bound to " << vehicleIP << ":" << servicePort << endl;
-            EV_WARN << "[DEBUG-SOCKET] Vehicle " << vehicleId << " serviceSocket state after binding: " << (serviceSocket.getState() == UdpSocket::CLOSED ? "CLOSED" : "OPEN") << endl;
-            EV_WARN << "[DEBUG-SOCKET] Vehicle " << vehicleId << " serviceSocket bound successfully to port " << servicePort << endl;
-        } catch (const std::exception& e) {
-            EV_WARN << "[ERROR-SOCKET] Vehicle " << vehicleId << " failed to bind socket: " << e.what() << endl;
-            EV_WARN << "[ERROR-SOCKET] Vehicle " << vehicleId << " trying alternative port " << (servicePort + 100) << "..." << endl;
-            try {
-                serviceSocket.bind(L3Address(vehicleIP.c_str()), servicePort + 100);
-                EV_WARN << "[FLOW-1] VEHICLE " << vehicleId << " -> LASPManager: Socket bound to " << vehicleIP << ":" << (servicePort + 100) << endl;
-            } catch (const std::exception& e2) {
-                EV_WARN << "[ERROR-SOCKET] Vehicle " << vehicleId << " failed to bind to alternative port: " << e2.what() << endl;
-                return;
-            }
-        }
-        
-        // Debug: Check routing table after IP assignment
-        auto routingTable = getModuleByPath("^.wlan[0].ipv4.routingTable");
-        if (routingTable) {
-            auto iroutingTable = check_and_cast<IRoutingTable*>(routingTable);
-            EV_WARN << "[DEBUG-ROUTE-001] Vehicle " << vehicleId << ": Routing table has " << iroutingTable->getNumRoutes() << " routes" << endl;
-            for (int i = 0; i < iroutingTable->getNumRoutes(); i++) {
-                auto route = iroutingTable->getRoute(i);
-                if (route) {
-                    EV_WARN << "[DEBUG-ROUTE-001] Vehicle " << vehicleId << ": Route " << i << ": " 
-                            << route->getDestinationAsGeneric().str() << " -> " << route->getNextHopAsGeneric().str() << endl;
-                }
-            }
-        } else {
-            EV_WARN << "[DEBUG-ROUTE-001] Vehicle " << vehicleId << ": No routing table found" << endl;
-        }
-        
-        // Debug: IP assignment successful, routing will be handled automatically
-        EV_WARN << "[FLOW-1] VEHICLE " << vehicleId << " -> LASPManager: IP assignment complete, ready for communication" << endl;
+    long requestId = nextRequestId++;
+    ServiceType service = selectServiceBasedOnContext();
+    
+    // Track request for latency measurement and retransmission
+    pendingRequests[requestId] = PendingRequest{simTime(), service, 0, -1, false, -1, -1};
+    if (!transmitRequest(requestId)) {
+        pendingRequests.erase(requestId);
+        return;
+    }
+    
+    // Hedge once there are enough RTT samples to tell what a slow response is
+    if (hedging && (int)rttEstimator.getNumRecentSamples() >= hedgeMinSamples) {
+        simtime_t hedgeDelay = rttEstimator.getRecentQuantile(hedgeQuantile);
+        pendingRequests[requestId].hedgeTimer = timerManager.create(veins::TimerSpecification([this, requestId]() {
+            sendHedgedRequest(requestId);
+        }).oneshotIn(hedgeDelay));
     }
     
-    // Create service request packet
-    auto packet = new Packet("VehicleServiceRequest");
-    auto payload = makeShared<ApplicationPacket>();
+    emit(serviceRequestsSent, 1);
+    requestCounter++;
+}
+
+bool VehicleServiceApp::transmitRequest(long requestId)
+{
+    int vehicleId = getParentModule()->getIndex();
+    PendingRequest& pending = pendingRequests.at(requestId);
+    
+    // A server placed on the load map, or else a valid placement lease, skips the LASPManager
+    int localServerId = distributedPlacement ? placeOnLoadMap(pending.serviceType) : -1;
+    bool direct = localServerId >= 0 || hasValidLease();
+    auto packet = createServiceRequestPacket(direct ? "DirectServiceRequest" : "VehicleServiceRequest", requestId, pending.serviceType);
+    L3Address targetAddress = direct ? leasedServerAddress : laspManagerAddress;
+    int targetPort = direct ? leasedServerPort : laspManagerPort;
+    int targetServerId = direct ? leasedServerId : -1;
+    if (localServerId >= 0) {
+        const NodeEndpoint& server = directory->getEdgeServer(localServerId);
+        targetAddress = server.address;
+        targetPort = server.port;
+        targetServerId = localServerId;
+    }
+    
+    try {
+        sendPacket(packet, targetAddress, targetPort);
+    } catch (const std::exception& e) {
+        EV_WARN << "[ERROR-SOCKET] Vehicle " << vehicleId << " failed to send packet: " << e.what() << endl;
+        delete packet;
+        return false;
+    }
+    
+    // A manager-routed request learns its server from the PlacementLease
+    pending.serverId = targetServerId;
+    if (localServerId >= 0) {
+        emit(distributedRequestsSent, 1);
+    }
+    else if (direct) {
+        emit(directRequestsSent, 1);
+    }
+    LASP_TRACE(trace, REQUEST_SENT, vehicleId, requestId, pending.serverId, pending.attempts + 1);
+    
+    // Exponential backoff on the estimated RTO
+    double timeout = std::min(rttEstimator.getRto() * std::pow(2.0, pending.attempts), maxTimeout);
+    pending.timeoutTimer = timerManager.create(veins::TimerSpecification([this, requestId]() {
+        handleRequestTimeout(requestId);
+    }).oneshotIn(SimTime(timeout)));
+    return true;
+}
+
+void VehicleServiceApp::handleRequestTimeout(long requestId)
+{
+    int vehicleId = getParentModule()->getIndex();
+    auto it = pendingRequests.find(requestId);
+    if (it == pendingRequests.end()) {
+        return;
+    }
+    PendingRequest& pending = it->second;
+    
+    // A silent leased server is not trusted any further; retries go through the manager
+    if (pending.serverId >= 0 && pending.serverId == leasedServerId) {
+        leasedServerId = -1;
+    }
+    if (distributedPlacement && pending.serverId >= 0) {
+        excludeFromLoadMap(pending.serverId);
+    }
+    
+    if (pending.attempts >= maxRetries) {
+        LASP_TRACE(trace, REQUEST_FAILED, vehicleId, requestId, 0, pending.attempts + 1);
+        timerManager.cancel(pending.hedgeTimer);
+        pendingRequests.erase(it);
+        emit(serviceRequestsFailed, 1);
+        releaseInFlightSlot();
+        return;
+    }
+    
+    pending.attempts++;
+    emit(requestRetransmissions, 1);
+    LASP_TRACE(trace, REQUEST_TIMEOUT, vehicleId, requestId, pending.serverId, pending.attempts + 1);
+    if (!transmitRequest(requestId)) {
+        timerManager.cancel(pending.hedgeTimer);
+        pendingRequests.erase(it);
+        emit(serviceRequestsFailed, 1);
+        releaseInFlightSlot();
+    }
+}
+
+void VehicleServiceApp::sendHedgedRequest(long requestId)
+{
+    auto it = pendingRequests.find(requestId);
+    if (it == pendingRequests.end() || it->second.hedged) {
+        return;
+    }
+    PendingRequest& pending = it->second;
+    if (pending.serverId < 0) {
+        // Without a lease the first server is unknown, and the manager could
+        // place the duplicate on that same server
+        return;
+    }
+    pending.hedged = true;
+    
+    // The duplicate always goes through the manager, which places it away from the first server
+    auto packet = createServiceRequestPacket("VehicleServiceRequest", requestId, pending.serviceType, pending.serverId, true);
+    try {
+        sendPacket(packet, laspManagerAddress, laspManagerPort);
+    } catch (const std::exception& e) {
+        EV_WARN << "[ERROR-SOCKET] Vehicle " << getParentModule()->getIndex() << " failed to send hedged request: " << e.what() << endl;
+        delete packet;
+        return;
+    }
+    emit(hedgedRequests, 1);
+    LASP_TRACE(trace, HEDGE_SENT, getParentModule()->getIndex(), requestId, pending.serverId, 0.0);
+}
+
+void VehicleServiceApp::sendPacket(Packet* packet, const L3Address& destAddr, int destPort)
+{
+    if (analyticNetwork) {
+        analyticNetwork->sendTo(this, packet, destAddr, destPort);
+    } else {
+        serviceSocket.sendTo(packet, destAddr, destPort);
+    }
+}
+
+void VehicleServiceApp::releaseInFlightSlot()
+{
+    if (deferredRequests > 0) {
+        deferredRequests--;
+        sendServiceRequest();
+    }
+}
+
+Packet* VehicleServiceApp::createServiceRequestPacket(const char* name, long requestId, ServiceType serviceType, int excludeServerId, bool hedged)
+{
+    auto packet = new Packet(name);
+    auto payload = makeShared<ServiceRequestMessage>();
     payload->setChunkLength(B(requestSize));
-    payload->setSequenceNumber(vehicleId); // Use vehicle index as ID
+    payload->setVehicleId(getParentModule()->getIndex());
+    payload->setRequestId(requestId);
+    payload->setServiceType(serviceType);
+    payload->setExcludeServerId(excludeServerId);
+    payload->setHedged(hedged);
+    if (mobility) {
+        const Coord& position = mobility->getCurrentPosition();
+        payload->setPositionX(position.x);
+        payload->setPositionY(position.y);
+    }
     packet->insertAtBack(payload);
     
     // Add request metadata
     packet->addTag<CreationTimeTag>()->setCreationTime(simTime());
+    return packet;
+}
+
+bool VehicleServiceApp::hasValidLease() const
+{
+    return leasedServerId >= 0 && simTime() < leaseExpiry;
+}
+
+void VehicleServiceApp::handlePlacementLease(Packet* packet)
+{
+    auto lease = packet->peekData<PlacementLease>();
+    leasedServerId = lease->getServerId();
+    leasedServerAddress = lease->getServerAddress();
+    leasedServerPort = lease->getServerPort();
+    leaseExpiry = simTime() + lease->getLeaseTtl();
+    
+    auto it = pendingRequests.find(lease->getRequestId());
+    if (it != pendingRequests.end() && it->second.serverId < 0) {
+        it->second.serverId = leasedServerId;
+    }
     
-    // Track request for latency measurement  
-    pendingRequests[vehicleId] = simTime();
+    LASP_TRACE(trace, LEASE_RECEIVED, getParentModule()->getIndex(), lease->getRequestId(), leasedServerId, lease->getLeaseTtl().dbl());
+}
+
+void VehicleServiceApp::handleLeaseRejected(Packet* packet)
+{
+    auto payload = packet->peekData<ServiceResponseMessage>();
+    long requestId = payload->getRequestId();
+    LASP_TRACE(trace, LEASE_REJECTED, getParentModule()->getIndex(), requestId, payload->getServerId(), 0.0);
+    if (payload->getServerId() == leasedServerId) {
+        leasedServerId = -1;
+    }
+    if (distributedPlacement) {
+        excludeFromLoadMap(payload->getServerId());
+    }
+    
+    // Re-route the refused request through the manager or another server on the load map; its original send time is kept
+    // so the detour shows up in the measured latency
+    auto it = pendingRequests.find(requestId);
+    if (it != pendingRequests.end()) {
+        timerManager.cancel(it->second.timeoutTimer);
+        if (!transmitRequest(requestId)) {
+            timerManager.cancel(it->second.hedgeTimer);
+            pendingRequests.erase(it);
+            emit(serviceRequestsFailed, 1);
+            releaseInFlightSlot();
+        }
+    }
+}
+
+void VehicleServiceApp::handleLoadMap(Packet* packet)
+{
+    auto loadMap = packet->peekData<LoadMap>();
+    size_t numServers = directory->getTopology().getServers().size();
+    loadMapUtilization.assign(numServers, -1.0f);
+    for (size_t i = 0; i < loadMap->getServerIndexArraySize(); i++) {
+        size_t index = loadMap->getServerIndex(i);
+        if (index < numServers) {
+            loadMapUtilization[index] = loadMap->getUtilization(i);
+        }
+    }
+    loadMapTime = simTime();
+}
+
+int VehicleServiceApp::placeOnLoadMap(ServiceType serviceType)
+{
+    if (loadMapUtilization.empty() || simTime() - loadMapTime > loadMapTimeout) {
+        return -1;
+    }
     
-    EV_WARN << "[FLOW-1] VEHICLE " << vehicleId << " -> LASPManager: Packet created, sending to " << laspManagerAddress.str() << ":" << laspManagerPort << endl;
-    EV_WARN << "[DEBUG] Vehicle " << vehicleId << ": Packet size: " << packet->getByteLength() << " bytes" << endl;
-    EV_WARN << "[DEBUG] Vehicle " << vehicleId << ": Payload size: " << payload->getChunkLength() << " bytes" << endl;
-    EV_WARN << "[DEBUG] Vehicle " << vehicleId << ": LASPManager address: " << laspManagerAddress.str() << endl;
-    EV_WARN << "[DEBUG-SOCKET] Vehicle " << vehicleId << " serviceSocket state before sendTo: " << (serviceSocket.getState() == UdpSocket::CLOSED ? "CLOSED" : "OPEN") << endl;
+    // Same request model as the LASPManager
+    ServiceRequest request = ServicePlacementUtils::makeRequest(getParentModule()->getIndex(), -1, serviceType, simTime().dbl());
+    
+    // Servers of the map hosting the service, as the LASPManager sees them
+    mapServers.clear();
+    mapServerIndices.clear();
+    mapCandidates.clear();
+    const std::vector<TopologyNode>& nodes = directory->getTopology().getServers();
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (loadMapUtilization[i] < 0 || !(nodes[i].services & serviceBit(serviceType))) {
+            continue;
+        }
+        EdgeServer server;
+        server.serverId = nodes[i].id;
+        server.latitude = nodes[i].x;
+        server.longitude = nodes[i].y;
+        server.computeCapacity = nodes[i].computeCapacity;
+        server.storageCapacity = nodes[i].storageCapacity;
+        server.memoryCapacity = nodes[i].memoryCapacity;
+        server.currentLoad = loadMapUtilization[i] * nodes[i].computeCapacity;
+        server.memoryUsed = 0.0; // not on the map
+        server.storageUsed = 0.0;
+        server.services = nodes[i].services;
+        server.isActive = true;
+        mapServers.push_back(server);
+        mapServerIndices.push_back(i);
+    }
+    for (const EdgeServer& server : mapServers) {
+        mapCandidates.push_back(&server);
+    }
     
-    // Send to LASP Manager
-    try {
-        serviceSocket.sendTo(packet, laspManagerAddress, laspManagerPort);
-        EV_WARN << "[DEBUG] Vehicle " << vehicleId << ": sendTo() called successfully" << endl;
-    } catch (const std::exception& e) {
-        EV_WARN << "[ERROR-SOCKET] Vehicle " << vehicleId << " failed to send packet: " << e.what() << endl;
-        delete packet;
+    // Vehicles acting on the same map draw among the servers that score about the same
+    const ServiceFootprint& footprint = directory->getTopology().getFootprint(serviceType);
+    ServicePlacement placement;
+    if (!GreedyLatencyAwareStrategy::placeService(request, mapCandidates, footprint, placement, scoredServers,
+            loadWeight, latencyWeight, getRNG(0), tieTolerance)) {
+        return -1;
+    }
+    
+    // Count this request on the chosen server until the next map replaces the estimate
+    for (size_t k = 0; k < mapServers.size(); k++) {
+        if (mapServers[k].serverId == placement.serverId) {
+            loadMapUtilization[mapServerIndices[k]] += (float)(placement.resourceUsage / mapServers[k].computeCapacity);
+            break;
+        }
+    }
+    return placement.serverId;
+}
+
+void VehicleServiceApp::excludeFromLoadMap(int serverId)
+{
+    // A server that refused or ignored a request gets nothing more from this map
+    const std::vector<TopologyNode>& nodes = directory->getTopology().getServers();
+    for (size_t i = 0; i < nodes.size() && i < loadMapUtilization.size(); i++) {
+        if (nodes[i].id == serverId) {
+            loadMapUtilization[i] = -1.0f;
+            break;
+        }
+    }
+}
+
+void VehicleServiceApp::handleServiceResponse(Packet* packet)
+{
+    int vehicleId = getParentModule()->getIndex();
+    auto payload = packet->peekData<ServiceResponseMessage>();
+    long requestId = payload->getRequestId();
+    
+    // Calculate latency if we have the original request time
+    auto it = pendingRequests.find(requestId);
+    if (it == pendingRequests.end()) {
+        // Late answer to a retransmitted or hedged request that has already completed
+        LASP_TRACE(trace, UNMATCHED_RESPONSE, vehicleId, requestId, payload->getServerId(), 0.0);
+        emit(duplicateResponses, 1);
         return;
     }
     
-    emit(serviceRequestsSent, 1);
-    requestCounter++;
+    PendingRequest& pending = it->second;
+    timerManager.cancel(pending.timeoutTimer);
+    timerManager.cancel(pending.hedgeTimer);
     
-    ServiceType service = selectServiceBasedOnContext();
-    EV_WARN << "[FLOW-1] VEHICLE " << vehicleId << " -> LASPManager: Request #" << requestCounter << " sent (service type " << service << ")" << endl;
+    // Karn's rule: only unambiguous round trips feed the RTT estimator
+    simtime_t latency = simTime() - pending.sendTime;
+    if (pending.attempts == 0 && !pending.hedged) {
+        rttEstimator.addSample(latency.dbl());
+    }
+    if (pending.hedged && pending.serverId >= 0 && payload->getServerId() != pending.serverId) {
+        emit(hedgeWins, 1);
+    }
+    emit(serviceLatency, latency.dbl());
+    latencyHistogram.record(latency.dbl());
+    pendingRequests.erase(it);
+    
+    LASP_TRACE(trace, RESPONSE_RECEIVED, vehicleId, requestId, payload->getServerId(), latency.dbl());
+    
+    emit(serviceResponsesReceived, 1);
+    
+    // A slot in the in-flight window is free again
+    releaseInFlightSlot();
 }
 
 ServiceType VehicleServiceApp::selectServiceBasedOnContext()
 {
-    // Simple context-based service selection
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<> dis(1, 4);
+    // Simple context-based service selection, drawn from the module RNG so
+    // that runs with the same seed-set place the same services
     
     // In a real scenario, this could be based on:
     // - Vehicle speed (high speed = navigation, low speed = infotainment)
     // - Time of day (rush hour = traffic info)
     // - Location (accident area = emergency alerts)
     
-    return static_cast<ServiceType>(dis(gen));
+    return static_cast<ServiceType>(intuniform(TRAFFIC_INFO, NAVIGATION));
 }
 
 void VehicleServiceApp::socketDataArrived(UdpSocket *socket, Packet *packet)
 {
-    int vehicleId = getParentModule()->getIndex();
-    EV_WARN << "[DEBUG-SOCKET] Vehicle " << vehicleId << " socketDataArrived called" << endl;
-    EV_WARN << "[DEBUG-SOCKET] Vehicle " << vehicleId << " socket pointer: " << socket << endl;
-    EV_WARN << "[DEBUG-SOCKET] Vehicle " << vehicleId << " serviceSocket pointer: " << &serviceSocket << endl;
-    EV_WARN << "[DEBUG-SOCKET] Vehicle " << vehicleId << " packet name: " << packet->getName() << endl;
+    ScopedTimer timer(profiling ? &socketDataArrivedTime : nullptr);
+    if (strcmp(packet->getName(), "LoadMap") == 0) {
+        if (distributedPlacement) {
+            handleLoadMap(packet);
+        }
+        delete packet;
+        return;
+    }
+    // Placement lease control traffic from the LASPManager / leased edge server
+    if (strcmp(packet->getName(), "PlacementLease") == 0) {
+        handlePlacementLease(packet);
+        delete packet;
+        return;
+    }
+    if (strcmp(packet->getName(), "LeaseRejected") == 0) {
+        handleLeaseRejected(packet);
+        delete packet;
+        return;
+    }
     
     // Check if this is a service response packet
     bool isServiceResponse = (strstr(packet->getName(), "ServiceResponse") != nullptr);
     
     if (socket == &serviceSocket || isServiceResponse) {
-        EV_WARN << "[DEBUG-SOCKET] Vehicle " << vehicleId << " processing service socket message" << endl;
         // This is a service response from EdgeServer
-        EV_WARN << "[FLOW-6] VEHICLE " << vehicleId << " <- EDGESERVER: Received response packet: " << packet->getName() << endl;
-        
         try {
-            auto payload = packet->peekData<ApplicationPacket>();
-            int sequenceNumber = payload->getSequenceNumber();
-            
-            // Calculate latency if we have the original request time
-            if (pendingRequests.find(sequenceNumber) != pendingRequests.end()) {
-                simtime_t latency = simTime() - pendingRequests[sequenceNumber];
-                emit(serviceLatency, latency.dbl());
-                pendingRequests.erase(sequenceNumber);
-                
-                EV_WARN << "[FLOW-6] VEHICLE " << vehicleId << " <- EDGESERVER: Response received with latency " << (latency.dbl() * 1000) << "ms" << endl;
-                        
-                emit(serviceResponsesReceived, 1);
-            } else {
-                EV_WARN << "[FLOW-6] VEHICLE " << vehicleId << " <- EDGESERVER: No pending request found for sequence " << sequenceNumber << endl;
-            }
+            handleServiceResponse(packet);
         } catch (const std::exception& e) {
-            EV_WARN << "[FLOW-6] VEHICLE " << vehicleId << " <- EDGESERVER: Failed to parse response: " << e.what() << endl;
+            EV_WARN << "[FLOW-6] VEHICLE " << getParentModule()->getIndex() << " <- EDGESERVER: Failed to parse response: " << e.what() << endl;
         }
         delete packet;
     } else {
-        EV_WARN << "[DEBUG-SOCKET] Vehicle " << vehicleId << " delegating to parent socket" << endl;
         // This is the parent's socket - delegate to parent class
         VeinsInetSampleApplication::socketDataArrived(socket, packet);
     }
@@ -384,32 +646,53 @@ void VehicleServiceApp::socketClosed(UdpSocket *socket)
 
 void VehicleServiceApp::handleMessage(cMessage* msg)
 {
-    if (strcmp(msg->getName(), "ipPropagationDelay") == 0) {
-        int vehicleId = getParentModule()->getIndex();
-        EV_WARN << "Vehicle " << vehicleId << " IP propagation delay completed, scheduling first service request" << endl;
-        
-        // Verify IP is still assigned after delay
-        auto interfaceTable = getModuleFromPar<IInterfaceTable>(par("interfaceTableModule"), this);
-        if (interfaceTable) {
-            for (int i = 0; i < interfaceTable->getNumInterfaces(); i++) {
-                auto interface = interfaceTable->getInterface(i);
-                if (interface && strstr(interface->getInterfaceName(), "wlan") != nullptr) {
-                    auto ipv4Data = interface->getProtocolData<Ipv4InterfaceData>();
-                    if (ipv4Data) {
-                        EV_WARN << "Vehicle " << vehicleId << " IP verification after delay: " << ipv4Data->getIPAddress().str() << endl;
-                    }
-                }
-            }
+    if (msg->arrivedOn("directIn")) {
+        // Delivered by the analytic network, as if it had come up through serviceSocket
+        if (analyticNetwork && analyticNetwork->isBound(this)) {
+            socketDataArrived(&serviceSocket, check_and_cast<Packet*>(msg));
+        } else {
+            delete msg;
         }
-        
-        delete msg;
-        
-        // Now schedule the first service request after IP assignment has propagated
-        scheduleNextServiceRequest();
     } else {
         // Handle VeinsInetSampleApplication messages (accident messages, etc.)
         VeinsInetSampleApplication::handleMessage(msg);
     }
 }
 
+std::string VehicleServiceApp::getCheckpointKey() const
+{
+    return mobility ? "vehicle " + mobility->getExternalId() : getFullPath();
+}
+
+void VehicleServiceApp::saveState(std::ostream& out) const
+{
+    out << requestCounter - (int)pendingRequests.size() << " " << nextRequestId << " " << deferredRequests << "\n";
+    if (hasValidLease()) {
+        out << "lease " << leasedServerId << " " << leasedServerAddress.str() << " " << leasedServerPort << " "
+            << (leaseExpiry - simTime()).dbl() << "\n";
+    }
+    else {
+        out << "lease -1\n";
+    }
+    rttEstimator.save(out);
+}
+
+void VehicleServiceApp::restoreState(std::istream& in)
+{
+    std::string label;
+    in >> requestCounter >> nextRequestId >> deferredRequests >> label >> leasedServerId;
+    if (label != "lease") {
+        in.setstate(std::ios::failbit);
+        return;
+    }
+    if (leasedServerId >= 0) {
+        std::string address;
+        double ttl;
+        in >> address >> leasedServerPort >> ttl;
+        leasedServerAddress = L3Address(address.c_str());
+        leaseExpiry = simTime() + ttl;
+    }
+    rttEstimator.restore(in);
+}
+
 } // namespace lasp_ven_simple
\ No newline at end of file
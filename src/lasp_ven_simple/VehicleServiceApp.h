@@ -1,7 +1,13 @@
 #pragma once
 
 #include "../veins_inet/VeinsInetSampleApplication.h"
+#include "AnalyticNetwork.h"
 #include "LASPManager.h"
+#include "LaspCheckpointer.h"
+#include "NodeDirectory.h"
+#include "utils/RttEstimator.h"
+#include "utils/ScopedTimer.h"
+#include "utils/Trace.h"
 #include "inet/transportlayer/contract/udp/UdpSocket.h"
 
 using namespace omnetpp;
@@ -9,48 +15,140 @@ using namespace inet;
 
 namespace lasp_ven_simple {
 
-class VehicleServiceApp : public VeinsInetSampleApplication
+class VehicleServiceApp : public VeinsInetSampleApplication, public ICheckpointable
 {
 private:
     // Service request functionality
     UdpSocket serviceSocket;
+    AnalyticNetwork* analyticNetwork; // replaces serviceSocket for LASP traffic if set
+    NodeDirectory* directory;
+    int servicePort; // from the directory, serviceSocket binds it
     L3Address laspManagerAddress;
     int laspManagerPort;
     double serviceRequestInterval;
     int requestCounter;
     int maxRequests;
+    bool serviceSocketBound;
     int requestSize; // Configurable request size in bytes
     
     // Statistics
     simsignal_t serviceRequestsSent;
     simsignal_t serviceResponsesReceived;
     simsignal_t serviceLatency;
+    LatencyHistogram latencyHistogram; // serviceLatency distribution, merged into the LASPManager at finish()
+    simsignal_t directRequestsSent;
     
-    // Request tracking for latency measurement
-    std::map<int, simtime_t> pendingRequests;
+    // Placement lease handed out by the LASPManager (serverId -1 means none)
+    int leasedServerId;
+    L3Address leasedServerAddress;
+    int leasedServerPort;
+    simtime_t leaseExpiry;
     
-    // Vehicle IP address (assigned programmatically)
+    // Request tracking for latency measurement, keyed by requestId
+    struct PendingRequest {
+        simtime_t sendTime;     // first transmission; latency is measured from here
+        ServiceType serviceType;
+        int attempts;           // retransmissions so far
+        int serverId;           // server the request went to, -1 while unknown
+        bool hedged;            // a duplicate has been sent to a second server
+        veins::TimerManager::TimerHandle timeoutTimer;
+        veins::TimerManager::TimerHandle hedgeTimer;
+    };
+    std::map<long, PendingRequest> pendingRequests;
+    long nextRequestId;
+    int maxInFlight;        // bound on concurrently outstanding requests
+    int deferredRequests;   // requests waiting for a free in-flight slot
+    simsignal_t requestsDeferred;
+    
+    // Request timeouts and retransmission (timeout = RTO * 2^attempts, capped at maxTimeout)
+    RttEstimator rttEstimator;
+    double maxTimeout;
+    int maxRetries;
+    simsignal_t requestRetransmissions;
+    simsignal_t serviceRequestsFailed;
+    
+    // Hedged requests: duplicate a request that is still unanswered after the
+    // hedgeQuantile of recent RTTs to a second server, first response wins
+    bool hedging;
+    double hedgeQuantile;
+    int hedgeMinSamples;
+    simsignal_t hedgedRequests;
+    simsignal_t hedgeWins;
+    simsignal_t duplicateResponses;
+    
+    // Distributed placement: requests are placed here with the greedyLatencyAware
+    // scoring on the load map multicast by the LASPManager and sent straight to the
+    // chosen server; without a recent map they go through the manager as usual
+    bool distributedPlacement;
+    double loadWeight;
+    double latencyWeight;
+    double tieTolerance;
+    L3Address loadMapGroup;
+    simtime_t loadMapTimeout;
+    simtime_t loadMapTime; // arrival of the last load map
+    std::vector<float> loadMapUtilization; // by topology server index, negative if unavailable
+    // Scratch lists of placeOnLoadMap, reused across calls
+    std::vector<EdgeServer> mapServers;
+    std::vector<size_t> mapServerIndices; // topology index of each of mapServers
+    std::vector<const EdgeServer*> mapCandidates;
+    std::vector<ScoredServer> scoredServers;
+    simsignal_t distributedRequestsSent;
+    
+    // Binary trace of per-request events (see utils/Trace.h)
+    TraceBuffer trace;
+    
+    // Wall-clock cost of request handling (enableProfiling), s
+    bool profiling;
+    LatencyHistogram sendServiceRequestTime;
+    LatencyHistogram socketDataArrivedTime;
+    
+    // Vehicle IP address, leased from the node directory
     std::string vehicleIP;
     
 protected:
     virtual bool startApplication() override;
     virtual bool stopApplication() override;
+    virtual void finish() override;
     virtual void processPacket(std::shared_ptr<inet::Packet> pk) override;
     
     // UdpSocket::ICallback interface (inherited from VeinsInetApplicationBase)
     virtual void socketDataArrived(UdpSocket *socket, Packet *packet) override;
     virtual void socketErrorArrived(UdpSocket *socket, Indication *indication) override;
     virtual void socketClosed(UdpSocket *socket) override;
+    virtual void sendPacket(Packet* packet, const L3Address& destAddr, int destPort);
     
     // Service request functionality
     virtual void sendServiceRequest();
     virtual ServiceType selectServiceBasedOnContext();
+    virtual Packet* createServiceRequestPacket(const char* name, long requestId, ServiceType serviceType, int excludeServerId = -1, bool hedged = false);
+    virtual void handleServiceResponse(Packet* packet);
+    virtual bool transmitRequest(long requestId);
+    virtual void handleRequestTimeout(long requestId);
+    virtual void sendHedgedRequest(long requestId);
+    virtual void releaseInFlightSlot();
+    
+    // Placement lease handling
+    virtual bool hasValidLease() const;
+    virtual void handlePlacementLease(Packet* packet);
+    virtual void handleLeaseRejected(Packet* packet);
+    
+    // Distributed placement
+    virtual void handleLoadMap(Packet* packet);
+    virtual int placeOnLoadMap(ServiceType serviceType); // server id, -1 to go through the manager
+    virtual void excludeFromLoadMap(int serverId);
 
     // Service request using Veins timer system
     virtual void scheduleNextServiceRequest();
     
     // Message handling
     virtual void handleMessage(cMessage* msg) override;
+    
+    // Request counters, lease and RTT estimate, keyed by the vehicle's mobility
+    // id so the same vehicle picks them up in a run replaying the trace.
+    // Requests in flight are not saved; they count as not yet sent.
+    virtual std::string getCheckpointKey() const override;
+    virtual void saveState(std::ostream& out) const override;
+    virtual void restoreState(std::istream& in) override;
 
 public:
     VehicleServiceApp();
@@ -5,44 +5,43 @@
 
 namespace lasp_ven_simple {
 
-ServicePlacement* GreedyLatencyAwareStrategy::placeService(const ServiceRequest& request, 
-                                                         const std::map<int, EdgeServer>& edgeServers,
-                                                         double loadWeight,
-                                                         double latencyWeight)
+bool GreedyLatencyAwareStrategy::placeService(const ServiceRequest& request, 
+                                              const std::vector<const EdgeServer*>& candidates,
+                                              const ServiceFootprint& footprint,
+                                              ServicePlacement& placement,
+                                              std::vector<ScoredServer>& scored,
+                                              double loadWeight,
+                                              double latencyWeight,
+                                              cRNG* tieBreaker,
+                                              double tieTolerance)
 {
-    ServicePlacement* bestPlacement = nullptr;
+    scored.clear();
     double bestScore = std::numeric_limits<double>::max();
     
-    EV_WARN << "[LATENCY-AWARE-GREEDY] Processing request from vehicle " << request.vehicleId 
+    EV_DEBUG << "[LATENCY-AWARE-GREEDY] Processing request from vehicle " << request.vehicleId 
             << " with weights - Load: " << loadWeight << ", Latency: " << latencyWeight << endl;
     
-    for (const auto& serverPair : edgeServers) {
-        const EdgeServer& server = serverPair.second;
+    for (const EdgeServer* candidate : candidates) {
+        const EdgeServer& server = *candidate;
         
         // Skip inactive servers
         if (!server.isActive) {
-            EV_WARN << "[LATENCY-AWARE-GREEDY] Server " << server.serverId << " is inactive, skipping" << endl;
+            EV_DEBUG << "[LATENCY-AWARE-GREEDY] Server " << server.serverId << " is inactive, skipping" << endl;
             continue;
         }
         
-        // Check if server supports the service type
-        bool supportsService = false;
-        for (ServiceType service : server.supportedServices) {
-            if (service == request.serviceType) {
-                supportsService = true;
-                break;
-            }
-        }
-        
-        if (!supportsService) {
-            EV_WARN << "[LATENCY-AWARE-GREEDY] Server " << server.serverId << " doesn't support service type" << endl;
+        if (server.serverId == request.excludeServerId) {
             continue;
         }
         
         // Check if server has capacity
         double requiredCapacity = request.dataSize * 0.1; // Simple capacity calculation
         if ((server.currentLoad + requiredCapacity) > server.computeCapacity) {
-            EV_WARN << "[LATENCY-AWARE-GREEDY] Server " << server.serverId << " insufficient capacity" << endl;
+            EV_DEBUG << "[LATENCY-AWARE-GREEDY] Server " << server.serverId << " insufficient capacity" << endl;
+            continue;
+        }
+        if (!ServicePlacementUtils::hasRoomFor(server, footprint)) {
+            EV_DEBUG << "[LATENCY-AWARE-GREEDY] Server " << server.serverId << " has no memory or storage left for an instance" << endl;
             continue;
         }
         
@@ -59,40 +58,46 @@ ServicePlacement* GreedyLatencyAwareStrategy::placeService(const ServiceRequest&
         
         double combinedScore = (latencyWeight * normalizedLatency) + (loadWeight * normalizedLoad);
         
-        EV_WARN << "[LATENCY-AWARE-GREEDY] Server " << server.serverId 
+        EV_DEBUG << "[LATENCY-AWARE-GREEDY] Server " << server.serverId 
                 << " - Latency: " << latency << "ms (norm: " << normalizedLatency 
                 << "), Load: " << (loadUtilization * 100) << "% (norm: " << normalizedLoad 
                 << "), Score: " << combinedScore << endl;
         
-        // Greedy: choose the server with lowest combined score
-        if (combinedScore < bestScore) {
-            bestScore = combinedScore;
-            
-            if (bestPlacement) {
-                delete bestPlacement;
+        scored.push_back(ScoredServer{&server, combinedScore, latency});
+        bestScore = std::min(bestScore, combinedScore);
+    }
+    
+    // Greedy: choose the server with lowest combined score
+    const ScoredServer* best = nullptr;
+    int ties = 0;
+    for (const ScoredServer& candidate : scored) {
+        if (!tieBreaker) {
+            if (candidate.score == bestScore) {
+                best = &candidate;
+                break;
             }
-            
-            bestPlacement = new ServicePlacement();
-            bestPlacement->serviceId = request.vehicleId;
-            bestPlacement->serverId = server.serverId;
-            bestPlacement->serviceType = request.serviceType;
-            bestPlacement->placementTime = simTime().dbl();
-            bestPlacement->estimatedLatency = latency;
-            bestPlacement->resourceUsage = requiredCapacity;
-            
-            EV_WARN << "[LATENCY-AWARE-GREEDY] New best server: " << server.serverId 
-                    << " with score: " << combinedScore << endl;
+        }
+        else if (candidate.score <= bestScore + tieTolerance && intuniform(tieBreaker, 0, ties++) == 0) {
+            best = &candidate; // reservoir sampling over the tied servers
         }
     }
     
-    if (bestPlacement) {
-        EV_WARN << "[LATENCY-AWARE-GREEDY] Selected server " << bestPlacement->serverId 
-                << " with final score: " << bestScore << endl;
-    } else {
-        EV_WARN << "[LATENCY-AWARE-GREEDY] No suitable server found" << endl;
+    if (!best) {
+        EV_DEBUG << "[LATENCY-AWARE-GREEDY] No suitable server found" << endl;
+        return false;
     }
     
-    return bestPlacement;
+    placement = ServicePlacement();
+    placement.serviceId = request.vehicleId;
+    placement.serverId = best->server->serverId;
+    placement.serviceType = request.serviceType;
+    placement.placementTime = simTime().dbl();
+    placement.estimatedLatency = best->latency;
+    placement.resourceUsage = request.dataSize * 0.1;
+    
+    EV_DEBUG << "[LATENCY-AWARE-GREEDY] Selected server " << placement.serverId 
+            << " with final score: " << best->score << endl;
+    return true;
 }
 
 } // namespace lasp_ven_simple
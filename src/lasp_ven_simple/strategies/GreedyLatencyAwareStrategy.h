@@ -2,16 +2,28 @@
 #define GREEDYLATENCYAWAReSTRATEGY_H
 
 #include "../LASPManager.h"
-#include <map>
+#include <vector>
 
 namespace lasp_ven_simple {
 
+// Candidates are the servers hosting the requested service, by server id;
+// footprint is what a new instance of the service would take on them.
+// Without tieBreaker the first server with the lowest score wins; with it,
+// one of the servers scoring within tieTolerance of the lowest is drawn
+// uniformly, so vehicles placing on the same load map spread out. scored is
+// the caller's scratch list, overwritten by every call. Returns false if no
+// candidate fits; placement is only written otherwise.
 class GreedyLatencyAwareStrategy {
 public:
-    static ServicePlacement* placeService(const ServiceRequest& request, 
-                                        const std::map<int, EdgeServer>& edgeServers,
-                                        double loadWeight = 0.5,
-                                        double latencyWeight = 0.5);
+    static bool placeService(const ServiceRequest& request, 
+                             const std::vector<const EdgeServer*>& candidates,
+                             const ServiceFootprint& footprint,
+                             ServicePlacement& placement,
+                             std::vector<ScoredServer>& scored,
+                             double loadWeight = 0.5,
+                             double latencyWeight = 0.5,
+                             cRNG* tieBreaker = nullptr,
+                             double tieTolerance = 0.0);
 };
 
 } // namespace lasp_ven_simple
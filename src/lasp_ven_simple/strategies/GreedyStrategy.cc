@@ -5,34 +5,26 @@
 
 namespace lasp_ven_simple {
 
-ServicePlacement* GreedyStrategy::placeService(const ServiceRequest& request, 
-                                             const std::map<int, EdgeServer>& edgeServers)
+bool GreedyStrategy::placeService(const ServiceRequest& request, 
+                                  const std::vector<const EdgeServer*>& candidates,
+                                  const ServiceFootprint& footprint,
+                                  ServicePlacement& placement)
 {
-    ServicePlacement* bestPlacement = nullptr;
+    const EdgeServer* bestServer = nullptr;
     double bestLatency = std::numeric_limits<double>::max();
+    double requiredCapacity = request.dataSize * 0.1; // Simple capacity calculation
     
-    for (const auto& serverPair : edgeServers) {
-        const EdgeServer& server = serverPair.second;
+    for (const EdgeServer* candidate : candidates) {
+        const EdgeServer& server = *candidate;
         
         // Skip inactive servers
-        if (!server.isActive) continue;
-        
-        // Check if server supports the service type
-        bool supportsService = false;
-        for (ServiceType service : server.supportedServices) {
-            if (service == request.serviceType) {
-                supportsService = true;
-                break;
-            }
-        }
-        
-        if (!supportsService) continue;
+        if (!server.isActive || server.serverId == request.excludeServerId) continue;
         
         // Check if server has capacity
-        double requiredCapacity = request.dataSize * 0.1; // Simple capacity calculation
         if ((server.currentLoad + requiredCapacity) > server.computeCapacity) {
             continue;
         }
+        if (!ServicePlacementUtils::hasRoomFor(server, footprint)) continue;
         
         // Calculate latency for this server
         double latency = ServicePlacementUtils::estimateLatency(request, server);
@@ -40,22 +32,21 @@ ServicePlacement* GreedyStrategy::placeService(const ServiceRequest& request,
         // Greedy: choose the server with lowest latency
         if (latency < bestLatency) {
             bestLatency = latency;
-            
-            if (bestPlacement) {
-                delete bestPlacement;
-            }
-            
-            bestPlacement = new ServicePlacement();
-            bestPlacement->serviceId = request.vehicleId;
-            bestPlacement->serverId = server.serverId;
-            bestPlacement->serviceType = request.serviceType;
-            bestPlacement->placementTime = simTime().dbl();
-            bestPlacement->estimatedLatency = latency;
-            bestPlacement->resourceUsage = requiredCapacity;
+            bestServer = &server;
         }
     }
     
-    return bestPlacement;
+    if (!bestServer) {
+        return false;
+    }
+    placement = ServicePlacement();
+    placement.serviceId = request.vehicleId;
+    placement.serverId = bestServer->serverId;
+    placement.serviceType = request.serviceType;
+    placement.placementTime = simTime().dbl();
+    placement.estimatedLatency = bestLatency;
+    placement.resourceUsage = requiredCapacity;
+    return true;
 }
 
 } // namespace lasp_ven_simple 
\ No newline at end of file
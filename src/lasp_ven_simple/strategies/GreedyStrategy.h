@@ -2,14 +2,19 @@
 #define GREEDYSTRATEGY_H
 
 #include "../LASPManager.h"
-#include <map>
+#include <vector>
 
 namespace lasp_ven_simple {
 
+// Candidates are the servers hosting the requested service, by server id;
+// footprint is what a new instance of the service would take on them.
+// Returns false if no candidate fits; placement is only written otherwise.
 class GreedyStrategy {
 public:
-    static ServicePlacement* placeService(const ServiceRequest& request, 
-                                        const std::map<int, EdgeServer>& edgeServers);
+    static bool placeService(const ServiceRequest& request, 
+                             const std::vector<const EdgeServer*>& candidates,
+                             const ServiceFootprint& footprint,
+                             ServicePlacement& placement);
 };
 
 } // namespace lasp_ven_simple
@@ -2,135 +2,106 @@
 #include "../utils/ServicePlacementUtils.h"
 #include <algorithm>
 #include <limits>
-#include <vector>
 
 namespace lasp_ven_simple {
 
-ServicePlacement* ThresholdLatencyAwareStrategy::placeService(
+bool ThresholdLatencyAwareStrategy::placeService(
     const ServiceRequest& request,
-    const std::map<int, EdgeServer>& edgeServers,
+    const std::vector<const EdgeServer*>& candidates,
+    const ServiceFootprint& footprint,
+    ServicePlacement& placement,
     double loadThreshold,
     double loadWeight,
     double latencyWeight) {
     
-    ServicePlacement* bestPlacement = nullptr;
+    const EdgeServer* bestServer = nullptr;
     double bestScore = std::numeric_limits<double>::max();
+    double bestLatency = 0.0;
     
-    EV_WARN << "[LATENCY-AWARE-THRESHOLD] Processing request from vehicle " << request.vehicleId 
+    EV_DEBUG << "[LATENCY-AWARE-THRESHOLD] Processing request from vehicle " << request.vehicleId 
             << " with threshold: " << loadThreshold 
             << ", weights - Load: " << loadWeight << ", Latency: " << latencyWeight << endl;
     
-    // First pass: collect servers under threshold
-    std::vector<std::pair<int, const EdgeServer*>> eligibleServers;
-    
-    for (const auto& serverPair : edgeServers) {
-        int serverId = serverPair.first;
-        const EdgeServer& server = serverPair.second;
-        
-        // Check basic eligibility
-        if (!server.isActive) {
-            EV_WARN << "[LATENCY-AWARE-THRESHOLD] Server " << serverId << " is inactive, skipping" << endl;
-            continue;
-        }
-        
-        // Calculate current utilization
-        double utilization = server.currentLoad / server.computeCapacity;
-        if (utilization > loadThreshold) {
-            EV_WARN << "[LATENCY-AWARE-THRESHOLD] Server " << serverId 
-                    << " above threshold: " << (utilization * 100) << "% > " << (loadThreshold * 100) << "%" << endl;
-            continue;
-        }
-        
-        // Check if server supports the requested service
-        auto serviceIt = std::find(server.supportedServices.begin(), 
-                                 server.supportedServices.end(), 
-                                 request.serviceType);
-        if (serviceIt == server.supportedServices.end()) {
-            EV_WARN << "[LATENCY-AWARE-THRESHOLD] Server " << serverId << " doesn't support service type" << endl;
-            continue;
-        }
-        
-        // Check resource availability
-        if (server.currentLoad + request.dataSize > server.computeCapacity) {
-            EV_WARN << "[LATENCY-AWARE-THRESHOLD] Server " << serverId << " insufficient capacity" << endl;
-            continue;
+    // First pass: servers under threshold only; if there are none, a second
+    // pass falls back to the greedy approach with all servers
+    for (int pass = 0; pass < 2 && !bestServer; pass++) {
+        if (pass == 1) {
+            EV_DEBUG << "[LATENCY-AWARE-THRESHOLD] No servers under threshold, falling back to greedy approach" << endl;
         }
-        
-        eligibleServers.push_back({serverId, &server});
-        EV_WARN << "[LATENCY-AWARE-THRESHOLD] Server " << serverId << " is eligible (util: " 
-                << (utilization * 100) << "%)" << endl;
-    }
-    
-    // If no servers under threshold, fall back to greedy approach with all servers
-    if (eligibleServers.empty()) {
-        EV_WARN << "[LATENCY-AWARE-THRESHOLD] No servers under threshold, falling back to greedy approach" << endl;
-        
-        for (const auto& serverPair : edgeServers) {
-            int serverId = serverPair.first;
-            const EdgeServer& server = serverPair.second;
+        for (const EdgeServer* candidate : candidates) {
+            const EdgeServer& server = *candidate;
+            int serverId = server.serverId;
             
-            if (!server.isActive) continue;
+            // Check basic eligibility
+            if (!server.isActive) {
+                EV_DEBUG << "[LATENCY-AWARE-THRESHOLD] Server " << serverId << " is inactive, skipping" << endl;
+                continue;
+            }
             
-            // Check service support and capacity
-            auto serviceIt = std::find(server.supportedServices.begin(), 
-                                     server.supportedServices.end(), 
-                                     request.serviceType);
-            if (serviceIt == server.supportedServices.end()) continue;
+            if (serverId == request.excludeServerId) {
+                continue;
+            }
             
-            if (server.currentLoad + request.dataSize > server.computeCapacity) continue;
+            // Calculate current utilization
+            double loadUtilization = server.currentLoad / server.computeCapacity;
+            if (pass == 0 && loadUtilization > loadThreshold) {
+                EV_DEBUG << "[LATENCY-AWARE-THRESHOLD] Server " << serverId 
+                        << " above threshold: " << (loadUtilization * 100) << "% > " << (loadThreshold * 100) << "%" << endl;
+                continue;
+            }
             
-            eligibleServers.push_back({serverId, &server});
-        }
-    }
-    
-    // Second pass: evaluate eligible servers using combined metrics
-    for (const auto& serverInfo : eligibleServers) {
-        int serverId = serverInfo.first;
-        const EdgeServer& server = *serverInfo.second;
-        
-        // Calculate latency for this server
-        double latency = ServicePlacementUtils::estimateLatency(request, server);
-        
-        // Calculate load utilization
-        double loadUtilization = server.currentLoad / server.computeCapacity;
-        
-        // Calculate combined score (lower is better)
-        // Normalize both metrics to 0-1 range and apply weights
-        double normalizedLatency = std::min(latency / 100.0, 1.0); // Normalize to 0-1, cap at 100ms
-        double normalizedLoad = loadUtilization; // Already 0-1
-        
-        double combinedScore = (latencyWeight * normalizedLatency) + (loadWeight * normalizedLoad);
-        
-        EV_WARN << "[LATENCY-AWARE-THRESHOLD] Server " << serverId 
-                << " - Latency: " << latency << "ms (norm: " << normalizedLatency 
-                << "), Load: " << (loadUtilization * 100) << "% (norm: " << normalizedLoad 
-                << "), Score: " << combinedScore << endl;
-        
-        if (combinedScore < bestScore) {
-            bestScore = combinedScore;
+            // Check resource availability
+            if (server.currentLoad + request.dataSize > server.computeCapacity) {
+                EV_DEBUG << "[LATENCY-AWARE-THRESHOLD] Server " << serverId << " insufficient capacity" << endl;
+                continue;
+            }
+            if (!ServicePlacementUtils::hasRoomFor(server, footprint)) {
+                EV_DEBUG << "[LATENCY-AWARE-THRESHOLD] Server " << serverId << " has no memory or storage left for an instance" << endl;
+                continue;
+            }
+            
+            // Calculate latency for this server
+            double latency = ServicePlacementUtils::estimateLatency(request, server);
             
-            if (bestPlacement) delete bestPlacement;
-            bestPlacement = new ServicePlacement();
-            bestPlacement->serviceId = request.vehicleId;
-            bestPlacement->serverId = serverId;
-            bestPlacement->serviceType = request.serviceType;
-            bestPlacement->placementTime = simTime().dbl();
-            bestPlacement->estimatedLatency = latency;
-            bestPlacement->resourceUsage = request.dataSize;
+            // Calculate combined score (lower is better)
+            // Normalize both metrics to 0-1 range and apply weights
+            double normalizedLatency = std::min(latency / 100.0, 1.0); // Normalize to 0-1, cap at 100ms
+            double normalizedLoad = loadUtilization; // Already 0-1
             
-            EV_WARN << "[LATENCY-AWARE-THRESHOLD] New best server: " << serverId 
-                    << " with score: " << combinedScore << endl;
+            double combinedScore = (latencyWeight * normalizedLatency) + (loadWeight * normalizedLoad);
+            
+            EV_DEBUG << "[LATENCY-AWARE-THRESHOLD] Server " << serverId 
+                    << " - Latency: " << latency << "ms (norm: " << normalizedLatency 
+                    << "), Load: " << (loadUtilization * 100) << "% (norm: " << normalizedLoad 
+                    << "), Score: " << combinedScore << endl;
+            
+            if (combinedScore < bestScore) {
+                bestScore = combinedScore;
+                bestLatency = latency;
+                bestServer = &server;
+                
+                EV_DEBUG << "[LATENCY-AWARE-THRESHOLD] New best server: " << serverId 
+                        << " with score: " << combinedScore << endl;
+            }
         }
     }
     
-    if (bestPlacement) {
-        EV_WARN << "[LATENCY-AWARE-THRESHOLD] Selected server " << bestPlacement->serverId 
-                << " with final score: " << bestScore << endl;
-    } else {
-        EV_WARN << "[LATENCY-AWARE-THRESHOLD] No suitable server found" << endl;
+    if (!bestServer) {
+        EV_DEBUG << "[LATENCY-AWARE-THRESHOLD] No suitable server found" << endl;
+        return false;
     }
     
-    return bestPlacement;
+    placement = ServicePlacement();
+    placement.serviceId = request.vehicleId;
+    placement.serverId = bestServer->serverId;
+    placement.serviceType = request.serviceType;
+    placement.placementTime = simTime().dbl();
+    placement.estimatedLatency = bestLatency;
+    placement.resourceUsage = request.dataSize;
+    
+    EV_DEBUG << "[LATENCY-AWARE-THRESHOLD] Selected server " << placement.serverId 
+            << " with final score: " << bestScore << endl;
+    return true;
 }
 
 } // namespace lasp_ven_simple
@@ -6,33 +6,31 @@
 
 namespace lasp_ven_simple {
 
-ServicePlacement* ThresholdStrategy::placeService(
+bool ThresholdStrategy::placeService(
     const ServiceRequest& request,
-    const std::map<int, EdgeServer>& edgeServers,
+    const std::vector<const EdgeServer*>& candidates,
+    const ServiceFootprint& footprint,
+    ServicePlacement& placement,
     double loadThreshold) {
     
-    ServicePlacement* bestPlacement = nullptr;
+    const EdgeServer* bestServer = nullptr;
     double bestScore = std::numeric_limits<double>::max();
+    double bestLatency = 0.0;
     
-    for (const auto& serverPair : edgeServers) {
-        int serverId = serverPair.first;
-        const EdgeServer& server = serverPair.second;
+    for (const EdgeServer* candidate : candidates) {
+        const EdgeServer& server = *candidate;
+        int serverId = server.serverId;
         
         // Check basic eligibility
-        if (!server.isActive) continue;
+        if (!server.isActive || serverId == request.excludeServerId) continue;
         
         // Calculate current utilization
         double utilization = server.currentLoad / server.computeCapacity;
         if (utilization > loadThreshold) continue;
         
-        // Check if server supports the requested service
-        auto serviceIt = std::find(server.supportedServices.begin(), 
-                                 server.supportedServices.end(), 
-                                 request.serviceType);
-        if (serviceIt == server.supportedServices.end()) continue;
-        
         // Check resource availability
         if (server.currentLoad + request.dataSize > server.computeCapacity) continue;
+        if (!ServicePlacementUtils::hasRoomFor(server, footprint)) continue;
         
         // Calculate placement score (lower is better)
         double latency = ServicePlacementUtils::estimateLatency(request, server);
@@ -43,19 +41,22 @@ ServicePlacement* ThresholdStrategy::placeService(
         
         if (score < bestScore) {
             bestScore = score;
-            
-            if (bestPlacement) delete bestPlacement;
-            bestPlacement = new ServicePlacement();
-            bestPlacement->serviceId = request.vehicleId;
-            bestPlacement->serverId = serverId;
-            bestPlacement->serviceType = request.serviceType;
-            bestPlacement->placementTime = simTime().dbl();
-            bestPlacement->estimatedLatency = latency;
-            bestPlacement->resourceUsage = request.dataSize;
+            bestLatency = latency;
+            bestServer = &server;
         }
     }
     
-    return bestPlacement;
+    if (!bestServer) {
+        return false;
+    }
+    placement = ServicePlacement();
+    placement.serviceId = request.vehicleId;
+    placement.serverId = bestServer->serverId;
+    placement.serviceType = request.serviceType;
+    placement.placementTime = simTime().dbl();
+    placement.estimatedLatency = bestLatency;
+    placement.resourceUsage = request.dataSize;
+    return true;
 }
 
 } // namespace lasp_ven_simple 
\ No newline at end of file
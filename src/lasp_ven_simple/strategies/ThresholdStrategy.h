@@ -2,15 +2,20 @@
 #define THRESHOLDSTRATEGY_H
 
 #include "../LASPManager.h"
-#include <map>
+#include <vector>
 
 namespace lasp_ven_simple {
 
+// Candidates are the servers hosting the requested service, by server id;
+// footprint is what a new instance of the service would take on them.
+// Returns false if no candidate fits; placement is only written otherwise.
 class ThresholdStrategy {
 public:
-    static ServicePlacement* placeService(
+    static bool placeService(
         const ServiceRequest& request,
-        const std::map<int, EdgeServer>& edgeServers,
+        const std::vector<const EdgeServer*>& candidates,
+        const ServiceFootprint& footprint,
+        ServicePlacement& placement,
         double loadThreshold = 0.8);
 };
 
@@ -0,0 +1,55 @@
+#include "AnalyticLinkModel.h"
+#include <algorithm>
+#include <cmath>
+
+namespace lasp_ven_simple {
+
+AnalyticLinkModel::AnalyticLinkModel()
+{
+    configure(1e-3, 2e6, 2e6, 500.0, 299792458.0, 1.0, 0.95);
+}
+
+void AnalyticLinkModel::configure(double baseDelay, double bitrate, double minBitrate, double range,
+        double propagationSpeed, double loadWindow, double maxUtilization)
+{
+    this->baseDelay = baseDelay;
+    this->bitrate = bitrate;
+    this->minBitrate = std::min(minBitrate, bitrate);
+    this->range = range;
+    this->propagationSpeed = propagationSpeed;
+    this->loadWindow = loadWindow;
+    this->maxUtilization = std::min(std::max(maxUtilization, 0.0), 0.999);
+    offeredBits = 0.0;
+    lastUpdate = 0.0;
+}
+
+double AnalyticLinkModel::getBitrate(double distance) const
+{
+    if (range <= 0.0 || distance >= range) {
+        return minBitrate;
+    }
+    return bitrate - (bitrate - minBitrate) * distance / range;
+}
+
+double AnalyticLinkModel::getUtilization(double now) const
+{
+    if (loadWindow <= 0.0) {
+        return 0.0;
+    }
+    // offeredBits / loadWindow is the offered rate of an exponential moving average
+    double decayed = offeredBits * std::exp(-(now - lastUpdate) / loadWindow);
+    return std::min(decayed / loadWindow / bitrate, maxUtilization);
+}
+
+double AnalyticLinkModel::transmit(double distance, double bits, double now)
+{
+    double rho = getUtilization(now);
+    if (loadWindow > 0.0) {
+        offeredBits = offeredBits * std::exp(-(now - lastUpdate) / loadWindow) + bits;
+        lastUpdate = now;
+    }
+    double txTime = bits / getBitrate(distance);
+    return baseDelay + distance / propagationSpeed + txTime / (1.0 - rho);
+}
+
+} // namespace lasp_ven_simple
@@ -0,0 +1,46 @@
+#ifndef ANALYTICLINKMODEL_H
+#define ANALYTICLINKMODEL_H
+
+namespace lasp_ven_simple {
+
+// One-hop delay of a shared wireless channel, used in place of the packet-level
+// UDP/IPv4/CsmaCa stack when only the placement behaviour matters:
+//
+//   delay = baseDelay + distance / propagationSpeed + txTime / (1 - rho)
+//
+// txTime is the packet size over the rate at that distance, which falls
+// linearly from bitrate next to the sender to minBitrate at range and stays
+// there beyond it. rho is the utilization of the channel by the traffic
+// offered to it, averaged with time constant loadWindow and capped at
+// maxUtilization, so the queueing term (M/M/1 style) stays finite.
+// Times are in s, distances in m, rates in bit/s.
+class AnalyticLinkModel {
+public:
+    AnalyticLinkModel();
+
+    void configure(double baseDelay, double bitrate, double minBitrate, double range,
+            double propagationSpeed, double loadWindow, double maxUtilization);
+
+    // Delay of a packet of `bits` sent at `now`; the packet is added to the
+    // offered load, so calls must come in non-decreasing `now`
+    double transmit(double distance, double bits, double now);
+
+    double getBitrate(double distance) const;
+    double getUtilization(double now) const;
+
+private:
+    double baseDelay;
+    double bitrate;
+    double minBitrate;
+    double range;
+    double propagationSpeed;
+    double loadWindow;
+    double maxUtilization;
+
+    double offeredBits; // exponentially decayed sum of the bits sent so far
+    double lastUpdate;
+};
+
+} // namespace lasp_ven_simple
+
+#endif // ANALYTICLINKMODEL_H
@@ -0,0 +1,83 @@
+#include "Checkpoint.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+namespace lasp_ven_simple {
+
+static const char* const CHECKPOINT_MAGIC = "LASP-CHECKPOINT";
+static const int CHECKPOINT_VERSION = 1;
+
+void Checkpoint::setTime(double simTime, double traceTime)
+{
+    time = simTime;
+    this->traceTime = traceTime;
+}
+
+const std::string* Checkpoint::getSection(const std::string& key) const
+{
+    auto it = sections.find(key);
+    return it != sections.end() ? &it->second : nullptr;
+}
+
+void Checkpoint::write(const std::string& file) const
+{
+    // Written next to the target and renamed, so a crashed run never leaves half a checkpoint
+    std::string tmpFile = file + ".tmp";
+    {
+        std::ofstream out(tmpFile, std::ios::binary);
+        if (!out) {
+            throw std::runtime_error("cannot create checkpoint file " + tmpFile);
+        }
+        out.precision(std::numeric_limits<double>::max_digits10);
+        out << CHECKPOINT_MAGIC << " " << CHECKPOINT_VERSION << "\n";
+        out << "time " << time << " traceTime " << traceTime << "\n";
+        out << "sections " << sections.size() << "\n";
+        for (const auto& section : sections) {
+            out << section.first.size() << " " << section.second.size() << "\n"
+                << section.first << section.second << "\n";
+        }
+        if (!out) {
+            throw std::runtime_error("error writing checkpoint file " + tmpFile);
+        }
+    }
+    if (std::rename(tmpFile.c_str(), file.c_str()) != 0) {
+        throw std::runtime_error("cannot rename " + tmpFile + " to " + file);
+    }
+}
+
+void Checkpoint::read(const std::string& file)
+{
+    std::ifstream in(file, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("cannot open checkpoint file " + file);
+    }
+    std::string magic, timeLabel, traceTimeLabel, sectionsLabel;
+    int version = 0;
+    size_t numSections = 0;
+    in >> magic >> version >> timeLabel >> time >> traceTimeLabel >> traceTime >> sectionsLabel >> numSections;
+    if (!in || magic != CHECKPOINT_MAGIC || timeLabel != "time" || traceTimeLabel != "traceTime" || sectionsLabel != "sections") {
+        throw std::runtime_error(file + " is not a LASP checkpoint");
+    }
+    if (version != CHECKPOINT_VERSION) {
+        throw std::runtime_error(file + ": unsupported checkpoint version " + std::to_string(version));
+    }
+
+    sections.clear();
+    for (size_t i = 0; i < numSections; i++) {
+        size_t keyLength = 0, dataLength = 0;
+        in >> keyLength >> dataLength;
+        in.ignore(1); // newline after the lengths
+        std::string key(keyLength, '\0'), data(dataLength, '\0');
+        in.read(&key[0], keyLength);
+        in.read(&data[0], dataLength);
+        if (!in) {
+            throw std::runtime_error(file + ": truncated checkpoint, section " + std::to_string(i));
+        }
+        sections[key] = data;
+    }
+}
+
+} // namespace lasp_ven_simple
@@ -0,0 +1,40 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstddef>
+#include <map>
+#include <string>
+
+namespace lasp_ven_simple {
+
+// Saved state of the LASP modules of a run: one text section per module,
+// plus the simulation time and mobility trace time the state was taken at.
+// Modules write and parse their own sections; the file stores every section
+// length-prefixed, so any content round-trips.
+class Checkpoint {
+public:
+    Checkpoint() : time(0.0), traceTime(0.0) {}
+
+    void setTime(double simTime, double traceTime);
+    double getTime() const { return time; }
+    // Mobility trace time of the state, where a replay of the trace resumes
+    double getTraceTime() const { return traceTime; }
+
+    void setSection(const std::string& key, const std::string& data) { sections[key] = data; }
+    // nullptr if there is no section with this key
+    const std::string* getSection(const std::string& key) const;
+    size_t getNumSections() const { return sections.size(); }
+
+    // Both throw std::runtime_error on I/O and format errors
+    void write(const std::string& file) const;
+    void read(const std::string& file);
+
+private:
+    double time;
+    double traceTime;
+    std::map<std::string, std::string> sections;
+};
+
+} // namespace lasp_ven_simple
+
+#endif // CHECKPOINT_H
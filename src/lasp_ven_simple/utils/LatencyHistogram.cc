@@ -0,0 +1,129 @@
+#include "LatencyHistogram.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace lasp_ven_simple {
+
+LatencyHistogram::LatencyHistogram(double resolution, int significantDigits, double highestTrackable)
+    : resolution(resolution), significantDigits(significantDigits)
+{
+    if (resolution <= 0.0 || significantDigits < 1 || significantDigits > 5 || highestTrackable <= resolution) {
+        throw std::invalid_argument("LatencyHistogram: invalid configuration");
+    }
+    highestTicks = (uint64_t)std::ceil(highestTrackable / resolution);
+
+    // Enough linear sub-buckets to tell apart 2 * 10^digits values within one power of two
+    uint64_t largestSingleUnit = 2 * (uint64_t)std::pow(10.0, significantDigits);
+    subBucketBits = (int)std::ceil(std::log2((double)largestSingleUnit));
+    subBucketHalfCount = (uint64_t)1 << (subBucketBits - 1);
+
+    reset();
+}
+
+void LatencyHistogram::reset()
+{
+    counts.clear();
+    totalCount = 0;
+    saturatedCount = 0;
+    sum = 0.0;
+    minValue = 0.0;
+    maxValue = 0.0;
+}
+
+size_t LatencyHistogram::indexOf(uint64_t ticks) const
+{
+    // Values below 2^subBucketBits map linearly; above that each power of two is
+    // split into subBucketHalfCount buckets of width 2^shift
+    int msb = 0;
+    for (uint64_t v = ticks; v > 1; v >>= 1) {
+        msb++;
+    }
+    int shift = std::max(0, msb - (subBucketBits - 1));
+    return (size_t)(shift * subBucketHalfCount + (ticks >> shift));
+}
+
+uint64_t LatencyHistogram::highestEquivalentTicks(size_t index) const
+{
+    uint64_t subBucketCount = subBucketHalfCount * 2;
+    if (index < subBucketCount) {
+        return index;
+    }
+    uint64_t shift = index / subBucketHalfCount - 1;
+    uint64_t subBucket = index - shift * subBucketHalfCount;
+    return (subBucket << shift) + ((uint64_t)1 << shift) - 1;
+}
+
+void LatencyHistogram::record(double value)
+{
+    value = std::max(value, 0.0);
+    uint64_t ticks = (uint64_t)std::llround(value / resolution);
+    if (ticks > highestTicks) {
+        ticks = highestTicks;
+        saturatedCount++;
+    }
+
+    size_t index = indexOf(ticks);
+    if (index >= counts.size()) {
+        counts.resize(index + 1, 0);
+    }
+    counts[index]++;
+
+    if (totalCount == 0 || value < minValue) {
+        minValue = value;
+    }
+    if (totalCount == 0 || value > maxValue) {
+        maxValue = value;
+    }
+    totalCount++;
+    sum += value;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+    if (other.resolution != resolution || other.significantDigits != significantDigits || other.highestTicks != highestTicks) {
+        throw std::invalid_argument("LatencyHistogram: cannot merge histograms with different configurations");
+    }
+    if (other.totalCount == 0) {
+        return;
+    }
+
+    if (other.counts.size() > counts.size()) {
+        counts.resize(other.counts.size(), 0);
+    }
+    for (size_t i = 0; i < other.counts.size(); i++) {
+        counts[i] += other.counts[i];
+    }
+
+    if (totalCount == 0 || other.minValue < minValue) {
+        minValue = other.minValue;
+    }
+    if (totalCount == 0 || other.maxValue > maxValue) {
+        maxValue = other.maxValue;
+    }
+    totalCount += other.totalCount;
+    saturatedCount += other.saturatedCount;
+    sum += other.sum;
+}
+
+double LatencyHistogram::getPercentile(double percentile) const
+{
+    if (totalCount == 0) {
+        return 0.0;
+    }
+
+    double q = std::min(std::max(percentile, 0.0), 100.0) / 100.0;
+    uint64_t target = std::max((uint64_t)1, (uint64_t)std::ceil(q * totalCount));
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        cumulative += counts[i];
+        if (cumulative >= target) {
+            // Never report beyond the exact extremes we have seen
+            double value = highestEquivalentTicks(i) * resolution;
+            return std::min(std::max(value, minValue), maxValue);
+        }
+    }
+    return maxValue;
+}
+
+} // namespace lasp_ven_simple
@@ -0,0 +1,64 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lasp_ven_simple {
+
+// HDR-style log-linear histogram for latency values.
+// Values are quantized to `resolution` and bucketed so that every recorded value
+// keeps `significantDigits` decimal digits of precision. Memory depends only on
+// the configured range (a few KB for 1us..1h at 2 digits), never on the sample
+// count. Histograms with the same configuration can be merged.
+class LatencyHistogram {
+public:
+    LatencyHistogram(double resolution = 1e-6, int significantDigits = 2, double highestTrackable = 3600.0);
+
+    void record(double value);
+    void merge(const LatencyHistogram& other);
+    void reset();
+
+    // Percentile in 0..100; returns the highest value equivalent to the bucket holding it
+    double getPercentile(double percentile) const;
+    double getMean() const { return totalCount > 0 ? sum / totalCount : 0.0; }
+    double getMin() const { return totalCount > 0 ? minValue : 0.0; }
+    double getMax() const { return totalCount > 0 ? maxValue : 0.0; }
+    uint64_t getCount() const { return totalCount; }
+    uint64_t getSaturatedCount() const { return saturatedCount; }
+
+    // Records <name>:count, :mean, :p50, :p99, :p99.9 and :max as scalars of the
+    // given OMNeT++ component (kept a template so this header stays simulator-free)
+    template<typename Component>
+    void recordScalars(Component* component, const std::string& name) const
+    {
+        component->recordScalar((name + ":count").c_str(), (double)totalCount);
+        component->recordScalar((name + ":mean").c_str(), getMean());
+        component->recordScalar((name + ":p50").c_str(), getPercentile(50.0));
+        component->recordScalar((name + ":p99").c_str(), getPercentile(99.0));
+        component->recordScalar((name + ":p99.9").c_str(), getPercentile(99.9));
+        component->recordScalar((name + ":max").c_str(), getMax());
+    }
+
+private:
+    size_t indexOf(uint64_t ticks) const;
+    uint64_t highestEquivalentTicks(size_t index) const;
+
+    double resolution;
+    int significantDigits;
+    uint64_t highestTicks;
+    int subBucketBits;      // log2 of the number of linear sub-buckets per power of two
+    uint64_t subBucketHalfCount;
+
+    std::vector<uint64_t> counts; // grown on demand up to indexOf(highestTicks)
+    uint64_t totalCount;
+    uint64_t saturatedCount;      // values clamped to highestTrackable
+    double sum;
+    double minValue;
+    double maxValue;
+};
+
+} // namespace lasp_ven_simple
+
+#endif // LATENCYHISTOGRAM_H
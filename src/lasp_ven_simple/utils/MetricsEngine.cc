@@ -0,0 +1,162 @@
+#include "MetricsEngine.h"
+#include <algorithm>
+#include <cmath>
+
+namespace lasp_ven_simple {
+
+void RunningStats::add(double value)
+{
+    count++;
+    double delta = value - mean;
+    mean += delta / count;
+    m2 += delta * (value - mean);
+}
+
+void RunningStats::remove(double value)
+{
+    if (count <= 1) {
+        reset();
+        return;
+    }
+    double oldMean = mean;
+    count--;
+    mean = (oldMean * (count + 1) - value) / count;
+    m2 -= (value - oldMean) * (value - mean);
+    m2 = std::max(m2, 0.0); // rounding after many removals
+}
+
+void RunningStats::replace(double oldValue, double newValue)
+{
+    remove(oldValue);
+    add(newValue);
+}
+
+void RunningStats::reset()
+{
+    count = 0;
+    mean = 0.0;
+    m2 = 0.0;
+}
+
+double RunningStats::getStddev() const
+{
+    return std::sqrt(getVariance());
+}
+
+SlidingWindow::SlidingWindow(double length, int numBuckets)
+{
+    numBuckets = std::max(numBuckets, 1);
+    bucketLength = length / numBuckets;
+    sums.assign(numBuckets, 0.0);
+    counts.assign(numBuckets, 0);
+    windowSum = 0.0;
+    windowCount = 0;
+    currentBucket = 0;
+}
+
+void SlidingWindow::advance(double now)
+{
+    int64_t bucket = (int64_t)std::floor(now / bucketLength);
+    if (bucket <= currentBucket) {
+        return;
+    }
+    int64_t n = (int64_t)sums.size();
+    if (bucket - currentBucket >= n) {
+        std::fill(sums.begin(), sums.end(), 0.0);
+        std::fill(counts.begin(), counts.end(), 0);
+        windowSum = 0.0;
+        windowCount = 0;
+    }
+    else {
+        for (int64_t b = currentBucket + 1; b <= bucket; b++) {
+            size_t slot = (size_t)(b % n);
+            windowSum -= sums[slot];
+            windowCount -= counts[slot];
+            sums[slot] = 0.0;
+            counts[slot] = 0;
+        }
+    }
+    currentBucket = bucket;
+}
+
+void SlidingWindow::add(double now, double value)
+{
+    advance(now);
+    size_t slot = (size_t)(currentBucket % (int64_t)sums.size());
+    sums[slot] += value;
+    counts[slot]++;
+    windowSum += value;
+    windowCount++;
+}
+
+double SlidingWindow::getSum(double now)
+{
+    advance(now);
+    return windowSum;
+}
+
+uint64_t SlidingWindow::getCount(double now)
+{
+    advance(now);
+    return windowCount;
+}
+
+double SlidingWindow::getMean(double now)
+{
+    advance(now);
+    return windowCount > 0 ? windowSum / windowCount : 0.0;
+}
+
+void MetricsEngine::configure(double windowLength, int numBuckets)
+{
+    requestsReceived = 0;
+    requestsServed = 0;
+    receivedWindow = SlidingWindow(windowLength, numBuckets);
+    servedWindow = SlidingWindow(windowLength, numBuckets);
+    serverUtilization.clear();
+    utilization.reset();
+    utilizationWindow = SlidingWindow(windowLength, numBuckets);
+    efficiencyWindow = SlidingWindow(windowLength, numBuckets);
+}
+
+void MetricsEngine::recordRequest(double now, bool served)
+{
+    requestsReceived++;
+    receivedWindow.add(now, 1.0);
+    if (served) {
+        requestsServed++;
+        servedWindow.add(now, 1.0);
+    }
+}
+
+void MetricsEngine::setServerUtilization(int serverId, double value)
+{
+    auto it = serverUtilization.find(serverId);
+    if (it == serverUtilization.end()) {
+        serverUtilization[serverId] = value;
+        utilization.add(value);
+    }
+    else if (it->second != value) {
+        utilization.replace(it->second, value);
+        it->second = value;
+    }
+}
+
+void MetricsEngine::sampleServers(double now)
+{
+    if (serverUtilization.empty()) {
+        return;
+    }
+    utilizationWindow.add(now, getUtilization());
+    if (serverUtilization.size() > 1) {
+        efficiencyWindow.add(now, getLoadBalancingEfficiency());
+    }
+}
+
+double MetricsEngine::getWindowedSuccessRate(double now)
+{
+    uint64_t received = receivedWindow.getCount(now);
+    return received > 0 ? (double)servedWindow.getCount(now) / received : 0.0;
+}
+
+} // namespace lasp_ven_simple
@@ -0,0 +1,98 @@
+#ifndef METRICSENGINE_H
+#define METRICSENGINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace lasp_ven_simple {
+
+// Welford running mean and population variance. Values can also be removed,
+// so the statistics of a changing population (e.g. one utilization per
+// server) are kept up to date in O(1) per change.
+class RunningStats {
+public:
+    RunningStats() { reset(); }
+
+    void add(double value);
+    void remove(double value); // value must have been added before
+    void replace(double oldValue, double newValue);
+    void reset();
+
+    uint64_t getCount() const { return count; }
+    double getMean() const { return count > 0 ? mean : 0.0; }
+    double getVariance() const { return count > 0 ? m2 / count : 0.0; }
+    double getStddev() const;
+
+private:
+    uint64_t count;
+    double mean;
+    double m2;
+};
+
+// Sum and count of the values added during the last `length` seconds,
+// kept in a ring of `numBuckets` buckets, so a window ages by clearing
+// buckets instead of revisiting values. Times must not decrease.
+class SlidingWindow {
+public:
+    SlidingWindow(double length = 10.0, int numBuckets = 10);
+
+    void add(double now, double value);
+    double getSum(double now);
+    uint64_t getCount(double now);
+    double getMean(double now);
+
+private:
+    void advance(double now);
+
+    double bucketLength;
+    std::vector<double> sums;
+    std::vector<uint64_t> counts;
+    double windowSum;
+    uint64_t windowCount;
+    int64_t currentBucket; // absolute bucket number of the newest bucket
+};
+
+// Per-manager placement metrics. Request outcomes and per-server utilization
+// are folded in as they change; every getter is O(1) and never needs the
+// placement list.
+class MetricsEngine {
+public:
+    MetricsEngine() { configure(10.0, 10); }
+
+    // Resets all metrics
+    void configure(double windowLength, int numBuckets);
+
+    void recordRequest(double now, bool served);
+    void setServerUtilization(int serverId, double utilization);
+    // Samples the current utilization and efficiency into their windows
+    void sampleServers(double now);
+
+    uint64_t getRequestsReceived() const { return requestsReceived; }
+    uint64_t getRequestsServed() const { return requestsServed; }
+    double getSuccessRate() const { return requestsReceived > 0 ? (double)requestsServed / requestsReceived : 0.0; }
+    double getWindowedSuccessRate(double now);
+
+    size_t getNumServers() const { return serverUtilization.size(); }
+    double getUtilization() const { return utilization.getMean(); }
+    // 1 - standard deviation of the server utilizations, higher is better
+    double getLoadBalancingEfficiency() const { return 1.0 - utilization.getStddev(); }
+    double getWindowedUtilization(double now) { return utilizationWindow.getMean(now); }
+    double getWindowedLoadBalancingEfficiency(double now) { return efficiencyWindow.getMean(now); }
+
+private:
+    uint64_t requestsReceived;
+    uint64_t requestsServed;
+    SlidingWindow receivedWindow;
+    SlidingWindow servedWindow;
+
+    std::map<int, double> serverUtilization;
+    RunningStats utilization; // over serverUtilization
+    SlidingWindow utilizationWindow;
+    SlidingWindow efficiencyWindow;
+};
+
+} // namespace lasp_ven_simple
+
+#endif // METRICSENGINE_H
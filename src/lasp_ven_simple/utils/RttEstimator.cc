@@ -0,0 +1,92 @@
+#include "RttEstimator.h"
+#include <algorithm>
+#include <cmath>
+#include <istream>
+#include <ostream>
+
+namespace lasp_ven_simple {
+
+RttEstimator::RttEstimator()
+{
+    configure(1.0, 0.2, 10.0);
+}
+
+void RttEstimator::configure(double initialRto, double minRto, double maxRto)
+{
+    this->minRto = minRto;
+    this->maxRto = maxRto;
+    rto = std::min(std::max(initialRto, minRto), maxRto);
+    srtt = 0.0;
+    rttvar = 0.0;
+    numSamples = 0;
+    recentSamples.clear();
+    nextSlot = 0;
+}
+
+void RttEstimator::addSample(double rtt)
+{
+    const double alpha = 1.0 / 8.0;
+    const double beta = 1.0 / 4.0;
+    
+    if (numSamples == 0) {
+        srtt = rtt;
+        rttvar = rtt / 2.0;
+    }
+    else {
+        rttvar = (1.0 - beta) * rttvar + beta * std::fabs(srtt - rtt);
+        srtt = (1.0 - alpha) * srtt + alpha * rtt;
+    }
+    numSamples++;
+    rto = std::min(std::max(srtt + 4.0 * rttvar, minRto), maxRto);
+    
+    if (recentSamples.size() < RECENT_WINDOW) {
+        recentSamples.push_back(rtt);
+    }
+    else {
+        recentSamples[nextSlot] = rtt;
+        nextSlot = (nextSlot + 1) % RECENT_WINDOW;
+    }
+}
+
+double RttEstimator::getRto() const
+{
+    return rto;
+}
+
+void RttEstimator::save(std::ostream& out) const
+{
+    out << srtt << " " << rttvar << " " << rto << " " << numSamples << " " << nextSlot << " " << recentSamples.size();
+    for (double sample : recentSamples) {
+        out << " " << sample;
+    }
+    out << "\n";
+}
+
+void RttEstimator::restore(std::istream& in)
+{
+    size_t numRecent = 0;
+    in >> srtt >> rttvar >> rto >> numSamples >> nextSlot >> numRecent;
+    if (!in || numRecent > RECENT_WINDOW || nextSlot >= RECENT_WINDOW) {
+        in.setstate(std::ios::failbit);
+        return;
+    }
+    recentSamples.resize(numRecent);
+    for (double& sample : recentSamples) {
+        in >> sample;
+    }
+}
+
+double RttEstimator::getRecentQuantile(double q) const
+{
+    if (recentSamples.empty()) {
+        return rto;
+    }
+    std::vector<double> sorted(recentSamples);
+    // Nearest-rank quantile
+    long rank = (long)std::ceil(q * sorted.size()) - 1;
+    rank = std::min(std::max(rank, 0L), (long)sorted.size() - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank];
+}
+
+} // namespace lasp_ven_simple
@@ -0,0 +1,50 @@
+#ifndef RTTESTIMATOR_H
+#define RTTESTIMATOR_H
+
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+namespace lasp_ven_simple {
+
+// Round-trip time estimator following RFC 6298 (SRTT/RTTVAR, RTO = SRTT + 4 * RTTVAR).
+// Also keeps a small window of recent samples for quantile-based hedging.
+// All values are in seconds.
+class RttEstimator {
+public:
+    RttEstimator();
+    
+    void configure(double initialRto, double minRto, double maxRto);
+    void addSample(double rtt);
+    
+    double getRto() const;
+    double getSrtt() const { return srtt; }
+    double getRttvar() const { return rttvar; }
+    bool hasSamples() const { return numSamples > 0; }
+    
+    // Quantile (0..1) over the most recent samples
+    double getRecentQuantile(double q) const;
+    size_t getNumRecentSamples() const { return recentSamples.size(); }
+    
+    // Estimate and recent samples as text, for checkpoints; the RTO bounds
+    // stay those of configure(). restore() sets failbit on malformed input.
+    void save(std::ostream& out) const;
+    void restore(std::istream& in);
+    
+private:
+    static const size_t RECENT_WINDOW = 128;
+    
+    double srtt;
+    double rttvar;
+    double rto;
+    double minRto;
+    double maxRto;
+    long numSamples;
+    
+    std::vector<double> recentSamples; // ring buffer of the last RECENT_WINDOW samples
+    size_t nextSlot;
+};
+
+} // namespace lasp_ven_simple
+
+#endif // RTTESTIMATOR_H
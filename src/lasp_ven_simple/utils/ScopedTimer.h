@@ -0,0 +1,38 @@
+#ifndef SCOPEDTIMER_H
+#define SCOPEDTIMER_H
+
+#include "LatencyHistogram.h"
+#include <chrono>
+
+namespace lasp_ven_simple {
+
+// Measures the wall-clock time (std::chrono::steady_clock) spent in a scope and
+// records it, in seconds, into a histogram. A null histogram disables the timer,
+// so an unprofiled call costs one branch and no clock reads.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(LatencyHistogram* histogram) : histogram(histogram)
+    {
+        if (histogram) {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~ScopedTimer()
+    {
+        if (histogram) {
+            histogram->record(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+    }
+
+private:
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    LatencyHistogram* histogram;
+    std::chrono::steady_clock::time_point start;
+};
+
+} // namespace lasp_ven_simple
+
+#endif // SCOPEDTIMER_H
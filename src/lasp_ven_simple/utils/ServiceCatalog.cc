@@ -0,0 +1,84 @@
+#include "ServiceCatalog.h"
+#include <cctype>
+#include <stdexcept>
+
+namespace lasp_ven_simple {
+
+static const char* const SERVICE_NAMES[NUM_SERVICE_TYPES + 1] = {
+    "", "TRAFFIC_INFO", "EMERGENCY_ALERT", "INFOTAINMENT", "NAVIGATION"
+};
+
+const char* serviceName(int serviceType)
+{
+    return serviceType >= 1 && serviceType <= NUM_SERVICE_TYPES ? SERVICE_NAMES[serviceType] : "";
+}
+
+int serviceTypeFromName(const std::string& name)
+{
+    for (int type = 1; type <= NUM_SERVICE_TYPES; type++) {
+        if (name == SERVICE_NAMES[type]) {
+            return type;
+        }
+    }
+    return 0;
+}
+
+ServiceMask parseServiceMask(const std::string& text)
+{
+    ServiceMask mask = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = pos;
+        while (end < text.size() && text[end] != ',' && !std::isspace((unsigned char)text[end])) {
+            end++;
+        }
+        std::string name = text.substr(pos, end - pos);
+        if (name == "*") {
+            mask |= ALL_SERVICES;
+        }
+        else if (!name.empty()) {
+            int type = serviceTypeFromName(name);
+            if (type == 0) {
+                throw std::invalid_argument("unknown service '" + name + "'");
+            }
+            mask |= serviceBit(type);
+        }
+        pos = end + 1;
+    }
+    return mask;
+}
+
+std::string formatServiceMask(ServiceMask mask)
+{
+    std::string text;
+    for (int type = 1; type <= NUM_SERVICE_TYPES; type++) {
+        if (mask & serviceBit(type)) {
+            text += (text.empty() ? "" : ",") + std::string(SERVICE_NAMES[type]);
+        }
+    }
+    return text;
+}
+
+void ServiceIndex::clear()
+{
+    for (auto& list : servers) {
+        list.clear();
+    }
+}
+
+void ServiceIndex::add(const EdgeServer* server, ServiceMask services)
+{
+    for (int type = 1; type <= NUM_SERVICE_TYPES; type++) {
+        if (services & serviceBit(type)) {
+            servers[type].push_back(server);
+        }
+    }
+}
+
+const std::vector<const EdgeServer*>& ServiceIndex::getServers(int serviceType) const
+{
+    static const std::vector<const EdgeServer*> none;
+    return serviceType >= 1 && serviceType <= NUM_SERVICE_TYPES ? servers[serviceType] : none;
+}
+
+} // namespace lasp_ven_simple
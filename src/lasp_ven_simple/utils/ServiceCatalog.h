@@ -0,0 +1,51 @@
+#ifndef SERVICECATALOG_H
+#define SERVICECATALOG_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lasp_ven_simple {
+
+struct EdgeServer;
+
+// Service catalog of a server, one bit per ServiceType (values 1..NUM_SERVICE_TYPES)
+typedef uint32_t ServiceMask;
+const int NUM_SERVICE_TYPES = 4;
+const ServiceMask ALL_SERVICES = ((1u << NUM_SERVICE_TYPES) - 1) << 1;
+
+inline ServiceMask serviceBit(int serviceType) { return 1u << serviceType; }
+
+// Resources one instance of a service needs on its server
+struct ServiceFootprint {
+    double cpu;     // in GFLOPS
+    double memory;  // in GB
+    double storage; // in GB
+};
+
+// ServiceType name as in the enum ("NAVIGATION"), "" for unknown types
+const char* serviceName(int serviceType);
+// Service type of a name, 0 if unknown
+int serviceTypeFromName(const std::string& name);
+// Comma or space separated service names, "*" for all; throws std::invalid_argument on unknown names
+ServiceMask parseServiceMask(const std::string& text);
+std::string formatServiceMask(ServiceMask mask);
+
+// Inverted index service type -> servers hosting it, in insertion order.
+// Servers are referenced, not copied, and must outlive the index.
+class ServiceIndex {
+public:
+    ServiceIndex() : servers(NUM_SERVICE_TYPES + 1) {}
+
+    void clear();
+    void add(const EdgeServer* server, ServiceMask services);
+
+    const std::vector<const EdgeServer*>& getServers(int serviceType) const;
+
+private:
+    std::vector<std::vector<const EdgeServer*>> servers; // indexed by service type
+};
+
+} // namespace lasp_ven_simple
+
+#endif // SERVICECATALOG_H
@@ -25,4 +25,26 @@ double ServicePlacementUtils::estimateLatency(const ServiceRequest& request, con
     return propagationDelay + processingDelay + queueingDelay;
 }
 
+bool ServicePlacementUtils::hasRoomFor(const EdgeServer& server, const ServiceFootprint& footprint) {
+    return server.memoryUsed + footprint.memory <= server.memoryCapacity
+        && server.storageUsed + footprint.storage <= server.storageCapacity;
+}
+
+ServiceRequest ServicePlacementUtils::makeRequest(int vehicleId, long requestId, ServiceType serviceType, double now,
+        double dataSize, int excludeServerId, bool hedged) {
+    ServiceRequest request;
+    request.vehicleId = vehicleId;
+    request.requestId = requestId;
+    request.serviceType = serviceType;
+    request.timestamp = now;
+    request.latitude = 52.5200;
+    request.longitude = 13.4050;
+    request.priority = 1;
+    request.deadline = now + 10.0; // 10 seconds deadline
+    request.dataSize = dataSize; // in MB
+    request.excludeServerId = excludeServerId;
+    request.hedged = hedged;
+    return request;
+}
+
 } // namespace lasp_ven_simple 
\ No newline at end of file
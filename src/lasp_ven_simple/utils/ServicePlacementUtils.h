@@ -10,6 +10,13 @@ class ServicePlacementUtils {
 public:
     static double calculateDistance(double lat1, double lon1, double lat2, double lon2);
     static double estimateLatency(const ServiceRequest& request, const EdgeServer& server);
+    // Memory and storage left on the server for one more instance of this footprint
+    static bool hasRoomFor(const EdgeServer& server, const ServiceFootprint& footprint);
+    
+    // The one request model of the LASPManager, the edge servers and the vehicles:
+    // every request is located at the same reference point, priority 1, due 10s after now
+    static ServiceRequest makeRequest(int vehicleId, long requestId, ServiceType serviceType, double now,
+            double dataSize = 1.0, int excludeServerId = -1, bool hedged = false);
 };
 
 } // namespace lasp_ven_simple
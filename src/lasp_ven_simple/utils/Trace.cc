@@ -0,0 +1,53 @@
+#include "Trace.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace lasp_ven_simple {
+
+TraceBuffer::TraceBuffer(size_t capacity)
+    : records(capacity > 0 ? capacity : 1), count(0), file(nullptr)
+{
+}
+
+TraceBuffer::~TraceBuffer()
+{
+    close();
+}
+
+void TraceBuffer::open(const std::string& fileName, int moduleId, const std::string& modulePath)
+{
+    close();
+
+    file = fopen(fileName.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error("Cannot open trace file " + fileName);
+    }
+
+    TraceFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.recordSize = sizeof(TraceRecord);
+    header.moduleId = moduleId;
+    strncpy(header.modulePath, modulePath.c_str(), sizeof(header.modulePath) - 1);
+    fwrite(&header, sizeof(header), 1, file);
+}
+
+void TraceBuffer::flush()
+{
+    if (file && count > 0) {
+        fwrite(records.data(), sizeof(TraceRecord), count, file);
+        count = 0;
+    }
+}
+
+void TraceBuffer::close()
+{
+    if (file) {
+        flush();
+        fclose(file);
+        file = nullptr;
+    }
+}
+
+} // namespace lasp_ven_simple
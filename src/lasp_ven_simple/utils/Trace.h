@@ -0,0 +1,159 @@
+#ifndef LASP_TRACE_H
+#define LASP_TRACE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Compile-time trace level:
+//   0 - every trace point compiles to nothing
+//   1 - per-request events (default)
+//   2 - also start-up diagnostics such as routing table dumps
+// Set via LASP_TRACE_LEVEL in src/makefrag, e.g. make LASP_TRACE_LEVEL=0.
+#ifndef LASP_TRACE_LEVEL
+#define LASP_TRACE_LEVEL 1
+#endif
+
+namespace lasp_ven_simple {
+
+// Trace event table: X(id, description, arg0, arg1, arg2, value).
+// Argument labels are only used by the offline decoder; an empty label hides
+// the field and labels ending in "Addr" are printed as IPv4 addresses.
+// Append new events at the end so existing trace files keep decoding.
+#define LASP_TRACE_EVENTS(X) \
+    X(ROUTE,               "route",                   "index",   "destAddr", "nextHopAddr",    "") \
+    X(REQUEST_RECEIVED,    "request received",        "vehicle", "request",  "service",        "") \
+    X(PLACEMENT_FOUND,     "placement found",         "vehicle", "request",  "server",         "latencyMs") \
+    X(PLACEMENT_FAILED,    "no suitable server",      "vehicle", "request",  "service",        "") \
+    X(DEPLOYMENT_SENT,     "deployment sent",         "vehicle", "request",  "server",         "") \
+    X(LEASE_GRANTED,       "lease granted",           "vehicle", "request",  "server",         "ttl") \
+    X(EVALUATION,          "placement evaluation",    "",        "placements", "",             "utilization") \
+    X(DEPLOYMENT_RECEIVED, "deployment received",     "vehicle", "request",  "service",        "processingTime") \
+    X(DIRECT_REQUEST,      "direct request",          "vehicle", "request",  "service",        "load") \
+    X(REQUEST_REJECTED,    "request rejected",        "vehicle", "request",  "server",         "load") \
+    X(RESPONSE_SENT,       "response sent",           "vehicle", "request",  "server",         "") \
+    X(REQUEST_SENT,        "request sent",            "vehicle", "request",  "server",         "attempt") \
+    X(REQUEST_DEFERRED,    "request deferred",        "vehicle", "inFlight", "",               "") \
+    X(RESPONSE_RECEIVED,   "response received",       "vehicle", "request",  "server",         "latency") \
+    X(REQUEST_TIMEOUT,     "request timeout",         "vehicle", "request",  "server",         "attempt") \
+    X(REQUEST_FAILED,      "request failed",          "vehicle", "request",  "",               "attempts") \
+    X(HEDGE_SENT,          "hedged request sent",     "vehicle", "request",  "excludedServer", "") \
+    X(LEASE_RECEIVED,      "lease received",          "vehicle", "request",  "server",         "ttl") \
+    X(LEASE_REJECTED,      "lease rejected",          "vehicle", "request",  "server",         "") \
+    X(UNMATCHED_RESPONSE,  "response without request", "vehicle", "request", "server",         "") \
+    X(SERVER_FAILED,       "server failed",           "server",  "placements", "",             "silence") \
+    X(PLACEMENT_MOVED,     "placement moved",         "vehicle", "request",  "server",         "latencyMs") \
+    X(SERVER_RECOVERED,    "server recovered",        "server",  "",         "",               "downtime") \
+    X(REQUEST_COLLAPSED,   "request collapsed",       "vehicle", "request",  "leaderVehicle",  "")
+
+enum class TraceEvent : int32_t {
+#define LASP_TRACE_ENUM(id, description, arg0, arg1, arg2, value) id,
+    LASP_TRACE_EVENTS(LASP_TRACE_ENUM)
+#undef LASP_TRACE_ENUM
+    NUM_EVENTS
+};
+
+struct TraceEventInfo {
+    const char *name;
+    const char *description;
+    const char *labels[4]; // arg0, arg1, arg2, value
+};
+
+inline const TraceEventInfo *getTraceEventInfo(int32_t event)
+{
+    static const TraceEventInfo table[] = {
+#define LASP_TRACE_INFO(id, description, arg0, arg1, arg2, value) { #id, description, { arg0, arg1, arg2, value } },
+        LASP_TRACE_EVENTS(LASP_TRACE_INFO)
+#undef LASP_TRACE_INFO
+    };
+    if (event < 0 || event >= (int32_t)TraceEvent::NUM_EVENTS) {
+        return nullptr;
+    }
+    return &table[event];
+}
+
+// On-disk layout, little endian as written by the simulation host
+struct TraceRecord {
+    double time;     // simulation time in seconds
+    int32_t event;   // TraceEvent
+    int32_t arg0;
+    int64_t arg1;
+    int64_t arg2;
+    double value;
+};
+static_assert(sizeof(TraceRecord) == 40, "TraceRecord layout must stay fixed");
+
+struct TraceFileHeader {
+    char magic[8];        // TRACE_MAGIC
+    uint32_t version;
+    uint32_t recordSize;
+    int32_t moduleId;
+    char modulePath[108];
+};
+static_assert(sizeof(TraceFileHeader) == 128, "TraceFileHeader layout must stay fixed");
+
+static const char TRACE_MAGIC[8] = { 'L', 'A', 'S', 'P', 'T', 'R', 'C', '\0' };
+static const uint32_t TRACE_VERSION = 1;
+
+// Per-module trace buffer. Records are appended to a fixed-size in-memory
+// buffer that is written to the trace file whenever it fills up and on close().
+// Until open() is called every record() is a no-op, so tracing costs one branch
+// per trace point when no trace file is configured.
+class TraceBuffer {
+public:
+    explicit TraceBuffer(size_t capacity = 4096);
+    ~TraceBuffer();
+
+    // Throws std::runtime_error if the file cannot be created
+    void open(const std::string& fileName, int moduleId, const std::string& modulePath);
+    void close();
+    void flush();
+    bool isOpen() const { return file != nullptr; }
+
+    void record(double time, TraceEvent event, int32_t arg0, int64_t arg1, int64_t arg2, double value)
+    {
+        if (!file) {
+            return;
+        }
+        TraceRecord& r = records[count];
+        r.time = time;
+        r.event = (int32_t)event;
+        r.arg0 = arg0;
+        r.arg1 = arg1;
+        r.arg2 = arg2;
+        r.value = value;
+        if (++count == records.size()) {
+            flush();
+        }
+    }
+
+private:
+    TraceBuffer(const TraceBuffer&) = delete;
+    TraceBuffer& operator=(const TraceBuffer&) = delete;
+
+    std::vector<TraceRecord> records;
+    size_t count;
+    FILE *file;
+};
+
+} // namespace lasp_ven_simple
+
+// Trace points, compiled out below their level. Must be used inside an OMNeT++
+// component (simTime() supplies the timestamp).
+#if LASP_TRACE_LEVEL >= 1
+#define LASP_TRACE(buffer, event, arg0, arg1, arg2, value) \
+    (buffer).record(omnetpp::simTime().dbl(), lasp_ven_simple::TraceEvent::event, (arg0), (arg1), (arg2), (value))
+#else
+// Arguments stay unevaluated but count as used, so level 0 builds without warnings
+#define LASP_TRACE(buffer, event, arg0, arg1, arg2, value) \
+    ((void)sizeof(arg0), (void)sizeof(arg1), (void)sizeof(arg2), (void)sizeof(value))
+#endif
+
+#if LASP_TRACE_LEVEL >= 2
+#define LASP_TRACE_DEBUG(buffer, event, arg0, arg1, arg2, value) LASP_TRACE(buffer, event, arg0, arg1, arg2, value)
+#else
+#define LASP_TRACE_DEBUG(buffer, event, arg0, arg1, arg2, value) ((void)0)
+#endif
+
+#endif // LASP_TRACE_H
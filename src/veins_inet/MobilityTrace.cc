@@ -0,0 +1,276 @@
+#include "veins_inet/MobilityTrace.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace veins {
+
+MobilityTraceWriter::MobilityTraceWriter()
+    : stepTime(0), stepPending(false), offset(0), file(nullptr)
+{
+}
+
+MobilityTraceWriter::~MobilityTraceWriter()
+{
+    close();
+}
+
+void MobilityTraceWriter::open(const std::string& fileName, double updateInterval)
+{
+    close();
+
+    file = fopen(fileName.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error("Cannot open mobility trace " + fileName);
+    }
+    active.clear();
+    index.clear();
+    names.clear();
+    stepTime = 0;
+    stepPending = false;
+
+    MobilityTraceHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MOBILITY_TRACE_MAGIC, sizeof(header.magic));
+    header.version = MOBILITY_TRACE_VERSION;
+    header.updateInterval = updateInterval;
+    fwrite(&header, sizeof(header), 1, file);
+    offset = sizeof(header);
+}
+
+uint32_t MobilityTraceWriter::addVehicle(const std::string& name)
+{
+    names.push_back(name);
+    return (uint32_t)(names.size() - 1);
+}
+
+void MobilityTraceWriter::record(double time, uint32_t vehicle, MobilityEvent event, double x, double y, double speed, double angle)
+{
+    if (!file) {
+        return;
+    }
+    if (stepPending && time > stepTime) {
+        writeStep();
+    }
+    stepTime = stepPending ? std::max(stepTime, time) : time;
+    stepPending = true;
+
+    if (event == MobilityEvent::DESPAWN) {
+        active.erase(vehicle);
+    }
+    else {
+        active[vehicle] = VehicleState{(float)x, (float)y, (float)speed, (float)angle};
+    }
+}
+
+void MobilityTraceWriter::writeStep()
+{
+    uint32_t n = (uint32_t)active.size();
+    block.assign(mobilityStepBlockSize(n), 0);
+
+    MobilityStepHeader* step = reinterpret_cast<MobilityStepHeader*>(block.data());
+    step->time = stepTime;
+    step->numVehicles = n;
+    uint32_t* ids = reinterpret_cast<uint32_t*>(step + 1);
+    float* xs = reinterpret_cast<float*>(ids + n);
+    float* ys = xs + n;
+    float* speeds = ys + n;
+    float* angles = speeds + n;
+    uint32_t i = 0;
+    for (const auto& entry : active) {
+        ids[i] = entry.first;
+        xs[i] = entry.second.x;
+        ys[i] = entry.second.y;
+        speeds[i] = entry.second.speed;
+        angles[i] = entry.second.angle;
+        i++;
+    }
+
+    fwrite(block.data(), 1, block.size(), file);
+    index.push_back(MobilityStepIndexEntry{stepTime, offset});
+    offset += block.size();
+    stepPending = false;
+}
+
+void MobilityTraceWriter::close()
+{
+    if (!file) {
+        return;
+    }
+    if (stepPending) {
+        writeStep();
+    }
+
+    uint64_t stepIndexOffset = offset;
+    fwrite(index.data(), sizeof(MobilityStepIndexEntry), index.size(), file);
+
+    uint64_t nameTableOffset = stepIndexOffset + index.size() * sizeof(MobilityStepIndexEntry);
+    uint32_t numNames = (uint32_t)names.size();
+    fwrite(&numNames, sizeof(numNames), 1, file);
+    for (const std::string& name : names) {
+        uint32_t length = (uint32_t)name.size();
+        fwrite(&length, sizeof(length), 1, file);
+        fwrite(name.data(), 1, length, file);
+    }
+
+    // Complete the header now that the step count and table offsets are known
+    uint64_t numSteps = index.size();
+    fseek(file, offsetof(MobilityTraceHeader, numSteps), SEEK_SET);
+    fwrite(&numSteps, sizeof(numSteps), 1, file);
+    fwrite(&stepIndexOffset, sizeof(stepIndexOffset), 1, file);
+    fwrite(&nameTableOffset, sizeof(nameTableOffset), 1, file);
+    fclose(file);
+    file = nullptr;
+}
+
+MobilityTraceReader::MobilityTraceReader()
+    : data(nullptr), size(0), stepIndex(nullptr), numSteps(0)
+#ifdef _WIN32
+    , fileHandle(nullptr), mappingHandle(nullptr)
+#endif
+{
+}
+
+MobilityTraceReader::~MobilityTraceReader()
+{
+    close();
+}
+
+void MobilityTraceReader::open(const std::string& fileName)
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE fh = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fh == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Cannot open mobility trace " + fileName);
+    }
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(fh, &fileSize);
+    size = (size_t)fileSize.QuadPart;
+    HANDLE mh = size > 0 ? CreateFileMappingA(fh, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+    fileHandle = fh;
+    mappingHandle = mh;
+    data = mh ? static_cast<const char*>(MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+#else
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open mobility trace " + fileName);
+    }
+    struct stat st;
+    size = fstat(fd, &st) == 0 ? (size_t)st.st_size : 0;
+    if (size > 0) {
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        data = mapping == MAP_FAILED ? nullptr : static_cast<const char*>(mapping);
+    }
+    ::close(fd);
+#endif
+
+    if (!data || size < sizeof(MobilityTraceHeader) || memcmp(header().magic, MOBILITY_TRACE_MAGIC, sizeof(MOBILITY_TRACE_MAGIC)) != 0) {
+        close();
+        throw std::runtime_error(fileName + " is not a mobility trace");
+    }
+    if (header().version != MOBILITY_TRACE_VERSION) {
+        close();
+        throw std::runtime_error(fileName + ": unsupported mobility trace version, record it again");
+    }
+    const MobilityTraceHeader h = header();
+    if (h.stepIndexOffset == 0 || h.nameTableOffset == 0) {
+        close();
+        throw std::runtime_error(fileName + ": incomplete mobility trace, the recording was not closed");
+    }
+
+    bool ok = h.stepIndexOffset % 8 == 0 && h.stepIndexOffset + h.numSteps * sizeof(MobilityStepIndexEntry) <= h.nameTableOffset && h.nameTableOffset + sizeof(uint32_t) <= size;
+    if (ok) {
+        stepIndex = reinterpret_cast<const MobilityStepIndexEntry*>(data + h.stepIndexOffset);
+        numSteps = (size_t)h.numSteps;
+        for (size_t i = 0; ok && i < numSteps; i++) {
+            const MobilityStepIndexEntry& entry = stepIndex[i];
+            ok = entry.offset % 8 == 0 && entry.offset + sizeof(MobilityStepHeader) <= h.stepIndexOffset && entry.offset + mobilityStepBlockSize(reinterpret_cast<const MobilityStepHeader*>(data + entry.offset)->numVehicles) <= h.stepIndexOffset;
+        }
+    }
+
+    size_t position = (size_t)h.nameTableOffset;
+    uint32_t numNames = 0;
+    if (ok) {
+        memcpy(&numNames, data + position, sizeof(numNames));
+        position += sizeof(numNames);
+    }
+    for (uint32_t i = 0; ok && i < numNames; i++) {
+        uint32_t length = 0;
+        ok = position + sizeof(length) <= size;
+        if (ok) {
+            memcpy(&length, data + position, sizeof(length));
+            position += sizeof(length);
+            ok = position + length <= size;
+        }
+        if (ok) {
+            names.emplace_back(data + position, length);
+            position += length;
+        }
+    }
+    if (!ok) {
+        close();
+        throw std::runtime_error(fileName + ": truncated mobility trace");
+    }
+}
+
+void MobilityTraceReader::close()
+{
+#ifdef _WIN32
+    if (data) {
+        UnmapViewOfFile(data);
+    }
+    if (mappingHandle) {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle) {
+        CloseHandle(fileHandle);
+    }
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+#else
+    if (data) {
+        munmap(const_cast<char*>(data), size);
+    }
+#endif
+    data = nullptr;
+    size = 0;
+    stepIndex = nullptr;
+    numSteps = 0;
+    names.clear();
+}
+
+MobilityStep MobilityTraceReader::getStep(size_t step) const
+{
+    const MobilityStepHeader* h = reinterpret_cast<const MobilityStepHeader*>(data + stepIndex[step].offset);
+    uint32_t n = h->numVehicles;
+    MobilityStep view;
+    view.time = h->time;
+    view.numVehicles = n;
+    view.vehicle = reinterpret_cast<const uint32_t*>(h + 1);
+    view.x = reinterpret_cast<const float*>(view.vehicle + n);
+    view.y = view.x + n;
+    view.speed = view.y + n;
+    view.angle = view.speed + n;
+    return view;
+}
+
+size_t MobilityTraceReader::findStep(double time) const
+{
+    const MobilityStepIndexEntry* end = stepIndex + numSteps;
+    const MobilityStepIndexEntry* it = std::lower_bound(stepIndex, end, time, [](const MobilityStepIndexEntry& entry, double t) { return entry.time < t; });
+    return (size_t)(it - stepIndex);
+}
+
+} // namespace veins
@@ -0,0 +1,164 @@
+//
+// Binary mobility trace recorded from TraCI and replayed without SUMO.
+//
+// The file is a sequence of per-step blocks in simulation time order, each a
+// complete snapshot of all vehicles present at that step, stored column-wise:
+//
+//   MobilityTraceHeader
+//   per step: MobilityStepHeader, then numVehicles entries of each column
+//             uint32 vehicle[], float x[], float y[], float speed[], float angle[]
+//             padded to 8 bytes
+//   step index at stepIndexOffset: MobilityStepIndexEntry[numSteps]
+//   name table at nameTableOffset: uint32 count, then per vehicle
+//   uint32 length + characters of its SUMO id
+//
+// A vehicle spawns at the first step it appears in and is removed at the
+// first step it is missing from. Because every block is a full snapshot,
+// replay can start at any step. The reader maps the file into memory and
+// hands out pointers into the mapping, so blocks are decoded without copying
+// and seeking by time is a binary search over the step index.
+//
+// Little endian, as written by the recording host. This header has no
+// OMNeT++ dependency so offline tools can use it.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace veins {
+
+enum class MobilityEvent : uint16_t {
+    SPAWN = 0,   // vehicle enters the simulation at the given position
+    MOVE = 1,    // per-step position/speed/heading update
+    DESPAWN = 2  // vehicle leaves; position fields are unused
+};
+
+struct MobilityTraceHeader {
+    char magic[8];            // MOBILITY_TRACE_MAGIC
+    uint32_t version;
+    uint32_t reserved0;
+    double updateInterval;    // TraCI step length of the recording, s
+    uint64_t numSteps;
+    uint64_t stepIndexOffset; // 0 if the recording was not closed properly
+    uint64_t nameTableOffset;
+    uint64_t reserved[2];
+};
+static_assert(sizeof(MobilityTraceHeader) == 64, "MobilityTraceHeader layout must stay fixed");
+
+struct MobilityStepHeader {
+    double time;              // simulation time in seconds
+    uint32_t numVehicles;
+    uint32_t reserved;
+};
+static_assert(sizeof(MobilityStepHeader) == 16, "MobilityStepHeader layout must stay fixed");
+
+struct MobilityStepIndexEntry {
+    double time;
+    uint64_t offset;          // file offset of the MobilityStepHeader
+};
+static_assert(sizeof(MobilityStepIndexEntry) == 16, "MobilityStepIndexEntry layout must stay fixed");
+
+static const char MOBILITY_TRACE_MAGIC[8] = { 'L', 'A', 'S', 'P', 'M', 'O', 'B', '\0' };
+static const uint32_t MOBILITY_TRACE_VERSION = 2;
+
+// Bytes occupied by a step block with n vehicles, including padding
+inline size_t mobilityStepBlockSize(uint32_t numVehicles)
+{
+    size_t size = sizeof(MobilityStepHeader) + (size_t)numVehicles * (sizeof(uint32_t) + 4 * sizeof(float));
+    return (size + 7) & ~(size_t)7;
+}
+
+// Collects the events of one TraCI step and writes a snapshot block whenever
+// time advances. close() (or the destructor) writes the last block, the step
+// index and the name table, and completes the header.
+class MobilityTraceWriter {
+public:
+    MobilityTraceWriter();
+    ~MobilityTraceWriter();
+
+    // Throws std::runtime_error if the file cannot be created
+    void open(const std::string& fileName, double updateInterval);
+    void close();
+    bool isOpen() const { return file != nullptr; }
+
+    // Returns the trace index for a new vehicle
+    uint32_t addVehicle(const std::string& name);
+    // Events must arrive in non-decreasing time order
+    void record(double time, uint32_t vehicle, MobilityEvent event, double x, double y, double speed, double angle);
+
+private:
+    MobilityTraceWriter(const MobilityTraceWriter&) = delete;
+    MobilityTraceWriter& operator=(const MobilityTraceWriter&) = delete;
+
+    struct VehicleState {
+        float x, y, speed, angle;
+    };
+
+    void writeStep();
+
+    std::map<uint32_t, VehicleState> active; // ordered by vehicle index, i.e. spawn order
+    double stepTime;
+    bool stepPending;
+    uint64_t offset;
+    std::vector<MobilityStepIndexEntry> index;
+    std::vector<std::string> names;
+    std::vector<char> block;
+    FILE* file;
+};
+
+// Zero-copy view of one step block; pointers stay valid while the reader is open
+struct MobilityStep {
+    double time;
+    uint32_t numVehicles;
+    const uint32_t* vehicle;
+    const float* x;
+    const float* y;
+    const float* speed;
+    const float* angle;
+};
+
+// Memory-mapped trace reader
+class MobilityTraceReader {
+public:
+    MobilityTraceReader();
+    ~MobilityTraceReader();
+
+    // Throws std::runtime_error on missing, truncated or incompatible files
+    void open(const std::string& fileName);
+    void close();
+
+    double getUpdateInterval() const { return header().updateInterval; }
+    size_t getNumSteps() const { return numSteps; }
+    double getStepTime(size_t step) const { return stepIndex[step].time; }
+    MobilityStep getStep(size_t step) const;
+
+    // First step at or after `time` (getNumSteps() if none), O(log steps)
+    size_t findStep(double time) const;
+
+    size_t getNumVehicleNames() const { return names.size(); }
+    const std::string& getVehicleName(uint32_t vehicle) const { return names.at(vehicle); }
+
+private:
+    MobilityTraceReader(const MobilityTraceReader&) = delete;
+    MobilityTraceReader& operator=(const MobilityTraceReader&) = delete;
+
+    const MobilityTraceHeader& header() const { return *reinterpret_cast<const MobilityTraceHeader*>(data); }
+
+    const char* data;
+    size_t size;
+    const MobilityStepIndexEntry* stepIndex;
+    size_t numSteps;
+    std::vector<std::string> names;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
+
+} // namespace veins
@@ -43,6 +43,7 @@ using namespace inet;
 Define_Module(VeinsInetApplicationBase);
 
 VeinsInetApplicationBase::VeinsInetApplicationBase()
+    : mobility(nullptr)
 {
 }
 
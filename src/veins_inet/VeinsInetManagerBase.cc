@@ -51,6 +51,19 @@ void VeinsInetManagerBase::initialize(int stage)
         root->emit(POST_MODEL_CHANGE, notification, NULL);
     });
 #endif
+
+    std::string mobilityTraceFile = par("mobilityTraceFile").stdstringValue();
+    if (!mobilityTraceFile.empty()) {
+        mobilityTrace.open(mobilityTraceFile, updateInterval.dbl());
+        signalManager.subscribeCallback(this, TraCIScenarioManager::traciModuleRemovedSignal, [this](SignalPayload<cObject*> payload) {
+            cModule* module = dynamic_cast<cModule*>(payload.p);
+            auto it = mobilityTraceIds.find(module->getId());
+            if (it != mobilityTraceIds.end()) {
+                mobilityTrace.record(simTime().dbl(), it->second, MobilityEvent::DESPAWN, 0, 0, 0, 0);
+                mobilityTraceIds.erase(it);
+            }
+        });
+    }
 }
 
 void VeinsInetManagerBase::preInitializeModule(cModule* mod, const std::string& nodeId, const Coord& position, const std::string& road_id, double speed, Heading heading, VehicleSignalSet signals)
@@ -62,6 +75,12 @@ void VeinsInetManagerBase::preInitializeModule(cModule* mod, const std::string&
     for (auto inetmm : mobilityModules) {
         inetmm->preInitialize(nodeId, inet::Coord(position.x, position.y), road_id, speed, heading.getRad());
     }
+
+    if (mobilityTrace.isOpen()) {
+        uint32_t id = mobilityTrace.addVehicle(nodeId);
+        mobilityTraceIds[mod->getId()] = id;
+        mobilityTrace.record(simTime().dbl(), id, MobilityEvent::SPAWN, position.x, position.y, speed, heading.getRad());
+    }
 }
 
 void VeinsInetManagerBase::updateModulePosition(cModule* mod, const Coord& p, const std::string& edge, double speed, Heading heading, VehicleSignalSet signals)
@@ -73,4 +92,11 @@ void VeinsInetManagerBase::updateModulePosition(cModule* mod, const Coord& p, co
     for (auto inetmm : mobilityModules) {
         inetmm->nextPosition(inet::Coord(p.x, p.y), edge, speed, heading.getRad());
     }
+
+    if (mobilityTrace.isOpen()) {
+        auto it = mobilityTraceIds.find(mod->getId());
+        if (it != mobilityTraceIds.end()) {
+            mobilityTrace.record(simTime().dbl(), it->second, MobilityEvent::MOVE, p.x, p.y, speed, heading.getRad());
+        }
+    }
 }
@@ -26,6 +26,9 @@
 
 #include "veins/modules/mobility/traci/TraCIScenarioManager.h"
 #include "veins/modules/utility/SignalManager.h"
+#include "veins_inet/MobilityTrace.h"
+
+#include <map>
 
 namespace veins {
 
@@ -49,6 +52,10 @@ public:
 
 protected:
     SignalManager signalManager;
+
+    /** @brief Recording of spawns, position updates and removals for VeinsInetReplayManager (if mobilityTraceFile is set) */
+    MobilityTraceWriter mobilityTrace;
+    std::map<int, uint32_t> mobilityTraceIds; /**< module id -> trace vehicle index */
 };
 
 class VEINS_INET_API VeinsInetManagerBaseAccess {
@@ -170,13 +170,13 @@ TraCIScenarioManager* VeinsInetMobility::getManager() const
 
 TraCICommandInterface* VeinsInetMobility::getCommandInterface() const
 {
-    if (!commandInterface) commandInterface = getManager()->getCommandInterface();
+    if (!commandInterface && getManager()) commandInterface = getManager()->getCommandInterface();
     return commandInterface;
 }
 
 TraCICommandInterface::Vehicle* VeinsInetMobility::getVehicleCommandInterface() const
 {
-    if (!vehicleCommandInterface) vehicleCommandInterface = new TraCICommandInterface::Vehicle(getCommandInterface()->vehicle(getExternalId()));
+    if (!vehicleCommandInterface && getCommandInterface()) vehicleCommandInterface = new TraCICommandInterface::Vehicle(getCommandInterface()->vehicle(getExternalId()));
     return vehicleCommandInterface;
 }
 
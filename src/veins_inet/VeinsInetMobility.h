@@ -73,6 +73,7 @@ public:
 #endif
 
     virtual std::string getExternalId() const;
+    /** @brief TraCI access; nullptr when mobility is replayed by VeinsInetReplayManager */
     virtual TraCIScenarioManager* getManager() const;
     virtual TraCICommandInterface* getCommandInterface() const;
     virtual TraCICommandInterface::Vehicle* getVehicleCommandInterface() const;
@@ -0,0 +1,130 @@
+#include "veins_inet/VeinsInetReplayManager.h"
+
+#include "veins_inet/VeinsInetMobility.h"
+#include "inet/common/scenario/ScenarioManager.h"
+
+using veins::VeinsInetReplayManager;
+
+Define_Module(veins::VeinsInetReplayManager);
+
+VeinsInetReplayManager::VeinsInetReplayManager()
+{
+}
+
+VeinsInetReplayManager::~VeinsInetReplayManager()
+{
+    cancelAndDelete(stepMsg);
+}
+
+void VeinsInetReplayManager::initialize()
+{
+    moduleType = par("moduleType").stdstringValue();
+    moduleName = par("moduleName").stdstringValue();
+    moduleDisplayString = par("moduleDisplayString").stdstringValue();
+    traceStartTime = par("traceStartTime");
+
+    trace.open(par("traceFile").stdstringValue());
+    updateInterval = trace.getUpdateInterval();
+    nextStep = trace.findStep(traceStartTime.dbl());
+    EV_INFO << "Replaying " << trace.getNumSteps() - nextStep << " of " << trace.getNumSteps() << " mobility steps from trace time " << traceStartTime << ", step " << updateInterval << endl;
+
+    stepMsg = new cMessage("replayStep");
+    if (nextStep < trace.getNumSteps()) {
+        scheduleAt(std::max(simTime(), getStepSimTime(nextStep)), stepMsg);
+    }
+}
+
+void VeinsInetReplayManager::handleMessage(cMessage* msg)
+{
+    if (msg != stepMsg) {
+        throw cRuntimeError("VeinsInetReplayManager received unknown message %s", msg->getName());
+    }
+
+    while (nextStep < trace.getNumSteps() && getStepSimTime(nextStep) <= simTime()) {
+        applyStep(trace.getStep(nextStep));
+        nextStep++;
+    }
+
+    if (nextStep < trace.getNumSteps()) {
+        scheduleAt(getStepSimTime(nextStep), stepMsg);
+    }
+}
+
+void VeinsInetReplayManager::finish()
+{
+    // Like TraCIScenarioManager, remove remaining nodes so they finish before modules declared after us
+    while (!hosts.empty()) {
+        deleteModule(hosts.begin()->first);
+    }
+}
+
+void VeinsInetReplayManager::applyStep(const MobilityStep& step)
+{
+    // Vehicles new in this block spawn, known ones move
+    for (uint32_t i = 0; i < step.numVehicles; i++) {
+        auto it = hosts.find(step.vehicle[i]);
+        if (it == hosts.end()) {
+            addModule(step, i);
+        }
+        else {
+            it->second.lastStep = nextStep;
+            updateModulePosition(it->second.module, step, i);
+        }
+    }
+
+    // Vehicles missing from this block have left
+    for (auto it = hosts.begin(); it != hosts.end();) {
+        uint32_t vehicle = it->first;
+        bool left = it->second.lastStep != nextStep;
+        ++it;
+        if (left) {
+            deleteModule(vehicle);
+        }
+    }
+}
+
+void VeinsInetReplayManager::addModule(const MobilityStep& step, uint32_t i)
+{
+    int32_t nodeVectorIndex = nextNodeVectorIndex++;
+    cModuleType* nodeType = cModuleType::get(moduleType.c_str());
+    cModule* mod = nodeType->create(moduleName.c_str(), getParentModule(), nodeVectorIndex, nodeVectorIndex);
+    mod->finalizeParameters();
+    if (moduleDisplayString.length() > 0) {
+        mod->getDisplayString().parse(moduleDisplayString.c_str());
+    }
+    mod->buildInside();
+    mod->scheduleStart(simTime() + updateInterval);
+
+    const std::string& nodeId = trace.getVehicleName(step.vehicle[i]);
+    for (auto inetmm : getSubmodulesOfType<VeinsInetMobility>(mod)) {
+        inetmm->preInitialize(nodeId, inet::Coord(step.x[i], step.y[i]), "", step.speed[i], step.angle[i]);
+    }
+
+#if INET_VERSION >= 0x0402
+    auto* notification = new inet::cPreModuleInitNotification();
+    notification->module = mod;
+    getSimulation()->getSystemModule()->emit(POST_MODEL_CHANGE, notification, NULL);
+#endif
+
+    mod->callInitialize();
+    hosts[step.vehicle[i]] = Host{mod, nextStep};
+}
+
+void VeinsInetReplayManager::updateModulePosition(cModule* mod, const MobilityStep& step, uint32_t i)
+{
+    for (auto inetmm : getSubmodulesOfType<VeinsInetMobility>(mod)) {
+        inetmm->nextPosition(inet::Coord(step.x[i], step.y[i]), "", step.speed[i], step.angle[i]);
+    }
+}
+
+void VeinsInetReplayManager::deleteModule(uint32_t vehicle)
+{
+    auto it = hosts.find(vehicle);
+    if (it == hosts.end()) {
+        return;
+    }
+    cModule* mod = it->second.module;
+    hosts.erase(it);
+    mod->callFinish();
+    mod->deleteModule();
+}
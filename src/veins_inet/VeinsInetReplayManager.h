@@ -0,0 +1,59 @@
+#pragma once
+
+#include "veins_inet/veins_inet.h"
+
+#include "veins_inet/MobilityTrace.h"
+
+#include <map>
+
+namespace veins {
+
+/**
+ * @brief
+ * Creates, moves and removes vehicle nodes from a mobility trace recorded by
+ * VeinsInetManager (parameter mobilityTraceFile), without running SUMO.
+ *
+ * Nodes are created the same way TraCIScenarioManager does it, and every
+ * recorded position is passed to VeinsInetMobility::nextPosition at its
+ * recorded time, so runs with the same trace see identical mobility.
+ * The trace is memory-mapped and each step block is read in place. Since
+ * every block is a full snapshot, the replay can start at any step
+ * (traceStartTime), found by binary search over the step index.
+ */
+class VEINS_INET_API VeinsInetReplayManager : public cSimpleModule {
+public:
+    VeinsInetReplayManager();
+    virtual ~VeinsInetReplayManager();
+
+protected:
+    virtual void initialize() override;
+    virtual void handleMessage(cMessage* msg) override;
+    virtual void finish() override;
+
+    virtual void applyStep(const MobilityStep& step);
+    virtual void addModule(const MobilityStep& step, uint32_t i);
+    virtual void updateModulePosition(cModule* mod, const MobilityStep& step, uint32_t i);
+    virtual void deleteModule(uint32_t vehicle);
+
+    /** @brief Simulation time of a trace step */
+    simtime_t getStepSimTime(size_t step) const { return SimTime(trace.getStepTime(step)) - traceStartTime; }
+
+    MobilityTraceReader trace;
+    cMessage* stepMsg = nullptr;
+    simtime_t updateInterval;
+    simtime_t traceStartTime;
+    size_t nextStep = 0;
+
+    std::string moduleType;
+    std::string moduleName;
+    std::string moduleDisplayString;
+
+    struct Host {
+        cModule* module;
+        size_t lastStep; /**< last step the vehicle was present in */
+    };
+    std::map<uint32_t, Host> hosts; /**< trace vehicle index -> node */
+    int nextNodeVectorIndex = 0;
+};
+
+} // namespace veins
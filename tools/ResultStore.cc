@@ -0,0 +1,758 @@
+#include "ResultStore.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace lasp_tools {
+
+namespace {
+
+const char RESULT_STORE_MAGIC[8] = { 'L', 'A', 'S', 'P', 'R', 'E', 'S', '\0' };
+const uint32_t RESULT_STORE_VERSION = 1;
+
+struct ResultStoreHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t footerOffset;
+    uint64_t footerSize;
+};
+static_assert(sizeof(ResultStoreHeader) == 32, "ResultStoreHeader layout must stay fixed");
+
+uint64_t zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+int64_t unzigzag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+uint64_t doubleBits(double v)
+{
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+double bitsDouble(uint64_t bits)
+{
+    double v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+class Encoder {
+public:
+    explicit Encoder(std::vector<uint8_t>& out) : out(out) {}
+
+    void varint(uint64_t v)
+    {
+        while (v >= 0x80) {
+            out.push_back((uint8_t)(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back((uint8_t)v);
+    }
+    void signedVarint(int64_t v) { varint(zigzag(v)); }
+    void raw(double v)
+    {
+        uint64_t bits = doubleBits(v);
+        for (int i = 0; i < 8; i++) {
+            out.push_back((uint8_t)(bits >> (8 * i)));
+        }
+    }
+    void string(const std::string& s)
+    {
+        varint(s.size());
+        out.insert(out.end(), s.begin(), s.end());
+    }
+    // One header byte (0: same as previous, else 1 + 8 * leading + trailing
+    // zero bytes of the XOR), then the remaining bytes of the XOR
+    void xorDouble(double v)
+    {
+        uint64_t x = doubleBits(v) ^ previous;
+        previous = doubleBits(v);
+        if (x == 0) {
+            out.push_back(0);
+            return;
+        }
+        int leading = 0, trailing = 0;
+        while (((x >> (56 - 8 * leading)) & 0xff) == 0) {
+            leading++;
+        }
+        while (((x >> (8 * trailing)) & 0xff) == 0) {
+            trailing++;
+        }
+        out.push_back((uint8_t)(1 + 8 * leading + trailing));
+        for (int i = trailing; i < 8 - leading; i++) {
+            out.push_back((uint8_t)(x >> (8 * i)));
+        }
+    }
+
+private:
+    std::vector<uint8_t>& out;
+    uint64_t previous = 0;
+};
+
+class Decoder {
+public:
+    Decoder(const uint8_t* data, size_t size) : p(data), end(data + size) {}
+
+    uint64_t varint()
+    {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t b = byte();
+            v |= (uint64_t)(b & 0x7f) << shift;
+            if (!(b & 0x80)) {
+                return v;
+            }
+        }
+        throw std::runtime_error("malformed varint");
+    }
+    int64_t signedVarint() { return unzigzag(varint()); }
+    double raw()
+    {
+        uint64_t bits = 0;
+        for (int i = 0; i < 8; i++) {
+            bits |= (uint64_t)byte() << (8 * i);
+        }
+        return bitsDouble(bits);
+    }
+    std::string string()
+    {
+        uint64_t size = varint();
+        if (size > (uint64_t)(end - p)) {
+            throw std::runtime_error("truncated string");
+        }
+        std::string s((const char*)p, (size_t)size);
+        p += size;
+        return s;
+    }
+    double xorDouble()
+    {
+        uint8_t header = byte();
+        if (header != 0) {
+            int leading = (header - 1) / 8, trailing = (header - 1) % 8;
+            uint64_t x = 0;
+            for (int i = trailing; i < 8 - leading; i++) {
+                x |= (uint64_t)byte() << (8 * i);
+            }
+            previous ^= x;
+        }
+        return bitsDouble(previous);
+    }
+
+private:
+    uint8_t byte()
+    {
+        if (p == end) {
+            throw std::runtime_error("truncated data");
+        }
+        return *p++;
+    }
+
+    const uint8_t* p;
+    const uint8_t* end;
+    uint64_t previous = 0;
+};
+
+// Splits an OMNeT++ result line into tokens; "quoted" tokens may contain
+// blanks and backslash escapes
+void tokenize(const std::string& line, std::vector<std::string>& tokens)
+{
+    tokens.clear();
+    size_t i = 0, n = line.size();
+    while (true) {
+        while (i < n && (line[i] == ' ' || line[i] == '\t' || line[i] == '\r')) {
+            i++;
+        }
+        if (i == n) {
+            return;
+        }
+        std::string token;
+        if (line[i] == '"') {
+            for (i++; i < n && line[i] != '"'; i++) {
+                if (line[i] == '\\' && i + 1 < n) {
+                    i++;
+                }
+                token += line[i];
+            }
+            i++;
+        }
+        else {
+            while (i < n && line[i] != ' ' && line[i] != '\t' && line[i] != '\r') {
+                token += line[i++];
+            }
+        }
+        tokens.push_back(token);
+    }
+}
+
+double parseValue(const std::string& text)
+{
+    if (text == "nan" || text == "-nan") {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    if (text == "inf") {
+        return std::numeric_limits<double>::infinity();
+    }
+    if (text == "-inf") {
+        return -std::numeric_limits<double>::infinity();
+    }
+    return std::strtod(text.c_str(), nullptr);
+}
+
+} // namespace
+
+std::string ResultRun::get(const std::string& key) const
+{
+    auto it = attributes.find(key);
+    return it == attributes.end() ? std::string() : it->second;
+}
+
+bool globMatch(const char* pattern, const char* text)
+{
+    const char* star = nullptr;
+    const char* resume = nullptr;
+    while (*text) {
+        if (*pattern == '*') {
+            star = pattern++;
+            resume = text;
+        }
+        else if (*pattern == '?' || *pattern == *text) {
+            pattern++;
+            text++;
+        }
+        else if (star) {
+            pattern = star + 1;
+            text = ++resume;
+        }
+        else {
+            return false;
+        }
+    }
+    while (*pattern == '*') {
+        pattern++;
+    }
+    return *pattern == '\0';
+}
+
+int64_t parseSimTimePs(const char* text)
+{
+    const char* p = text;
+    bool negative = *p == '-';
+    if (*p == '-' || *p == '+') {
+        p++;
+    }
+    int64_t whole = 0;
+    while (*p >= '0' && *p <= '9') {
+        whole = whole * 10 + (*p++ - '0');
+    }
+    int64_t fraction = 0;
+    int digits = 0;
+    if (*p == '.') {
+        for (p++; *p >= '0' && *p <= '9'; p++) {
+            if (digits < 12) {
+                fraction = fraction * 10 + (*p - '0');
+                digits++;
+            }
+        }
+    }
+    if (*p == 'e' || *p == 'E') {
+        return (int64_t)std::llround(std::strtod(text, nullptr) * 1e12);
+    }
+    for (; digits < 12; digits++) {
+        fraction *= 10;
+    }
+    int64_t ps = whole * 1000000000000LL + fraction;
+    return negative ? -ps : ps;
+}
+
+ResultStoreWriter::~ResultStoreWriter()
+{
+    try {
+        close();
+    }
+    catch (const std::exception&) {
+        // Destructor of an aborted import; the incomplete store is rejected on open
+    }
+}
+
+void ResultStoreWriter::open(const std::string& fileName)
+{
+    close();
+    file = fopen(fileName.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error("Cannot create " + fileName);
+    }
+    ResultStoreHeader header;
+    memset(&header, 0, sizeof(header));
+    fwrite(&header, sizeof(header), 1, file); // completed by close()
+    offset = sizeof(header);
+}
+
+uint32_t ResultStoreWriter::intern(const std::string& text)
+{
+    auto it = stringIds.find(text);
+    if (it != stringIds.end()) {
+        return it->second;
+    }
+    uint32_t id = (uint32_t)strings.size();
+    strings.push_back(text);
+    stringIds.emplace(text, id);
+    return id;
+}
+
+uint32_t ResultStoreWriter::addRun(const std::string& runId)
+{
+    auto it = runIds.find(runId);
+    if (it != runIds.end()) {
+        return it->second;
+    }
+    uint32_t run = (uint32_t)runs.size();
+    runs.push_back(ResultRun{runId, {}});
+    runIds.emplace(runId, run);
+    return run;
+}
+
+void ResultStoreWriter::setRunAttribute(uint32_t run, const std::string& key, const std::string& value)
+{
+    runs.at(run).attributes[key] = value;
+}
+
+void ResultStoreWriter::addScalar(uint32_t run, const std::string& module, const std::string& name, double value)
+{
+    scalars.run.push_back(run);
+    scalars.module.push_back(intern(module));
+    scalars.name.push_back(intern(name));
+    scalars.value.push_back(value);
+}
+
+uint32_t ResultStoreWriter::addVector(uint32_t run, const std::string& module, const std::string& name)
+{
+    vectors.push_back(ResultVector{run, module, name, 0, 0, 0});
+    buffers.emplace_back();
+    return (uint32_t)(vectors.size() - 1);
+}
+
+void ResultStoreWriter::addSample(uint32_t vector, int64_t event, int64_t timePs, double value)
+{
+    Buffer& b = buffers[vector];
+    b.events.push_back(event);
+    b.times.push_back(timePs);
+    b.values.push_back(value);
+    vectors[vector].count++;
+    buffered++;
+    if (b.events.size() >= CHUNK_SIZE) {
+        flushVector(vector);
+    }
+    else if (buffered >= MAX_BUFFERED_SAMPLES) {
+        flushAll();
+    }
+}
+
+void ResultStoreWriter::flushVector(uint32_t vector)
+{
+    Buffer& b = buffers[vector];
+    size_t n = b.events.size();
+    if (n == 0) {
+        return;
+    }
+
+    ResultChunk chunk;
+    chunk.offset = offset;
+    chunk.count = (uint32_t)n;
+    chunk.eventMin = *std::min_element(b.events.begin(), b.events.end());
+    chunk.eventMax = *std::max_element(b.events.begin(), b.events.end());
+    chunk.timeMin = *std::min_element(b.times.begin(), b.times.end()) * 1e-12;
+    chunk.timeMax = *std::max_element(b.times.begin(), b.times.end()) * 1e-12;
+    chunk.valueMin = std::numeric_limits<double>::infinity();
+    chunk.valueMax = -std::numeric_limits<double>::infinity();
+    for (double v : b.values) {
+        if (!std::isnan(v)) {
+            chunk.valueMin = std::min(chunk.valueMin, v);
+            chunk.valueMax = std::max(chunk.valueMax, v);
+        }
+    }
+
+    encoded.clear();
+    Encoder e(encoded);
+    int64_t previous = 0;
+    for (int64_t event : b.events) {
+        e.signedVarint(event - previous);
+        previous = event;
+    }
+    previous = 0;
+    for (int64_t time : b.times) {
+        e.signedVarint(time - previous);
+        previous = time;
+    }
+    for (double value : b.values) {
+        e.xorDouble(value);
+    }
+    chunk.size = (uint32_t)encoded.size();
+    if (fwrite(encoded.data(), 1, encoded.size(), file) != encoded.size()) {
+        throw std::runtime_error("Write error");
+    }
+    offset += encoded.size();
+    chunks.push_back(PendingChunk{vector, chunk});
+
+    buffered -= std::min(buffered, n);
+    b.events.clear();
+    b.times.clear();
+    b.values.clear();
+}
+
+void ResultStoreWriter::flushAll()
+{
+    for (uint32_t v = 0; v < buffers.size(); v++) {
+        flushVector(v);
+    }
+}
+
+void ResultStoreWriter::close()
+{
+    if (!file) {
+        return;
+    }
+    flushAll();
+
+    // A vector's chunks are contiguous in the directory, in time order
+    std::stable_sort(chunks.begin(), chunks.end(), [](const PendingChunk& a, const PendingChunk& b) { return a.vector < b.vector; });
+    for (uint32_t i = 0; i < chunks.size(); i++) {
+        ResultVector& v = vectors[chunks[i].vector];
+        if (v.numChunks++ == 0) {
+            v.firstChunk = i;
+        }
+    }
+
+    std::vector<uint8_t> footer;
+    Encoder e(footer);
+    for (const ResultVector& v : vectors) {
+        intern(v.module);
+        intern(v.name);
+    }
+    for (const ResultRun& run : runs) {
+        intern(run.runId);
+        for (const auto& attr : run.attributes) {
+            intern(attr.first);
+            intern(attr.second);
+        }
+    }
+    e.varint(strings.size());
+    for (const std::string& s : strings) {
+        e.string(s);
+    }
+    e.varint(runs.size());
+    for (const ResultRun& run : runs) {
+        e.varint(intern(run.runId));
+        e.varint(run.attributes.size());
+        for (const auto& attr : run.attributes) {
+            e.varint(intern(attr.first));
+            e.varint(intern(attr.second));
+        }
+    }
+    e.varint(vectors.size());
+    for (const ResultVector& v : vectors) {
+        e.varint(v.run);
+        e.varint(intern(v.module));
+        e.varint(intern(v.name));
+        e.varint(v.firstChunk);
+        e.varint(v.numChunks);
+        e.varint(v.count);
+    }
+    e.varint(chunks.size());
+    for (const PendingChunk& pending : chunks) {
+        const ResultChunk& c = pending.chunk;
+        e.varint(c.offset);
+        e.varint(c.size);
+        e.varint(c.count);
+        e.signedVarint(c.eventMin);
+        e.signedVarint(c.eventMax);
+        e.raw(c.timeMin);
+        e.raw(c.timeMax);
+        e.raw(c.valueMin);
+        e.raw(c.valueMax);
+    }
+    size_t numScalars = scalars.value.size();
+    e.varint(numScalars);
+    for (uint32_t run : scalars.run) {
+        e.varint(run);
+    }
+    for (uint32_t module : scalars.module) {
+        e.varint(module);
+    }
+    for (uint32_t name : scalars.name) {
+        e.varint(name);
+    }
+    for (double value : scalars.value) {
+        e.xorDouble(value);
+    }
+
+    fwrite(footer.data(), 1, footer.size(), file);
+    ResultStoreHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RESULT_STORE_MAGIC, sizeof(header.magic));
+    header.version = RESULT_STORE_VERSION;
+    header.footerOffset = offset;
+    header.footerSize = footer.size();
+    fseek(file, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, file);
+    bool ok = ferror(file) == 0;
+    fclose(file);
+    file = nullptr;
+    if (!ok) {
+        throw std::runtime_error("Write error");
+    }
+}
+
+ResultStoreReader::~ResultStoreReader()
+{
+    close();
+}
+
+void ResultStoreReader::close()
+{
+    if (file) {
+        fclose(file);
+        file = nullptr;
+    }
+}
+
+void ResultStoreReader::open(const std::string& name)
+{
+    close();
+    fileName = name;
+    file = fopen(name.c_str(), "rb");
+    if (!file) {
+        throw std::runtime_error("Cannot open " + name);
+    }
+    ResultStoreHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, RESULT_STORE_MAGIC, sizeof(header.magic)) != 0) {
+        throw std::runtime_error(name + " is not a result store");
+    }
+    if (header.version != RESULT_STORE_VERSION) {
+        throw std::runtime_error(name + ": unsupported result store version");
+    }
+    if (header.footerOffset == 0) {
+        throw std::runtime_error(name + ": incomplete result store, the import was not finished");
+    }
+
+    std::vector<uint8_t> footer(header.footerSize);
+    if (fseek(file, (long)header.footerOffset, SEEK_SET) != 0 || fread(footer.data(), 1, footer.size(), file) != footer.size()) {
+        throw std::runtime_error(name + ": truncated result store");
+    }
+
+    try {
+        Decoder d(footer.data(), footer.size());
+        strings.resize(d.varint());
+        for (std::string& s : strings) {
+            s = d.string();
+        }
+        auto string = [&](uint64_t id) -> const std::string& {
+            if (id >= strings.size()) {
+                throw std::runtime_error("bad string id");
+            }
+            return strings[id];
+        };
+        runs.resize(d.varint());
+        for (ResultRun& run : runs) {
+            run.runId = string(d.varint());
+            uint64_t numAttributes = d.varint();
+            for (uint64_t i = 0; i < numAttributes; i++) {
+                const std::string& key = string(d.varint());
+                run.attributes[key] = string(d.varint());
+            }
+        }
+        vectors.resize(d.varint());
+        for (ResultVector& v : vectors) {
+            v.run = (uint32_t)d.varint();
+            v.module = string(d.varint());
+            v.name = string(d.varint());
+            v.firstChunk = (uint32_t)d.varint();
+            v.numChunks = (uint32_t)d.varint();
+            v.count = d.varint();
+        }
+        chunks.resize(d.varint());
+        for (ResultChunk& c : chunks) {
+            c.offset = d.varint();
+            c.size = (uint32_t)d.varint();
+            c.count = (uint32_t)d.varint();
+            c.eventMin = d.signedVarint();
+            c.eventMax = d.signedVarint();
+            c.timeMin = d.raw();
+            c.timeMax = d.raw();
+            c.valueMin = d.raw();
+            c.valueMax = d.raw();
+        }
+        size_t numScalars = (size_t)d.varint();
+        scalars.run.resize(numScalars);
+        scalars.module.resize(numScalars);
+        scalars.name.resize(numScalars);
+        scalars.value.resize(numScalars);
+        for (uint32_t& run : scalars.run) {
+            run = (uint32_t)d.varint();
+        }
+        for (uint32_t& module : scalars.module) {
+            module = (uint32_t)d.varint();
+        }
+        for (uint32_t& n : scalars.name) {
+            n = (uint32_t)d.varint();
+        }
+        for (double& value : scalars.value) {
+            value = d.xorDouble();
+        }
+    }
+    catch (const std::runtime_error& e) {
+        throw std::runtime_error(name + ": corrupt footer (" + e.what() + ")");
+    }
+}
+
+void ResultStoreReader::readChunk(uint32_t chunk, std::vector<ResultSample>& samples) const
+{
+    const ResultChunk& c = chunks[chunk];
+    buffer.resize(c.size);
+    if (fseek(file, (long)c.offset, SEEK_SET) != 0 || fread(buffer.data(), 1, c.size, file) != c.size) {
+        throw std::runtime_error(fileName + ": truncated chunk");
+    }
+    size_t first = samples.size();
+    samples.resize(first + c.count);
+    Decoder d(buffer.data(), buffer.size());
+    int64_t previous = 0;
+    for (uint32_t i = 0; i < c.count; i++) {
+        previous += d.signedVarint();
+        samples[first + i].event = previous;
+    }
+    previous = 0;
+    for (uint32_t i = 0; i < c.count; i++) {
+        previous += d.signedVarint();
+        samples[first + i].time = previous * 1e-12;
+    }
+    for (uint32_t i = 0; i < c.count; i++) {
+        samples[first + i].value = d.xorDouble();
+    }
+}
+
+void ResultStoreReader::readVector(uint32_t vector, double fromTime, double toTime, std::vector<ResultSample>& samples) const
+{
+    const ResultVector& v = vectors[vector];
+    for (uint32_t c = v.firstChunk; c < v.firstChunk + v.numChunks; c++) {
+        const ResultChunk& chunk = chunks[c];
+        if (chunk.timeMax < fromTime || chunk.timeMin > toTime) {
+            continue;
+        }
+        size_t first = samples.size();
+        readChunk(c, samples);
+        if (chunk.timeMin < fromTime || chunk.timeMax > toTime) {
+            auto outside = [&](const ResultSample& s) { return s.time < fromTime || s.time > toTime; };
+            samples.erase(std::remove_if(samples.begin() + first, samples.end(), outside), samples.end());
+        }
+    }
+}
+
+void ResultImporter::importFile(const std::string& fileName)
+{
+    std::ifstream in(fileName);
+    if (!in) {
+        throw std::runtime_error("Cannot open " + fileName);
+    }
+
+    const uint32_t NONE = UINT32_MAX;
+    uint32_t run = NONE;
+    bool runHeader = false;                         // attr lines still describe the run
+    std::unordered_map<long, uint32_t> fileVectors; // vector id in this file -> store vector
+    std::string statisticModule, statisticName;
+    std::vector<std::string> tokens;
+    std::string line;
+    size_t lineNumber = 0;
+
+    auto fail = [&](const std::string& message) {
+        throw std::runtime_error(fileName + ":" + std::to_string(lineNumber) + ": " + message);
+    };
+
+    while (std::getline(in, line)) {
+        lineNumber++;
+        if (line.empty()) {
+            continue;
+        }
+
+        // Vector data lines are the bulk of the input: "<id>\t<event>\t<time>\t<value>"
+        if (line[0] >= '0' && line[0] <= '9') {
+            char* p;
+            long id = std::strtol(line.c_str(), &p, 10);
+            auto it = fileVectors.find(id);
+            if (it == fileVectors.end()) {
+                fail("data for undeclared vector " + std::to_string(id));
+            }
+            int64_t event = std::strtoll(p, &p, 10);
+            while (*p == ' ' || *p == '\t') {
+                p++;
+            }
+            int64_t timePs = parseSimTimePs(p);
+            while (*p && *p != ' ' && *p != '\t') {
+                p++;
+            }
+            while (*p == ' ' || *p == '\t') {
+                p++;
+            }
+            std::string valueText = p;
+            valueText.erase(valueText.find_last_not_of("\r ") + 1);
+            writer.addSample(it->second, event, timePs, parseValue(valueText));
+            continue;
+        }
+
+        tokenize(line, tokens);
+        const std::string& kind = tokens[0];
+        if (kind == "run" && tokens.size() >= 2) {
+            run = writer.addRun(tokens[1]);
+            runHeader = true;
+            fileVectors.clear();
+            continue;
+        }
+        if (kind == "version" || kind == "param" || kind == "config" || kind == "bin" || kind == "file") {
+            continue;
+        }
+        if (run == NONE) {
+            fail("result before the first run line");
+        }
+        if (kind == "attr" && tokens.size() >= 3) {
+            if (runHeader) {
+                writer.setRunAttribute(run, tokens[1], tokens[2]);
+            }
+        }
+        else if (kind == "itervar" && tokens.size() >= 3) {
+            // String iteration values are written quoted ("\"greedy\"")
+            std::string value = tokens[2];
+            if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+                value = value.substr(1, value.size() - 2);
+            }
+            writer.setRunAttribute(run, "$" + tokens[1], value);
+        }
+        else if (kind == "scalar" && tokens.size() >= 4) {
+            runHeader = false;
+            writer.addScalar(run, tokens[1], tokens[2], parseValue(tokens[3]));
+        }
+        else if (kind == "statistic" && tokens.size() >= 3) {
+            runHeader = false;
+            statisticModule = tokens[1];
+            statisticName = tokens[2];
+        }
+        else if (kind == "field" && tokens.size() >= 3) {
+            writer.addScalar(run, statisticModule, statisticName + ":" + tokens[1], parseValue(tokens[2]));
+        }
+        else if (kind == "vector" && tokens.size() >= 4) {
+            runHeader = false;
+            std::string columns = tokens.size() >= 5 ? tokens[4] : "ETV";
+            if (columns != "ETV") {
+                fail("unsupported vector columns " + columns + ", record with the default ETV");
+            }
+            fileVectors[std::strtol(tokens[1].c_str(), nullptr, 10)] = writer.addVector(run, tokens[2], tokens[3]);
+        }
+        else {
+            fail("unexpected line: " + line);
+        }
+    }
+}
+
+} // namespace lasp_tools
@@ -0,0 +1,183 @@
+//
+// Compressed columnar store for OMNeT++ result files (.sca and .vec).
+//
+// ResultImporter streams any number of result files into a ResultStoreWriter
+// in one pass per file. Vector samples are buffered per vector and written as
+// chunks of at most ResultStoreWriter::CHUNK_SIZE samples, so memory stays
+// bounded regardless of the input size. Inside a chunk every column is stored
+// on its own:
+//
+//   event numbers  zigzag varint deltas
+//   times          simtime as integer picoseconds, zigzag varint deltas
+//   values         XOR with the previous value, leading/trailing zero bytes
+//                  dropped
+//
+// The chunk directory keeps min/max of every column, so readers skip chunks
+// outside a time window without decoding them. Runs (with their attributes
+// and iteration variables), vectors, chunks and the scalar table live in a
+// footer at the end of the file; scalars include the fields of statistic
+// blocks as "<name>:<field>".
+//
+// File layout: ResultStoreHeader, chunk data, footer (offset in the header).
+//
+
+#ifndef LASP_RESULTSTORE_H
+#define LASP_RESULTSTORE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lasp_tools {
+
+struct ResultRun {
+    std::string runId;
+    std::map<std::string, std::string> attributes; // attr lines; itervar lines as "$name"
+
+    // Value of an attribute or "$itervar", "" if missing
+    std::string get(const std::string& key) const;
+};
+
+struct ResultVector {
+    uint32_t run;
+    std::string module;
+    std::string name;
+    uint32_t firstChunk;
+    uint32_t numChunks;
+    uint64_t count;
+};
+
+struct ResultChunk {
+    uint64_t offset;
+    uint32_t size;      // bytes
+    uint32_t count;     // samples
+    int64_t eventMin, eventMax;
+    double timeMin, timeMax;
+    double valueMin, valueMax;
+};
+
+struct ResultSample {
+    int64_t event;
+    double time;
+    double value;
+};
+
+// Scalar table, one entry per column
+struct ResultScalars {
+    std::vector<uint32_t> run;
+    std::vector<uint32_t> module; // index into the string table
+    std::vector<uint32_t> name;
+    std::vector<double> value;
+};
+
+class ResultStoreWriter {
+public:
+    static const uint32_t CHUNK_SIZE = 4096;
+    static const size_t MAX_BUFFERED_SAMPLES = 1 << 22; // across all vectors
+
+    ResultStoreWriter() = default;
+    ~ResultStoreWriter();
+
+    // Throws std::runtime_error on I/O errors
+    void open(const std::string& fileName);
+    void close();
+
+    // Returns the index of the run, adding it on first use
+    uint32_t addRun(const std::string& runId);
+    void setRunAttribute(uint32_t run, const std::string& key, const std::string& value);
+    void addScalar(uint32_t run, const std::string& module, const std::string& name, double value);
+    uint32_t addVector(uint32_t run, const std::string& module, const std::string& name);
+    void addSample(uint32_t vector, int64_t event, int64_t timePs, double value);
+
+private:
+    ResultStoreWriter(const ResultStoreWriter&) = delete;
+    ResultStoreWriter& operator=(const ResultStoreWriter&) = delete;
+
+    struct Buffer {
+        std::vector<int64_t> events;
+        std::vector<int64_t> times;
+        std::vector<double> values;
+    };
+    struct PendingChunk {
+        uint32_t vector;
+        ResultChunk chunk;
+    };
+
+    uint32_t intern(const std::string& text);
+    void flushVector(uint32_t vector);
+    void flushAll();
+
+    FILE* file = nullptr;
+    uint64_t offset = 0;
+    std::vector<std::string> strings;
+    std::unordered_map<std::string, uint32_t> stringIds;
+    std::vector<ResultRun> runs;
+    std::unordered_map<std::string, uint32_t> runIds;
+    std::vector<ResultVector> vectors;
+    std::vector<Buffer> buffers;
+    size_t buffered = 0;
+    std::vector<PendingChunk> chunks;
+    ResultScalars scalars;
+    std::vector<uint8_t> encoded;
+};
+
+class ResultStoreReader {
+public:
+    ResultStoreReader() = default;
+    ~ResultStoreReader();
+
+    // Throws std::runtime_error on missing or malformed stores
+    void open(const std::string& fileName);
+    void close();
+
+    const std::vector<ResultRun>& getRuns() const { return runs; }
+    const std::vector<ResultVector>& getVectors() const { return vectors; }
+    const ResultChunk& getChunk(uint32_t chunk) const { return chunks[chunk]; }
+    const ResultScalars& getScalars() const { return scalars; }
+    const std::string& getString(uint32_t id) const { return strings[id]; }
+
+    // Appends the samples of one chunk to samples
+    void readChunk(uint32_t chunk, std::vector<ResultSample>& samples) const;
+    // Appends the samples of a vector with fromTime <= time <= toTime; chunks
+    // outside the window are skipped using their min/max
+    void readVector(uint32_t vector, double fromTime, double toTime, std::vector<ResultSample>& samples) const;
+
+private:
+    ResultStoreReader(const ResultStoreReader&) = delete;
+    ResultStoreReader& operator=(const ResultStoreReader&) = delete;
+
+    FILE* file = nullptr;
+    std::string fileName;
+    mutable std::vector<uint8_t> buffer;
+    std::vector<std::string> strings;
+    std::vector<ResultRun> runs;
+    std::vector<ResultVector> vectors;
+    std::vector<ResultChunk> chunks;
+    ResultScalars scalars;
+};
+
+// Parses OMNeT++ 5.x/6.x .sca and .vec files into a ResultStoreWriter
+class ResultImporter {
+public:
+    explicit ResultImporter(ResultStoreWriter& writer) : writer(writer) {}
+
+    // Throws std::runtime_error if the file cannot be read or is malformed
+    void importFile(const std::string& fileName);
+
+private:
+    ResultStoreWriter& writer;
+};
+
+// Glob match with '*' (any run of characters) and '?' (one character)
+bool globMatch(const char* pattern, const char* text);
+
+// Simulation time text ("12.0345") as integer picoseconds, exact for
+// OMNeT++'s default time resolution
+int64_t parseSimTimePs(const char* text);
+
+} // namespace lasp_tools
+
+#endif
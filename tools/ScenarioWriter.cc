@@ -0,0 +1,494 @@
+#include "ScenarioWriter.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <map>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+namespace lasp_tools {
+
+namespace {
+
+const double LANE_WIDTH = 3.2;
+
+class OutputFile {
+public:
+    explicit OutputFile(const std::string& fileName) : file(fopen(fileName.c_str(), "w"))
+    {
+        if (!file) {
+            throw std::runtime_error("Cannot write " + fileName);
+        }
+    }
+    ~OutputFile() { fclose(file); }
+    operator FILE *() const { return file; }
+
+private:
+    FILE *file;
+};
+
+const char *layoutName(Layout layout)
+{
+    return layout == Layout::Arterial ? "arterial" : "grid";
+}
+
+} // namespace
+
+void makeDirectories(const std::string& path)
+{
+    for (size_t pos = 0; pos != std::string::npos;) {
+        pos = path.find_first_of("/\\", pos + 1);
+        std::string prefix = path.substr(0, pos);
+        if (prefix.empty()) {
+            continue;
+        }
+#ifdef _WIN32
+        int result = _mkdir(prefix.c_str());
+#else
+        int result = mkdir(prefix.c_str(), 0755);
+#endif
+        if (result != 0 && errno != EEXIST) {
+            throw std::runtime_error("Cannot create directory " + prefix);
+        }
+    }
+}
+
+std::vector<DemandPoint> parseDemandCurve(const std::string& text, double departEnd)
+{
+    if (text == "uniform") {
+        return { {0.0, 1.0}, {departEnd, 1.0} };
+    }
+    if (text == "peak") {
+        return { {0.0, 0.2}, {departEnd * 0.3, 0.4}, {departEnd * 0.5, 1.0}, {departEnd * 0.7, 0.4}, {departEnd, 0.2} };
+    }
+    if (text == "ramp") {
+        return { {0.0, 0.1}, {departEnd, 1.0} };
+    }
+
+    std::vector<DemandPoint> curve;
+    std::stringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        size_t colon = item.find(':');
+        if (colon == std::string::npos) {
+            throw std::runtime_error("Demand point '" + item + "' is not time:rate");
+        }
+        curve.push_back(DemandPoint{std::atof(item.substr(0, colon).c_str()), std::atof(item.substr(colon + 1).c_str())});
+    }
+    return curve;
+}
+
+ScenarioWriter::ScenarioWriter(const ScenarioSpec& spec) : spec(spec)
+{
+    bool hasArterials = spec.layout == Layout::Arterial || spec.arterialSpacing > 0;
+    junctionRadius = 1.5 * LANE_WIDTH * (hasArterials ? std::max(1, spec.arterialLanes) : 1);
+
+    if (spec.gridColumns < 2 || numRows() < 2 || spec.blockLength <= 2 * junctionRadius) {
+        throw std::runtime_error("Scenario grid must be at least 2x2 junctions with blocks longer than the junctions");
+    }
+    if (spec.arterialLanes < 1 || spec.arterialSpacing < 0) {
+        throw std::runtime_error("Arterials need at least one lane and a non-negative spacing");
+    }
+    if (spec.numVehicles < 0 || spec.numEdgeServers < 1) {
+        throw std::runtime_error("Scenario needs at least one edge server");
+    }
+
+    outgoing.resize(spec.gridColumns * numRows());
+    incoming.resize(spec.gridColumns * numRows());
+    if (spec.layout == Layout::Grid) {
+        // Two-way streets between all horizontally and vertically adjacent junctions
+        for (int row = 0; row < spec.gridRows; row++) {
+            for (int column = 0; column < spec.gridColumns; column++) {
+                if (column + 1 < spec.gridColumns) {
+                    addStreet(junctionIndex(column, row), junctionIndex(column + 1, row), isArterialStreet(row));
+                }
+                if (row + 1 < spec.gridRows) {
+                    addStreet(junctionIndex(column, row), junctionIndex(column, row + 1), isArterialStreet(column));
+                }
+            }
+        }
+    }
+    else {
+        // Arterial along the middle row, one block of side street above and below each junction
+        for (int column = 0; column < spec.gridColumns; column++) {
+            if (column + 1 < spec.gridColumns) {
+                addStreet(junctionIndex(column, 1), junctionIndex(column + 1, 1), true);
+            }
+            addStreet(junctionIndex(column, 0), junctionIndex(column, 1), false);
+            addStreet(junctionIndex(column, 1), junctionIndex(column, 2), false);
+        }
+    }
+
+    // Vehicles enter and leave at the edge of the network
+    for (size_t j = 0; j < outgoing.size(); j++) {
+        if (!outgoing[j].empty() && outgoing[j].size() < 4) {
+            fringe.push_back((int)j);
+        }
+    }
+
+    if (spec.layout == Layout::Grid) {
+        // Edge servers on a regular sub-grid, each in the middle of its cell
+        int cellsX = (int)std::ceil(std::sqrt((double)spec.numEdgeServers));
+        int cellsY = (spec.numEdgeServers + cellsX - 1) / cellsX;
+        for (int i = 0; i < spec.numEdgeServers; i++) {
+            double x = (i % cellsX + 0.5) * getWidth() / cellsX;
+            double y = (i / cellsX + 0.5) * getHeight() / cellsY;
+            edgeServerPositions.push_back(Point{x, y});
+        }
+    }
+    else {
+        // Evenly spaced along the arterial, alternating sides of the road
+        for (int i = 0; i < spec.numEdgeServers; i++) {
+            double x = (i + 0.5) * getWidth() / spec.numEdgeServers;
+            double y = spec.blockLength + (i % 2 == 0 ? -0.5 : 0.5) * spec.blockLength;
+            edgeServerPositions.push_back(Point{x, y});
+        }
+    }
+}
+
+bool ScenarioWriter::isArterialStreet(int index) const
+{
+    return spec.arterialSpacing > 0 && index % spec.arterialSpacing == 0;
+}
+
+void ScenarioWriter::addStreet(int a, int b, bool arterial)
+{
+    int lanes = arterial ? spec.arterialLanes : 1;
+    double speed = arterial ? spec.arterialSpeedLimit : spec.speedLimit;
+    for (int k = 0; k < 2; k++) {
+        int from = k == 0 ? a : b;
+        int to = k == 0 ? b : a;
+        outgoing[from].push_back((int)edges.size());
+        incoming[to].push_back((int)edges.size());
+        edges.push_back(Edge{junctionId(from) + "to" + junctionId(to), from, to, lanes, speed});
+    }
+}
+
+std::string ScenarioWriter::managerAddress()
+{
+    return "192.168.1.100";
+}
+
+// The first 55 servers keep 192.168.1.200 .. 192.168.1.254, later ones fill
+// 192.168.2.0/24 onwards and the topology netmask widens to /16
+static const int SERVERS_IN_FIRST_SUBNET = 55;
+
+std::string ScenarioWriter::edgeServerAddress(int serverId)
+{
+    if (serverId < SERVERS_IN_FIRST_SUBNET) {
+        return "192.168.1." + std::to_string(200 + serverId);
+    }
+    int k = serverId - SERVERS_IN_FIRST_SUBNET;
+    return "192.168." + std::to_string(2 + k / 254) + "." + std::to_string(1 + k % 254);
+}
+
+int ScenarioWriter::maxEdgeServers()
+{
+    return SERVERS_IN_FIRST_SUBNET + 253 * 254; // up to 192.168.254.254
+}
+
+Point ScenarioWriter::junctionPosition(int junction) const
+{
+    return Point{(junction % spec.gridColumns) * spec.blockLength, (junction / spec.gridColumns) * spec.blockLength};
+}
+
+std::string ScenarioWriter::junctionId(int junction) const
+{
+    return "j" + std::to_string(junction % spec.gridColumns) + "_" + std::to_string(junction / spec.gridColumns);
+}
+
+std::vector<double> ScenarioWriter::getDepartTimes() const
+{
+    std::vector<DemandPoint> curve = spec.demand;
+    if (curve.empty()) {
+        curve = parseDemandCurve("uniform", spec.departEnd);
+    }
+
+    std::vector<double> cumulative(1, 0.0);
+    for (size_t k = 0; k + 1 < curve.size(); k++) {
+        const DemandPoint& p = curve[k];
+        const DemandPoint& q = curve[k + 1];
+        if (q.time <= p.time || p.rate < 0 || q.rate < 0) {
+            throw std::runtime_error("Demand curve needs increasing times and non-negative rates");
+        }
+        cumulative.push_back(cumulative.back() + (q.time - p.time) * (p.rate + q.rate) / 2);
+    }
+    if (curve.size() < 2 || cumulative.back() <= 0) {
+        throw std::runtime_error("Demand curve needs at least two points and a positive rate");
+    }
+
+    // Vehicle i departs where the cumulative demand reaches (i + 0.5) / n of the total
+    std::vector<double> departs;
+    size_t k = 0;
+    for (int i = 0; i < spec.numVehicles; i++) {
+        double target = (i + 0.5) / spec.numVehicles * cumulative.back();
+        while (cumulative[k + 1] < target) {
+            k++;
+        }
+        const DemandPoint& p = curve[k];
+        const DemandPoint& q = curve[k + 1];
+        double area = target - cumulative[k];
+        double slope = (q.rate - p.rate) / (q.time - p.time);
+        // Solve p.rate * t + slope * t^2 / 2 = area within the segment
+        double t = std::fabs(slope) < 1e-12 ? (p.rate > 0 ? area / p.rate : 0.0)
+                                            : (std::sqrt(std::max(0.0, p.rate * p.rate + 2 * slope * area)) - p.rate) / slope;
+        departs.push_back(p.time + std::min(std::max(t, 0.0), q.time - p.time));
+    }
+    return departs;
+}
+
+std::vector<int> ScenarioWriter::shortestPathTree(int from) const
+{
+    // Dijkstra on free-flow travel time; returns the edge leading into each junction, -1 if none
+    std::vector<double> cost(outgoing.size(), std::numeric_limits<double>::infinity());
+    std::vector<int> via(outgoing.size(), -1);
+    typedef std::pair<double, int> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    cost[from] = 0.0;
+    queue.push(Entry(0.0, from));
+    while (!queue.empty()) {
+        Entry top = queue.top();
+        queue.pop();
+        if (top.first > cost[top.second]) {
+            continue;
+        }
+        for (int e : outgoing[top.second]) {
+            double c = top.first + spec.blockLength / edges[e].speed;
+            if (c < cost[edges[e].to]) {
+                cost[edges[e].to] = c;
+                via[edges[e].to] = e;
+                queue.push(Entry(c, edges[e].to));
+            }
+        }
+    }
+    return via;
+}
+
+void ScenarioWriter::write(const std::string& directory, const std::string& baseIni) const
+{
+    if (spec.numEdgeServers > maxEdgeServers()) {
+        throw std::runtime_error("Edge server addresses are limited to " + std::to_string(maxEdgeServers()) + " servers");
+    }
+
+    makeDirectories(directory);
+    writeNet(directory + "/scenario.net.xml");
+    writeRoutes(directory + "/scenario.rou.xml");
+    writeSumoConfig(directory + "/scenario.sumocfg");
+    writeLaunchConfig(directory + "/launchd.xml");
+    writeTopology(directory + "/topology.xml");
+    writeIni(directory + "/scenario.ini", baseIni);
+}
+
+void ScenarioWriter::writeNet(const std::string& fileName) const
+{
+    OutputFile f(fileName);
+    double width = getWidth();
+    double height = getHeight();
+    double r = junctionRadius;
+
+    // Plain network without internal lanes, as netconvert --no-internal-links would write it
+    fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n\n");
+    fprintf(f, "<!-- generated by the LASP scenario writer, seed %u -->\n\n", spec.seed);
+    fprintf(f, "<net version=\"1.9\" junctionCornerDetail=\"5\" limitTurnSpeed=\"5.50\" xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" xsi:noNamespaceSchemaLocation=\"http://sumo.dlr.de/xsd/net_file.xsd\">\n\n");
+    fprintf(f, "    <location netOffset=\"0.00,0.00\" convBoundary=\"0.00,0.00,%.2f,%.2f\" origBoundary=\"0.00,0.00,%.2f,%.2f\" projParameter=\"!\"/>\n\n", width, height, width, height);
+
+    for (const Edge& edge : edges) {
+        Point a = junctionPosition(edge.from);
+        Point b = junctionPosition(edge.to);
+        double dx = (b.x - a.x) / spec.blockLength;
+        double dy = (b.y - a.y) / spec.blockLength;
+        fprintf(f, "    <edge id=\"%s\" from=\"%s\" to=\"%s\" priority=\"%d\">\n", edge.id.c_str(), junctionId(edge.from).c_str(), junctionId(edge.to).c_str(), edge.lanes > 1 ? 2 : 1);
+        for (int lane = 0; lane < edge.lanes; lane++) {
+            // Right-hand traffic: lane 0 is the rightmost, the last lane runs next to the centre line
+            double offset = (edge.lanes - lane - 0.5) * LANE_WIDTH;
+            double ox = dy * offset;
+            double oy = -dx * offset;
+            fprintf(f, "        <lane id=\"%s_%d\" index=\"%d\" speed=\"%.2f\" length=\"%.2f\" shape=\"%.2f,%.2f %.2f,%.2f\"/>\n",
+                    edge.id.c_str(), lane, lane, edge.speed, spec.blockLength - 2 * r,
+                    a.x + dx * r + ox, a.y + dy * r + oy, b.x - dx * r + ox, b.y - dy * r + oy);
+        }
+        fprintf(f, "    </edge>\n");
+    }
+    fprintf(f, "\n");
+
+    for (size_t j = 0; j < outgoing.size(); j++) {
+        Point p = junctionPosition((int)j);
+        std::string incLanes;
+        for (int e : incoming[j]) {
+            for (int lane = 0; lane < edges[e].lanes; lane++) {
+                incLanes += (incLanes.empty() ? "" : " ") + edges[e].id + "_" + std::to_string(lane);
+            }
+        }
+        fprintf(f, "    <junction id=\"%s\" type=\"%s\" x=\"%.2f\" y=\"%.2f\" incLanes=\"%s\" intLanes=\"\" shape=\"%.2f,%.2f %.2f,%.2f %.2f,%.2f %.2f,%.2f\"/>\n",
+                junctionId((int)j).c_str(), outgoing[j].size() == 1 ? "dead_end" : "unregulated", p.x, p.y, incLanes.c_str(),
+                p.x - r, p.y - r, p.x + r, p.y - r, p.x + r, p.y + r, p.x - r, p.y + r);
+    }
+    fprintf(f, "\n");
+
+    // Every turn except U-turns: straight on from every lane, right turns from
+    // the rightmost and left turns from the leftmost lane
+    for (const Edge& in : edges) {
+        Point a = junctionPosition(in.from);
+        Point b = junctionPosition(in.to);
+        for (int e : outgoing[in.to]) {
+            const Edge& out = edges[e];
+            if (out.to == in.from) {
+                continue;
+            }
+            Point c = junctionPosition(out.to);
+            double cross = (b.x - a.x) * (c.y - b.y) - (b.y - a.y) * (c.x - b.x);
+            for (int lane = 0; lane < in.lanes; lane++) {
+                int toLane;
+                const char *dir;
+                if (cross > 0 && lane == in.lanes - 1) {
+                    dir = "l";
+                    toLane = out.lanes - 1;
+                }
+                else if (cross < 0 && lane == 0) {
+                    dir = "r";
+                    toLane = 0;
+                }
+                else if (cross == 0) {
+                    dir = "s";
+                    toLane = std::min(lane, out.lanes - 1);
+                }
+                else {
+                    continue;
+                }
+                fprintf(f, "    <connection from=\"%s\" to=\"%s\" fromLane=\"%d\" toLane=\"%d\" dir=\"%s\" state=\"M\"/>\n",
+                        in.id.c_str(), out.id.c_str(), lane, toLane, dir);
+            }
+        }
+    }
+    fprintf(f, "\n</net>\n");
+}
+
+void ScenarioWriter::writeRoutes(const std::string& fileName) const
+{
+    OutputFile f(fileName);
+    std::mt19937 rng(spec.seed);
+    std::vector<double> departs = getDepartTimes();
+    bool hasArterials = spec.layout == Layout::Arterial || spec.arterialSpacing > 0;
+    double maxSpeed = hasArterials ? std::max(spec.speedLimit, spec.arterialSpeedLimit) : spec.speedLimit;
+
+    fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n\n");
+    fprintf(f, "<!-- generated by the LASP scenario writer, seed %u -->\n\n", spec.seed);
+    fprintf(f, "<routes>\n");
+    fprintf(f, "    <vType id=\"vtype0\" accel=\"2.6\" decel=\"4.5\" sigma=\"0.5\" length=\"4.5\" minGap=\"2.5\" maxSpeed=\"%.2f\" color=\"1,1,0\"/>\n", maxSpeed);
+
+    // Each vehicle takes the fastest route between two random fringe junctions.
+    // Shortest path trees are cached per origin, so this stays cheap for tens of
+    // thousands of vehicles.
+    std::map<int, std::vector<int>> trees;
+    std::uniform_int_distribution<size_t> fringeDist(0, fringe.size() - 1);
+    for (int i = 0; i < spec.numVehicles; i++) {
+        int from = fringe[fringeDist(rng)];
+        int to = from;
+        while (to == from) {
+            to = fringe[fringeDist(rng)];
+        }
+        auto tree = trees.find(from);
+        if (tree == trees.end()) {
+            tree = trees.insert(std::make_pair(from, shortestPathTree(from))).first;
+        }
+
+        std::vector<int> route;
+        for (int j = to; j != from; j = edges[tree->second[j]].from) {
+            route.push_back(tree->second[j]);
+        }
+        std::string routeEdges;
+        for (auto e = route.rbegin(); e != route.rend(); ++e) {
+            routeEdges += (routeEdges.empty() ? "" : " ") + edges[*e].id;
+        }
+
+        fprintf(f, "    <vehicle id=\"veh%d\" type=\"vtype0\" depart=\"%.2f\" departLane=\"best\" departSpeed=\"max\">\n", i, departs[i]);
+        fprintf(f, "        <route edges=\"%s\"/>\n", routeEdges.c_str());
+        fprintf(f, "    </vehicle>\n");
+    }
+    fprintf(f, "</routes>\n");
+}
+
+void ScenarioWriter::writeSumoConfig(const std::string& fileName) const
+{
+    OutputFile f(fileName);
+    fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    fprintf(f, "<configuration xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" xsi:noNamespaceSchemaLocation=\"http://sumo.dlr.de/xsd/sumoConfiguration.xsd\">\n");
+    fprintf(f, "    <input>\n");
+    fprintf(f, "        <net-file value=\"scenario.net.xml\"/>\n");
+    fprintf(f, "        <route-files value=\"scenario.rou.xml\"/>\n");
+    fprintf(f, "    </input>\n");
+    fprintf(f, "    <time>\n");
+    fprintf(f, "        <begin value=\"0\"/>\n");
+    fprintf(f, "        <end value=\"%g\"/>\n", spec.simTime);
+    fprintf(f, "        <step-length value=\"%g\"/>\n", spec.stepLength);
+    fprintf(f, "    </time>\n");
+    fprintf(f, "    <processing>\n");
+    fprintf(f, "        <collision.action value=\"warn\"/>\n");
+    fprintf(f, "        <time-to-teleport value=\"300\"/>\n");
+    fprintf(f, "        <max-depart-delay value=\"120\"/>\n");
+    fprintf(f, "    </processing>\n");
+    fprintf(f, "    <report>\n");
+    fprintf(f, "        <no-step-log value=\"true\"/>\n");
+    fprintf(f, "    </report>\n");
+    fprintf(f, "</configuration>\n");
+}
+
+void ScenarioWriter::writeLaunchConfig(const std::string& fileName) const
+{
+    OutputFile f(fileName);
+    fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    fprintf(f, "<launch>\n");
+    fprintf(f, "    <copy file=\"scenario.sumocfg\" type=\"config\" />\n");
+    fprintf(f, "    <copy file=\"scenario.net.xml\" type=\"data\" />\n");
+    fprintf(f, "    <copy file=\"scenario.rou.xml\" type=\"data\" />\n");
+    fprintf(f, "</launch>\n");
+}
+
+void ScenarioWriter::writeTopology(const std::string& fileName) const
+{
+    OutputFile f(fileName);
+    fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    fprintf(f, "<topology netmask=\"%s\">\n", spec.numEdgeServers > SERVERS_IN_FIRST_SUBNET ? "255.255.0.0" : "255.255.255.0");
+    fprintf(f, "    <manager address=\"%s\" port=\"15000\" x=\"%.2f\" y=\"%.2f\" z=\"20\"/>\n", managerAddress().c_str(), getWidth() / 2, getHeight() / 2);
+    for (int i = 0; i < spec.numEdgeServers; i++) {
+        fprintf(f, "    <server id=\"%d\" address=\"%s\" port=\"%d\" x=\"%.2f\" y=\"%.2f\" z=\"15\" computeCapacity=\"100\" storageCapacity=\"1000\"/>\n",
+                i, edgeServerAddress(i).c_str(), 8000 + i, edgeServerPositions[i].x, edgeServerPositions[i].y);
+    }
+    fprintf(f, "    <multicast-group hosts=\"*\" address=\"224.0.0.1\"/>\n");
+    fprintf(f, "</topology>\n");
+}
+
+void ScenarioWriter::writeIni(const std::string& fileName, const std::string& baseIni) const
+{
+    OutputFile f(fileName);
+    double width = getWidth();
+    double height = getHeight();
+
+    fprintf(f, "# Generated by the LASP scenario writer, seed %u\n", spec.seed);
+    fprintf(f, "include %s\n\n", baseIni.c_str());
+    fprintf(f, "[Config Scenario]\n");
+    fprintf(f, "description = \"Generated %dx%d %s, %d vehicles, %d edge servers\"\n",
+            spec.gridColumns, numRows(), layoutName(spec.layout), spec.numVehicles, spec.numEdgeServers);
+    fprintf(f, "sim-time-limit = %gs\n", spec.simTime);
+    fprintf(f, "*.playgroundSizeX = %.0fm\n", width + 50);
+    fprintf(f, "*.playgroundSizeY = %.0fm\n", height + 50);
+    fprintf(f, "*.veinsManager.launchConfig = xmldoc(\"launchd.xml\")\n");
+    fprintf(f, "*.veinsManager.sumoConfig = \"scenario.sumocfg\"\n");
+    fprintf(f, "*.topology = xmldoc(\"topology.xml\")\n");
+    for (const std::string& entry : spec.extraIniEntries) {
+        fprintf(f, "%s\n", entry.c_str());
+    }
+}
+
+} // namespace lasp_tools
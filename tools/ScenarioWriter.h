@@ -0,0 +1,123 @@
+//
+// Writes a self-contained LASP scenario directory: SUMO network, routes and
+// configuration, the veins_launchd launch file, the edge topology descriptor
+// (manager and edge server positions, capacities and addresses) and an ini
+// file that includes the main LASP ini and overrides the scenario-specific
+// settings in [Config Scenario].
+//
+// Output is fully determined by the ScenarioSpec (including its seed).
+//
+
+#ifndef LASP_SCENARIOWRITER_H
+#define LASP_SCENARIOWRITER_H
+
+#include <string>
+#include <vector>
+
+namespace lasp_tools {
+
+enum class Layout {
+    Grid,      // Manhattan grid, optionally with every n-th street an arterial
+    Arterial   // one arterial along x with side streets on both sides
+};
+
+// One point of a piecewise-linear departure rate profile. Rates are relative;
+// only the shape of the curve matters.
+struct DemandPoint {
+    double time;   // s
+    double rate;
+};
+
+struct ScenarioSpec {
+    Layout layout = Layout::Grid;
+    int gridColumns = 3;           // junctions along x
+    int gridRows = 3;              // junctions along y (ignored by Layout::Arterial)
+    double blockLength = 100.0;    // m between neighbouring junctions
+    double speedLimit = 13.89;     // m/s
+    int arterialSpacing = 0;       // Grid: every n-th row and column is an arterial, 0 for none
+    int arterialLanes = 2;         // lanes per direction
+    double arterialSpeedLimit = 19.44;
+
+    int numVehicles = 10;
+    double departEnd = 100.0;      // departures span [0, departEnd) s
+    std::vector<DemandPoint> demand; // empty means a constant rate
+    double simTime = 200.0;        // s
+    double stepLength = 0.1;       // SUMO step, s
+
+    int numEdgeServers = 4;
+    unsigned seed = 1;
+
+    // Extra "key = value" lines for [Config Scenario]
+    std::vector<std::string> extraIniEntries;
+};
+
+// Named demand curves over [0, departEnd): "uniform", "peak" (rush hour in the
+// middle), "ramp" (linearly increasing) or explicit "t:rate,t:rate,...".
+// Throws std::runtime_error for unknown names or malformed points.
+std::vector<DemandPoint> parseDemandCurve(const std::string& text, double departEnd);
+
+struct Point {
+    double x;
+    double y;
+};
+
+class ScenarioWriter {
+public:
+    explicit ScenarioWriter(const ScenarioSpec& spec);
+
+    // Creates `directory` if needed and writes all scenario files into it. The
+    // generated ini includes `baseIni` (an absolute path works from anywhere).
+    // Throws std::runtime_error on I/O errors or unrepresentable scenarios.
+    void write(const std::string& directory, const std::string& baseIni) const;
+
+    double getWidth() const { return (spec.gridColumns - 1) * spec.blockLength; }
+    double getHeight() const { return (numRows() - 1) * spec.blockLength; }
+    const std::vector<Point>& getEdgeServerPositions() const { return edgeServerPositions; }
+
+    // Departure times of all vehicles, ascending, following the demand curve
+    std::vector<double> getDepartTimes() const;
+
+    // Addresses written to the topology; vehicles take theirs from the default <vehicles> pool 10.1.0.0/16
+    static std::string managerAddress();
+    static std::string edgeServerAddress(int serverId);
+    static int maxEdgeServers();
+
+private:
+    struct Edge {
+        std::string id;
+        int from;    // junction index
+        int to;
+        int lanes;
+        double speed;
+    };
+
+    int numRows() const { return spec.layout == Layout::Arterial ? 3 : spec.gridRows; }
+    int junctionIndex(int column, int row) const { return row * spec.gridColumns + column; }
+    bool isArterialStreet(int index) const;
+    void addStreet(int a, int b, bool arterial);
+    Point junctionPosition(int junction) const;
+    std::string junctionId(int junction) const;
+    std::vector<int> shortestPathTree(int from) const;
+
+    void writeNet(const std::string& fileName) const;
+    void writeRoutes(const std::string& fileName) const;
+    void writeSumoConfig(const std::string& fileName) const;
+    void writeLaunchConfig(const std::string& fileName) const;
+    void writeTopology(const std::string& fileName) const;
+    void writeIni(const std::string& fileName, const std::string& baseIni) const;
+
+    ScenarioSpec spec;
+    double junctionRadius;           // lanes stop this far from the junction centre
+    std::vector<Edge> edges;
+    std::vector<std::vector<int>> outgoing; // edge indices per junction
+    std::vector<std::vector<int>> incoming;
+    std::vector<int> fringe;         // junctions where vehicles enter and leave
+    std::vector<Point> edgeServerPositions;
+};
+
+// Creates a directory and its parents; throws std::runtime_error on failure
+void makeDirectories(const std::string& path);
+
+} // namespace lasp_tools
+
+#endif // LASP_SCENARIOWRITER_H
@@ -0,0 +1,122 @@
+#include "SequentialController.h"
+
+#include "ResultStore.h"
+#include "Statistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace lasp_tools {
+
+SequentialController::SequentialController(const Settings& settings, const std::vector<std::string>& groups)
+    : settings(settings), groups(groups), observations(groups.size()), scheduled(groups.size(), 0)
+{
+    this->settings.minReps = std::max(2, std::min(settings.minReps, settings.maxReps));
+    this->settings.roundSize = std::max(1, settings.roundSize);
+    int extraRounds = (this->settings.maxReps - this->settings.minReps + this->settings.roundSize - 1) / this->settings.roundSize;
+    maxLooks = 1 + std::max(0, extraRounds);
+
+    for (int a = 0; a < (int)groups.size(); a++) {
+        for (int b = 0; b < (int)groups.size(); b++) {
+            bool pair;
+            if (settings.baseline.empty()) {
+                pair = a < b;
+            }
+            else {
+                pair = a != b && globMatch(settings.baseline.c_str(), groups[b].c_str()) && !globMatch(settings.baseline.c_str(), groups[a].c_str());
+            }
+            if (pair) {
+                Comparison c;
+                c.a = a;
+                c.b = b;
+                comparisons.push_back(c);
+            }
+        }
+    }
+}
+
+void SequentialController::addObservation(int group, double value)
+{
+    if (!std::isnan(value)) {
+        observations[group].push_back(value);
+    }
+}
+
+void SequentialController::update()
+{
+    double alphaPerLook = settings.alpha / maxLooks;
+    for (Comparison& c : comparisons) {
+        if (c.decision != Decision::Undecided) {
+            continue;
+        }
+        const std::vector<double>& a = observations[c.a];
+        const std::vector<double>& b = observations[c.b];
+        if ((int)a.size() < settings.minReps || (int)b.size() < settings.minReps) {
+            continue;
+        }
+
+        c.looks++;
+        TestResult welch = welchTTest(a, b);
+        Summary sa = summarize(a), sb = summarize(b);
+        double se = std::sqrt(sa.stddev * sa.stddev / sa.n + sb.stddev * sb.stddev / sb.n);
+        c.difference = sa.mean - sb.mean;
+        c.p = welch.p;
+        c.halfWidth = welch.df > 0 ? studentTQuantile(1.0 - settings.alpha / 2.0, welch.df) * se : 0.0;
+
+        if (welch.p < alphaPerLook) {
+            c.decision = Decision::Different;
+        }
+        else if (settings.targetWidth > 0 && 2.0 * c.halfWidth <= settings.targetWidth) {
+            c.decision = Decision::Precise;
+        }
+        else if (scheduled[c.a] >= settings.maxReps && scheduled[c.b] >= settings.maxReps) {
+            c.decision = Decision::Exhausted;
+        }
+    }
+}
+
+std::vector<int> SequentialController::scheduleRound()
+{
+    std::vector<bool> needed(groups.size(), false);
+    for (const Comparison& c : comparisons) {
+        if (c.decision == Decision::Undecided) {
+            needed[c.a] = needed[c.b] = true;
+        }
+    }
+    std::vector<int> wanted = scheduled;
+    for (size_t g = 0; g < groups.size(); g++) {
+        if (needed[g] && scheduled[g] < settings.maxReps) {
+            int next = scheduled[g] < settings.minReps ? settings.minReps : scheduled[g] + settings.roundSize;
+            wanted[g] = std::min(next, settings.maxReps);
+        }
+    }
+    scheduled = wanted;
+    return wanted;
+}
+
+bool SequentialController::isFinished() const
+{
+    for (const Comparison& c : comparisons) {
+        if (c.decision == Decision::Undecided) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const char *SequentialController::decisionName(Decision decision)
+{
+    switch (decision) {
+    case Decision::Undecided:
+        return "undecided";
+    case Decision::Different:
+        return "different";
+    case Decision::Precise:
+        return "precise";
+    case Decision::Exhausted:
+        return "exhausted";
+    }
+    return "";
+}
+
+} // namespace lasp_tools
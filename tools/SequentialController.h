@@ -0,0 +1,76 @@
+//
+// Adaptive repetition control for strategy comparisons.
+//
+// Groups (configurations, i.e. iteration variables without the repetition)
+// receive repetitions in rounds. After every round each undecided pairwise
+// comparison of a metric is looked at:
+//
+//   different   Welch p-value below alpha / maxLooks (Bonferroni over all
+//               looks, so repeated testing keeps the overall error below alpha)
+//   precise     the (1 - alpha) confidence interval of the mean difference is
+//               no wider than targetWidth
+//   exhausted   both groups reached maxReps without a decision
+//
+// A group gets more repetitions only while one of its comparisons is still
+// undecided.
+//
+
+#ifndef LASP_SEQUENTIALCONTROLLER_H
+#define LASP_SEQUENTIALCONTROLLER_H
+
+#include <string>
+#include <vector>
+
+namespace lasp_tools {
+
+class SequentialController {
+public:
+    struct Settings {
+        double alpha = 0.05;
+        double targetWidth = 0.0; // 0 disables the width criterion
+        int minReps = 3;
+        int maxReps = 10;
+        int roundSize = 2;
+        std::string baseline;     // glob; compare groups with the matching ones only, "" for all pairs
+    };
+
+    enum class Decision { Undecided, Different, Precise, Exhausted };
+
+    struct Comparison {
+        int a, b;                 // group indices
+        Decision decision = Decision::Undecided;
+        int looks = 0;
+        double difference = 0.0;  // mean(a) - mean(b)
+        double halfWidth = 0.0;
+        double p = 1.0;
+    };
+
+    SequentialController(const Settings& settings, const std::vector<std::string>& groups);
+
+    void addObservation(int group, double value);
+    // Evaluates the undecided comparisons after a round
+    void update();
+
+    // Hands out the next round: total repetitions per group, unchanged for
+    // groups that need no more
+    std::vector<int> scheduleRound();
+    bool isFinished() const;
+
+    int getMaxLooks() const { return maxLooks; }
+    const std::vector<std::string>& getGroups() const { return groups; }
+    const std::vector<double>& getObservations(int group) const { return observations[group]; }
+    const std::vector<Comparison>& getComparisons() const { return comparisons; }
+    static const char *decisionName(Decision decision);
+
+private:
+    Settings settings;
+    int maxLooks;
+    std::vector<std::string> groups;
+    std::vector<std::vector<double>> observations;
+    std::vector<int> scheduled; // repetitions handed out per group
+    std::vector<Comparison> comparisons;
+};
+
+} // namespace lasp_tools
+
+#endif
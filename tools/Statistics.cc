@@ -0,0 +1,257 @@
+#include "Statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+
+namespace lasp_tools {
+
+Summary summarize(const std::vector<double>& values)
+{
+    // Welford's update keeps the variance accurate for large means
+    Summary s;
+    double m2 = 0.0;
+    for (double v : values) {
+        if (std::isnan(v)) {
+            continue;
+        }
+        if (s.n == 0) {
+            s.min = s.max = v;
+        }
+        s.n++;
+        double delta = v - s.mean;
+        s.mean += delta / s.n;
+        m2 += delta * (v - s.mean);
+        s.min = std::fmin(s.min, v);
+        s.max = std::fmax(s.max, v);
+    }
+    s.stddev = s.n > 1 ? std::sqrt(m2 / (s.n - 1)) : 0.0;
+    return s;
+}
+
+double percentileSorted(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty()) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    if (p <= 0.0) {
+        return sorted.front();
+    }
+    double rank = p / 100.0 * (sorted.size() - 1);
+    size_t lower = (size_t)std::floor(rank);
+    if (lower + 1 >= sorted.size()) {
+        return sorted.back();
+    }
+    return sorted[lower] + (rank - lower) * (sorted[lower + 1] - sorted[lower]);
+}
+
+namespace {
+
+// Continued fraction for the incomplete beta function (modified Lentz)
+double betaContinuedFraction(double a, double b, double x)
+{
+    const double tiny = 1e-300;
+    double c = 1.0;
+    double d = 1.0 - (a + b) * x / (a + 1.0);
+    d = 1.0 / (std::fabs(d) < tiny ? tiny : d);
+    double h = d;
+    for (int m = 1; m <= 300; m++) {
+        double m2 = 2.0 * m;
+        double aa = m * (b - m) * x / ((a + m2 - 1.0) * (a + m2));
+        d = 1.0 + aa * d;
+        d = 1.0 / (std::fabs(d) < tiny ? tiny : d);
+        c = 1.0 + aa / c;
+        c = std::fabs(c) < tiny ? tiny : c;
+        h *= d * c;
+        aa = -(a + m) * (a + b + m) * x / ((a + m2) * (a + m2 + 1.0));
+        d = 1.0 + aa * d;
+        d = 1.0 / (std::fabs(d) < tiny ? tiny : d);
+        c = 1.0 + aa / c;
+        c = std::fabs(c) < tiny ? tiny : c;
+        double delta = d * c;
+        h *= delta;
+        if (std::fabs(delta - 1.0) < 1e-14) {
+            break;
+        }
+    }
+    return h;
+}
+
+} // namespace
+
+double incompleteBeta(double a, double b, double x)
+{
+    if (x <= 0.0) {
+        return 0.0;
+    }
+    if (x >= 1.0) {
+        return 1.0;
+    }
+    double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) + a * std::log(x) + b * std::log(1.0 - x));
+    if (x < (a + 1.0) / (a + b + 2.0)) {
+        return front * betaContinuedFraction(a, b, x) / a;
+    }
+    return 1.0 - front * betaContinuedFraction(b, a, 1.0 - x) / b;
+}
+
+double studentTCdf(double t, double df)
+{
+    // Near t = 0, df / (df + t^2) rounds to 1; use the complement there
+    double t2 = t * t;
+    double tail = t2 < df ? 0.5 - 0.5 * incompleteBeta(0.5, df / 2.0, t2 / (df + t2))
+                          : 0.5 * incompleteBeta(df / 2.0, 0.5, df / (df + t2));
+    return t >= 0 ? 1.0 - tail : tail;
+}
+
+double studentTQuantile(double p, double df)
+{
+    if (p <= 0.0) {
+        return -std::numeric_limits<double>::infinity();
+    }
+    if (p >= 1.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    // The CDF is monotonic; bisection on a bracket that covers df >= 1
+    double lo = -1e4, hi = 1e4;
+    for (int i = 0; i < 200 && hi - lo > 1e-12 * (1.0 + std::fabs(lo)); i++) {
+        double mid = 0.5 * (lo + hi);
+        if (studentTCdf(mid, df) < p) {
+            lo = mid;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return 0.5 * (lo + hi);
+}
+
+double confidenceHalfWidth(const Summary& summary, double level)
+{
+    if (summary.n < 2) {
+        return 0.0;
+    }
+    double df = summary.n - 1.0;
+    return studentTQuantile(0.5 + level / 2.0, df) * summary.stddev / std::sqrt((double)summary.n);
+}
+
+double normalCdf(double z)
+{
+    return 0.5 * std::erfc(-z / std::sqrt(2.0));
+}
+
+TestResult welchTTest(const std::vector<double>& a, const std::vector<double>& b)
+{
+    TestResult result;
+    Summary sa = summarize(a), sb = summarize(b);
+    if (sa.n < 2 || sb.n < 2) {
+        return result;
+    }
+    double va = sa.stddev * sa.stddev / sa.n, vb = sb.stddev * sb.stddev / sb.n;
+    double diff = sa.mean - sb.mean;
+    if (va + vb == 0.0) {
+        // Both samples constant: the difference is exact
+        result.statistic = diff == 0.0 ? 0.0 : std::copysign(std::numeric_limits<double>::infinity(), diff);
+        result.df = sa.n + sb.n - 2.0;
+        result.p = diff == 0.0 ? 1.0 : 0.0;
+        return result;
+    }
+    result.statistic = diff / std::sqrt(va + vb);
+    result.df = (va + vb) * (va + vb) / (va * va / (sa.n - 1) + vb * vb / (sb.n - 1));
+    result.p = 2.0 * (1.0 - studentTCdf(std::fabs(result.statistic), result.df));
+    return result;
+}
+
+TestResult mannWhitneyU(const std::vector<double>& a, const std::vector<double>& b)
+{
+    TestResult result;
+    std::vector<std::pair<double, int>> all; // value, sample (0 = a)
+    for (double v : a) {
+        if (!std::isnan(v)) {
+            all.emplace_back(v, 0);
+        }
+    }
+    size_t na = all.size();
+    for (double v : b) {
+        if (!std::isnan(v)) {
+            all.emplace_back(v, 1);
+        }
+    }
+    size_t nb = all.size() - na;
+    if (na == 0 || nb == 0) {
+        return result;
+    }
+    std::sort(all.begin(), all.end());
+
+    // Average ranks over ties
+    double rankSumA = 0.0, tieTerm = 0.0;
+    for (size_t i = 0; i < all.size();) {
+        size_t j = i;
+        while (j < all.size() && all[j].first == all[i].first) {
+            j++;
+        }
+        double rank = (i + 1 + j) / 2.0;
+        for (size_t k = i; k < j; k++) {
+            if (all[k].second == 0) {
+                rankSumA += rank;
+            }
+        }
+        double t = (double)(j - i);
+        tieTerm += t * t * t - t;
+        i = j;
+    }
+
+    double n = (double)(na + nb);
+    result.statistic = rankSumA - na * (na + 1) / 2.0;
+    double mean = na * nb / 2.0;
+    double variance = na * nb / 12.0 * ((n + 1) - tieTerm / (n * (n - 1)));
+    if (variance <= 0.0) {
+        return result;
+    }
+    double deviation = std::fabs(result.statistic - mean);
+    double z = std::max(0.0, deviation - 0.5) / std::sqrt(variance);
+    result.p = std::min(1.0, 2.0 * (1.0 - normalCdf(z)));
+    return result;
+}
+
+Interval bootstrapMeanDifference(const std::vector<double>& a, const std::vector<double>& b, double level, int resamples, uint64_t seed)
+{
+    Interval interval;
+    if (a.empty() || b.empty() || resamples < 1) {
+        return interval;
+    }
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<size_t> pickA(0, a.size() - 1), pickB(0, b.size() - 1);
+    std::vector<double> differences(resamples);
+    for (double& difference : differences) {
+        double sumA = 0.0, sumB = 0.0;
+        for (size_t i = 0; i < a.size(); i++) {
+            sumA += a[pickA(rng)];
+        }
+        for (size_t i = 0; i < b.size(); i++) {
+            sumB += b[pickB(rng)];
+        }
+        difference = sumA / a.size() - sumB / b.size();
+    }
+    std::sort(differences.begin(), differences.end());
+    interval.low = percentileSorted(differences, 50.0 * (1.0 - level));
+    interval.high = percentileSorted(differences, 100.0 - 50.0 * (1.0 - level));
+    return interval;
+}
+
+std::vector<double> holmAdjust(const std::vector<double>& p)
+{
+    std::vector<size_t> order(p.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t x, size_t y) { return p[x] < p[y]; });
+    std::vector<double> adjusted(p.size());
+    double running = 0.0;
+    for (size_t k = 0; k < order.size(); k++) {
+        running = std::max(running, std::min(1.0, (p.size() - k) * p[order[k]]));
+        adjusted[order[k]] = running;
+    }
+    return adjusted;
+}
+
+} // namespace lasp_tools
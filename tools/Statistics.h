@@ -0,0 +1,64 @@
+//
+// Descriptive statistics, Student t distribution and two-sample tests for the
+// result tools.
+//
+
+#ifndef LASP_STATISTICS_H
+#define LASP_STATISTICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lasp_tools {
+
+struct Summary {
+    size_t n = 0;
+    double mean = 0.0;
+    double stddev = 0.0; // sample standard deviation (n - 1)
+    double min = 0.0;
+    double max = 0.0;
+};
+
+// NaN values are ignored
+Summary summarize(const std::vector<double>& values);
+
+// Linear interpolation between closest ranks; sorted must be ascending, NaN if it is empty
+double percentileSorted(const std::vector<double>& sorted, double p);
+
+// Regularized incomplete beta function I_x(a, b)
+double incompleteBeta(double a, double b, double x);
+double studentTCdf(double t, double df);
+double studentTQuantile(double p, double df);
+
+// Half width of the two-sided confidence interval of the mean, 0 for n < 2
+double confidenceHalfWidth(const Summary& summary, double level);
+
+double normalCdf(double z);
+
+struct TestResult {
+    double statistic = 0.0; // t for Welch, U of the first sample for Mann-Whitney
+    double df = 0.0;        // Welch-Satterthwaite degrees of freedom, 0 for Mann-Whitney
+    double p = 1.0;         // two-sided
+};
+
+// Welch's unequal-variance t-test of mean(a) - mean(b); needs two values per sample
+TestResult welchTTest(const std::vector<double>& a, const std::vector<double>& b);
+
+// Mann-Whitney U test, normal approximation with tie and continuity correction
+TestResult mannWhitneyU(const std::vector<double>& a, const std::vector<double>& b);
+
+struct Interval {
+    double low = 0.0;
+    double high = 0.0;
+};
+
+// Percentile bootstrap interval of mean(a) - mean(b), deterministic for a seed
+Interval bootstrapMeanDifference(const std::vector<double>& a, const std::vector<double>& b, double level, int resamples, uint64_t seed);
+
+// Holm-Bonferroni adjusted p-values, same order as p
+std::vector<double> holmAdjust(const std::vector<double>& p);
+
+} // namespace lasp_tools
+
+#endif
@@ -0,0 +1,402 @@
+//
+// Scaling benchmark for the LASP VEN simulation.
+//
+// Usage: lasp_bench [options]
+//
+// For every combination of vehicle and edge server count a scenario is
+// generated with ScenarioWriter and run once in Cmdenv. One CSV row per run is
+// appended to the output file, so results of different versions (see --label)
+// accumulate in one place and can be compared over time:
+//
+//   label,vehicles,edge_servers,status,exit_code,wall_time_s,events,
+//   events_per_s,peak_rss_kb,manager_s,find_best_placement_s,edge_servers_s,
+//   vehicles_s
+//
+// wall_time_s and peak_rss_kb cover the simulation process only (SUMO runs in
+// veins_launchd, which must already be listening on --launchd-port). The
+// per-module columns are the summed wall-clock time of the LASP hot paths,
+// taken from the wallTime:* scalars that enableProfiling makes the modules
+// record; find_best_placement_s is part of manager_s.
+//
+
+#include "ScenarioWriter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#else
+#include <direct.h>
+#define getcwd _getcwd
+#define popen _popen
+#define pclose _pclose
+#endif
+
+using namespace lasp_tools;
+
+namespace {
+
+struct Options {
+    std::vector<int> vehicles = {10, 100, 1000, 10000};
+    std::vector<int> servers = {4, 16, 100, 1000};
+    double simTime = 200.0;
+    unsigned seed = 1;
+    std::string simulation = "src/lasp-ven";
+    std::string nedPath = "src:simulations";
+    std::string baseIni = "simulations/lasp_ven_simple_example/lasp_ven_simple.ini";
+    std::string workDir = "bench_runs";
+    std::string output = "bench_results.csv";
+    std::string label;
+    int launchdPort = 9999;
+    double timeout = 3600.0;
+};
+
+struct RunResult {
+    std::string status = "ok";
+    int exitCode = 0;
+    double wallTime = 0.0;
+    long long events = 0;
+    long peakRssKb = 0;
+    double managerTime = 0.0;
+    double findBestPlacementTime = 0.0;
+    double edgeServerTime = 0.0;
+    double vehicleTime = 0.0;
+};
+
+std::vector<int> parseList(const char *text)
+{
+    std::vector<int> values;
+    std::stringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        values.push_back(std::stoi(item));
+    }
+    return values;
+}
+
+std::string absolutePath(const std::string& path)
+{
+    if (path.empty() || path[0] == '/' || (path.size() > 1 && path[1] == ':')) {
+        return path;
+    }
+    char cwd[4096];
+    if (!getcwd(cwd, sizeof(cwd))) {
+        throw std::runtime_error("Cannot determine working directory");
+    }
+    return std::string(cwd) + "/" + path;
+}
+
+std::string absolutePathList(const std::string& paths)
+{
+    std::string result;
+    std::stringstream in(paths);
+    std::string item;
+    while (std::getline(in, item, ':')) {
+        result += (result.empty() ? "" : ":") + absolutePath(item);
+    }
+    return result;
+}
+
+std::string defaultLabel()
+{
+    std::string label = "unknown";
+    FILE *p = popen("git describe --always --dirty 2>/dev/null", "r");
+    if (p) {
+        char line[256];
+        if (fgets(line, sizeof(line), p)) {
+            label = line;
+            label.erase(label.find_last_not_of("\r\n") + 1);
+        }
+        pclose(p);
+    }
+    return label;
+}
+
+// Number of events from the last Cmdenv progress line ("** Event #N ...")
+long long parseEventCount(const std::string& logFile)
+{
+    std::ifstream in(logFile);
+    std::string line;
+    long long events = 0;
+    while (std::getline(in, line)) {
+        size_t pos = line.find("Event #");
+        if (pos != std::string::npos) {
+            events = std::atoll(line.c_str() + pos + 7);
+        }
+    }
+    return events;
+}
+
+// Sums count * mean of the wallTime:<function> scalars per module class
+void parseProfilingScalars(const std::string& scaFile, RunResult& result)
+{
+    std::ifstream in(scaFile);
+    std::string line;
+    std::string lastKey;
+    double lastCount = 0.0;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string kind, module, name;
+        double value;
+        if (!(fields >> kind >> module >> name >> value) || kind != "scalar" || name.compare(0, 9, "wallTime:") != 0) {
+            continue;
+        }
+        size_t suffix = name.rfind(':');
+        std::string key = module + " " + name.substr(0, suffix);
+        std::string field = name.substr(suffix + 1);
+        if (field == "count") {
+            lastKey = key;
+            lastCount = value;
+            continue;
+        }
+        if (field != "mean" || key != lastKey) {
+            continue;
+        }
+
+        double total = lastCount * value;
+        std::string function = name.substr(9, suffix - 9);
+        if (module.find(".laspManager.") != std::string::npos) {
+            if (function == "findBestPlacement") {
+                result.findBestPlacementTime += total; // nested in processServiceRequest
+            }
+            else {
+                result.managerTime += total;
+            }
+        }
+        else if (module.find(".edgeServer[") != std::string::npos) {
+            result.edgeServerTime += total;
+        }
+        else if (module.find(".vehicle[") != std::string::npos) {
+            result.vehicleTime += total;
+        }
+    }
+}
+
+#ifndef _WIN32
+void runSimulation(const Options& options, const std::string& directory, RunResult& result)
+{
+    std::vector<std::string> args = {
+        absolutePath(options.simulation), "-u", "Cmdenv", "-n", absolutePathList(options.nedPath),
+        "-f", "scenario.ini", "-c", "Scenario", "-r", "0", "--result-dir=results",
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid < 0) {
+        throw std::runtime_error("fork failed");
+    }
+    if (pid == 0) {
+        if (chdir(directory.c_str()) != 0) {
+            _exit(127);
+        }
+        int log = open("stdout.log", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (log >= 0) {
+            dup2(log, 1);
+            dup2(log, 2);
+            close(log);
+        }
+        std::vector<char *> argv;
+        for (const std::string& arg : args) {
+            argv.push_back(const_cast<char *>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+
+    int status = 0;
+    struct rusage usage;
+    memset(&usage, 0, sizeof(usage));
+    while (true) {
+        pid_t done = wait4(pid, &status, WNOHANG, &usage);
+        if (done == pid) {
+            break;
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (elapsed > options.timeout) {
+            kill(pid, SIGKILL);
+            wait4(pid, &status, 0, &usage);
+            result.status = "timeout";
+            break;
+        }
+        usleep(20000);
+    }
+
+    result.wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.peakRssKb = usage.ru_maxrss; // kilobytes on Linux
+    if (result.status == "ok") {
+        result.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+        if (result.exitCode != 0) {
+            result.status = "failed";
+        }
+    }
+}
+#else
+void runSimulation(const Options& options, const std::string& directory, RunResult& result)
+{
+    // No rusage or timeout on Windows; peak RSS stays 0
+    std::string command = "cd /d \"" + directory + "\" && \"" + absolutePath(options.simulation) + "\" -u Cmdenv -n \"" +
+                          absolutePathList(options.nedPath) + "\" -f scenario.ini -c Scenario -r 0 --result-dir=results > stdout.log 2>&1";
+    auto start = std::chrono::steady_clock::now();
+    result.exitCode = std::system(command.c_str());
+    result.wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (result.exitCode != 0) {
+        result.status = "failed";
+    }
+}
+#endif
+
+RunResult runPoint(const Options& options, int numVehicles, int numServers)
+{
+    RunResult result;
+
+    // Keep the traffic density roughly constant: about four vehicles per junction
+    ScenarioSpec spec;
+    spec.gridColumns = spec.gridRows = std::max(3, (int)std::ceil(std::sqrt(numVehicles / 4.0)));
+    spec.numVehicles = numVehicles;
+    spec.numEdgeServers = numServers;
+    spec.simTime = options.simTime;
+    spec.departEnd = options.simTime / 2;
+    spec.seed = options.seed;
+    spec.extraIniEntries = {
+        "cmdenv-express-mode = true",
+        "cmdenv-status-frequency = 1s",
+        "**.vector-recording = false",
+        "output-scalar-file = \"${resultdir}/bench.sca\"",
+        "*.veinsManager.port = " + std::to_string(options.launchdPort),
+        "**.enableProfiling = true",
+    };
+
+    std::string directory = options.workDir + "/v" + std::to_string(numVehicles) + "_s" + std::to_string(numServers);
+    try {
+        ScenarioWriter(spec).write(directory, absolutePath(options.baseIni));
+    }
+    catch (const std::exception& e) {
+        fprintf(stderr, "  %s\n", e.what());
+        result.status = "unsupported";
+        return result;
+    }
+
+    runSimulation(options, directory, result);
+    result.events = parseEventCount(directory + "/stdout.log");
+    parseProfilingScalars(directory + "/results/bench.sca", result);
+    return result;
+}
+
+void usage()
+{
+    fprintf(stderr, "usage: lasp_bench [options]\n");
+    fprintf(stderr, "  --vehicles N,N,...   vehicle counts (default 10,100,1000,10000)\n");
+    fprintf(stderr, "  --servers N,N,...    edge server counts (default 4,16,100,1000)\n");
+    fprintf(stderr, "  --sim-time S         simulated seconds per run (default 200)\n");
+    fprintf(stderr, "  --seed N             scenario seed (default 1)\n");
+    fprintf(stderr, "  --sim PATH           simulation binary (default src/lasp-ven)\n");
+    fprintf(stderr, "  --ned-path PATHS     NED path (default src:simulations)\n");
+    fprintf(stderr, "  --base-ini PATH      ini included by every scenario\n");
+    fprintf(stderr, "  --work DIR           scenario and result directory (default bench_runs)\n");
+    fprintf(stderr, "  --out FILE           CSV file results are appended to (default bench_results.csv)\n");
+    fprintf(stderr, "  --label TEXT         version label (default: git describe --always --dirty)\n");
+    fprintf(stderr, "  --launchd-port N     veins_launchd port (default 9999)\n");
+    fprintf(stderr, "  --timeout S          wall-clock limit per run (default 3600)\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        const char *value = argv[++i];
+        if (arg == "--vehicles") {
+            options.vehicles = parseList(value);
+        }
+        else if (arg == "--servers") {
+            options.servers = parseList(value);
+        }
+        else if (arg == "--sim-time") {
+            options.simTime = std::atof(value);
+        }
+        else if (arg == "--seed") {
+            options.seed = (unsigned)std::atol(value);
+        }
+        else if (arg == "--sim") {
+            options.simulation = value;
+        }
+        else if (arg == "--ned-path") {
+            options.nedPath = value;
+        }
+        else if (arg == "--base-ini") {
+            options.baseIni = value;
+        }
+        else if (arg == "--work") {
+            options.workDir = value;
+        }
+        else if (arg == "--out") {
+            options.output = value;
+        }
+        else if (arg == "--label") {
+            options.label = value;
+        }
+        else if (arg == "--launchd-port") {
+            options.launchdPort = std::atoi(value);
+        }
+        else if (arg == "--timeout") {
+            options.timeout = std::atof(value);
+        }
+        else {
+            usage();
+            return 1;
+        }
+    }
+    if (options.label.empty()) {
+        options.label = defaultLabel();
+    }
+
+    bool newFile = !std::ifstream(options.output).good();
+    FILE *out = fopen(options.output.c_str(), "a");
+    if (!out) {
+        fprintf(stderr, "cannot write %s\n", options.output.c_str());
+        return 1;
+    }
+    if (newFile) {
+        fprintf(out, "label,vehicles,edge_servers,status,exit_code,wall_time_s,events,events_per_s,peak_rss_kb,"
+                     "manager_s,find_best_placement_s,edge_servers_s,vehicles_s\n");
+    }
+
+    int failures = 0;
+    for (int numServers : options.servers) {
+        for (int numVehicles : options.vehicles) {
+            fprintf(stderr, "%d vehicles, %d edge servers\n", numVehicles, numServers);
+            RunResult r = runPoint(options, numVehicles, numServers);
+            double eventsPerSecond = r.wallTime > 0 ? r.events / r.wallTime : 0.0;
+            fprintf(out, "%s,%d,%d,%s,%d,%.3f,%lld,%.0f,%ld,%.6f,%.6f,%.6f,%.6f\n",
+                    options.label.c_str(), numVehicles, numServers, r.status.c_str(), r.exitCode, r.wallTime, r.events,
+                    eventsPerSecond, r.peakRssKb, r.managerTime, r.findBestPlacementTime, r.edgeServerTime, r.vehicleTime);
+            fflush(out);
+            fprintf(stderr, "  %s in %.1fs, %lld events\n", r.status.c_str(), r.wallTime, r.events);
+            if (r.status != "ok") {
+                failures++;
+            }
+        }
+    }
+    fclose(out);
+    return failures > 0 ? 2 : 0;
+}
@@ -0,0 +1,631 @@
+//
+// Result store converter and aggregator for LASP VEN simulation output.
+//
+// Usage:
+//   lasp_results import -o STORE PATH...   convert .sca/.vec files (directories
+//                                          are searched recursively)
+//   lasp_results runs STORE...             list runs and their attributes
+//   lasp_results scalars STORE... [opts]   aggregate scalars across runs
+//   lasp_results vectors STORE... [opts]   aggregate vector samples across runs
+//   lasp_results compare STORE... [opts]   test configurations against each other
+//
+// Aggregation groups runs by --group attributes (default experiment and
+// measurement, i.e. configuration plus iteration variables without the
+// repetition) and prints per group and result name: number of runs, mean,
+// standard deviation and the t confidence interval of the per-run values,
+// min, max and percentiles. A run's value is the mean of the matching modules
+// (--combine sum to add them, --by-module to keep modules apart). For vectors
+// the per-run value is the mean of the samples in [--from, --to]; percentiles
+// are taken over all samples of the group, e.g. the pooled latency
+// distribution.
+//
+// compare takes the per-run values of each metric (default the manager's
+// requestSuccessRate, averageLatency and loadBalancingEfficiency means and the
+// vehicles' serviceLatency mean) and tests every pair of groups, or every
+// group against --baseline: Welch t-test, Mann-Whitney U and a bootstrap
+// interval of the mean difference. Welch p-values are Holm-adjusted per
+// metric; a difference is reported when the adjusted p is below --alpha.
+// Comparisons run on all cores and are deterministic for a given --seed.
+//
+
+#include "ResultStore.h"
+#include "Statistics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+using namespace lasp_tools;
+
+namespace {
+
+struct Options {
+    std::string output;
+    std::vector<std::string> inputs;
+    std::string modulePattern = "*";
+    std::vector<std::string> namePatterns = {"*"};
+    std::vector<std::string> group = {"experiment", "measurement"};
+    std::vector<double> percentiles = {50, 95, 99};
+    double confidence = 0.95;
+    double fromTime = 0.0;
+    double toTime = std::numeric_limits<double>::infinity();
+    bool byModule = false;
+    bool sum = false;
+    bool csv = false;
+
+    // compare
+    std::string baseline;
+    double alpha = 0.05;
+    int resamples = 2000;
+    unsigned threads = 0;
+    uint64_t seed = 1;
+};
+
+// Accumulates one aggregation row
+struct Row {
+    std::map<uint64_t, std::pair<double, double>> perRun; // run -> (sum, count)
+    std::vector<double> samples;                           // pooled vector samples
+};
+
+using RowKey = std::vector<std::string>; // group values, module, name
+
+std::vector<std::string> split(const std::string& text, char separator)
+{
+    std::vector<std::string> items;
+    std::stringstream in(text);
+    std::string item;
+    while (std::getline(in, item, separator)) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+bool endsWith(const std::string& text, const std::string& suffix)
+{
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Result files below path in name order, or path itself
+void collectResultFiles(const std::string& path, std::vector<std::string>& files)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        throw std::runtime_error("Cannot find " + path);
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        files.push_back(path);
+        return;
+    }
+    DIR* d = opendir(path.c_str());
+    if (!d) {
+        return;
+    }
+    std::vector<std::string> entries;
+    while (struct dirent* entry = readdir(d)) {
+        std::string name = entry->d_name;
+        if (name != "." && name != "..") {
+            entries.push_back(name);
+        }
+    }
+    closedir(d);
+    std::sort(entries.begin(), entries.end());
+    for (const std::string& name : entries) {
+        std::string child = path + "/" + name;
+        if (stat(child.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+            collectResultFiles(child, files);
+        }
+        else if (endsWith(name, ".sca") || endsWith(name, ".vec")) {
+            files.push_back(child);
+        }
+    }
+}
+
+int importFiles(const Options& options)
+{
+    if (options.output.empty() || options.inputs.empty()) {
+        fprintf(stderr, "import needs -o STORE and at least one result file or directory\n");
+        return 1;
+    }
+    try {
+        std::vector<std::string> files;
+        for (const std::string& input : options.inputs) {
+            collectResultFiles(input, files);
+        }
+        ResultStoreWriter writer;
+        writer.open(options.output);
+        ResultImporter importer(writer);
+        for (const std::string& file : files) {
+            importer.importFile(file);
+        }
+        writer.close();
+        fprintf(stderr, "%zu result files imported into %s\n", files.size(), options.output.c_str());
+    }
+    catch (const std::exception& e) {
+        fprintf(stderr, "%s\n", e.what());
+        remove(options.output.c_str());
+        return 1;
+    }
+    return 0;
+}
+
+std::string formatNumber(double v)
+{
+    char text[32];
+    snprintf(text, sizeof(text), "%.6g", v);
+    return text;
+}
+
+void printTable(const std::vector<std::string>& header, const std::vector<std::vector<std::string>>& rows, bool csv)
+{
+    if (csv) {
+        auto printCsvRow = [](const std::vector<std::string>& row) {
+            for (size_t i = 0; i < row.size(); i++) {
+                std::string cell = row[i];
+                if (cell.find_first_of(",\"") != std::string::npos) {
+                    std::string quoted = "\"";
+                    for (char c : cell) {
+                        quoted += c == '"' ? "\"\"" : std::string(1, c);
+                    }
+                    cell = quoted + "\"";
+                }
+                printf("%s%s", i ? "," : "", cell.c_str());
+            }
+            printf("\n");
+        };
+        printCsvRow(header);
+        for (const auto& row : rows) {
+            printCsvRow(row);
+        }
+        return;
+    }
+    std::vector<size_t> widths(header.size());
+    for (size_t i = 0; i < header.size(); i++) {
+        widths[i] = header[i].size();
+        for (const auto& row : rows) {
+            widths[i] = std::max(widths[i], row[i].size());
+        }
+    }
+    auto printRow = [&](const std::vector<std::string>& row) {
+        for (size_t i = 0; i < row.size(); i++) {
+            printf("%s%-*s", i ? "  " : "", (int)widths[i], row[i].c_str());
+        }
+        printf("\n");
+    };
+    printRow(header);
+    for (const auto& row : rows) {
+        printRow(row);
+    }
+}
+
+std::vector<std::unique_ptr<ResultStoreReader>> openStores(const Options& options)
+{
+    std::vector<std::unique_ptr<ResultStoreReader>> stores;
+    for (const std::string& input : options.inputs) {
+        stores.emplace_back(new ResultStoreReader());
+        stores.back()->open(input);
+    }
+    return stores;
+}
+
+int listRuns(const Options& options)
+{
+    auto stores = openStores(options);
+    std::vector<std::string> header = {"run", "configname", "runnumber", "measurement", "repetition"};
+    std::vector<std::vector<std::string>> rows;
+    for (const auto& store : stores) {
+        for (const ResultRun& run : store->getRuns()) {
+            rows.push_back({run.runId, run.get("configname"), run.get("runnumber"), run.get("measurement"), run.get("repetition")});
+        }
+    }
+    printTable(header, rows, options.csv);
+    return 0;
+}
+
+bool matchesAny(const std::vector<std::string>& patterns, const std::string& text)
+{
+    for (const std::string& pattern : patterns) {
+        if (globMatch(pattern.c_str(), text.c_str())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+RowKey groupKey(const Options& options, const ResultRun& run)
+{
+    RowKey key;
+    for (const std::string& attribute : options.group) {
+        key.push_back(run.get(attribute));
+    }
+    return key;
+}
+
+void addValue(Row& row, uint64_t run, double value)
+{
+    if (std::isnan(value)) {
+        return;
+    }
+    auto& acc = row.perRun[run];
+    acc.first += value;
+    acc.second += 1.0;
+}
+
+std::vector<double> perRunValues(const Options& options, const Row& row)
+{
+    std::vector<double> values;
+    for (const auto& run : row.perRun) {
+        values.push_back(options.sum ? run.second.first : run.second.first / run.second.second);
+    }
+    return values;
+}
+
+void printAggregation(const Options& options, std::map<RowKey, Row>& rows, bool pooled)
+{
+    std::vector<std::string> header = options.group;
+    if (options.byModule) {
+        header.push_back("module");
+    }
+    header.insert(header.end(), {"name", "runs", "mean", "stddev", "ci_low", "ci_high", "min", "max"});
+    if (pooled) {
+        header.push_back("samples");
+    }
+    for (double p : options.percentiles) {
+        header.push_back("p" + formatNumber(p));
+    }
+
+    std::vector<std::vector<std::string>> table;
+    for (auto& entry : rows) {
+        Row& row = entry.second;
+        std::vector<double> values = perRunValues(options, row);
+        Summary s = summarize(values);
+        if (s.n == 0) {
+            continue;
+        }
+        double half = confidenceHalfWidth(s, options.confidence);
+
+        std::vector<std::string> cells = entry.first;
+        if (!options.byModule) {
+            cells.erase(cells.end() - 2); // module column is empty
+        }
+        cells.insert(cells.end(), {std::to_string(s.n), formatNumber(s.mean), formatNumber(s.stddev), formatNumber(s.mean - half),
+                                   formatNumber(s.mean + half), formatNumber(s.min), formatNumber(s.max)});
+        std::vector<double>& distribution = pooled ? row.samples : values;
+        distribution.erase(std::remove_if(distribution.begin(), distribution.end(), [](double v) { return std::isnan(v); }), distribution.end());
+        std::sort(distribution.begin(), distribution.end());
+        if (pooled) {
+            cells.push_back(std::to_string(distribution.size()));
+        }
+        for (double p : options.percentiles) {
+            cells.push_back(distribution.empty() ? "" : formatNumber(percentileSorted(distribution, p)));
+        }
+        table.push_back(cells);
+    }
+    printTable(header, table, options.csv);
+}
+
+// Per-run scalar values keyed by group, module ("" unless --by-module) and name
+std::map<RowKey, Row> collectScalars(const Options& options, const std::vector<std::unique_ptr<ResultStoreReader>>& stores)
+{
+    std::map<RowKey, Row> rows;
+    for (size_t s = 0; s < stores.size(); s++) {
+        const ResultStoreReader& store = *stores[s];
+        std::vector<RowKey> runKeys;
+        for (const ResultRun& run : store.getRuns()) {
+            runKeys.push_back(groupKey(options, run));
+        }
+
+        // Patterns are matched once per distinct string, not once per scalar
+        std::map<uint32_t, bool> moduleMatches, nameMatches;
+        auto matches = [&](std::map<uint32_t, bool>& cache, uint32_t id, const std::vector<std::string>& patterns) {
+            auto it = cache.find(id);
+            if (it == cache.end()) {
+                it = cache.emplace(id, matchesAny(patterns, store.getString(id))).first;
+            }
+            return it->second;
+        };
+
+        const ResultScalars& scalars = store.getScalars();
+        for (size_t i = 0; i < scalars.value.size(); i++) {
+            if (!matches(nameMatches, scalars.name[i], options.namePatterns) || !matches(moduleMatches, scalars.module[i], {options.modulePattern})) {
+                continue;
+            }
+            RowKey key = runKeys[scalars.run[i]];
+            key.push_back(options.byModule ? store.getString(scalars.module[i]) : "");
+            key.push_back(store.getString(scalars.name[i]));
+            addValue(rows[key], ((uint64_t)s << 32) | scalars.run[i], scalars.value[i]);
+        }
+    }
+    return rows;
+}
+
+int aggregateScalars(const Options& options)
+{
+    auto stores = openStores(options);
+    std::map<RowKey, Row> rows = collectScalars(options, stores);
+    printAggregation(options, rows, false);
+    return 0;
+}
+
+int aggregateVectors(const Options& options)
+{
+    auto stores = openStores(options);
+    std::map<RowKey, Row> rows;
+    std::vector<ResultSample> samples;
+    for (size_t s = 0; s < stores.size(); s++) {
+        const ResultStoreReader& store = *stores[s];
+        const std::vector<ResultVector>& vectors = store.getVectors();
+        for (uint32_t v = 0; v < vectors.size(); v++) {
+            const ResultVector& vector = vectors[v];
+            if (!matchesAny(options.namePatterns, vector.name) || !globMatch(options.modulePattern.c_str(), vector.module.c_str())) {
+                continue;
+            }
+            RowKey key = groupKey(options, store.getRuns()[vector.run]);
+            key.push_back(options.byModule ? vector.module : "");
+            key.push_back(vector.name);
+            Row& row = rows[key];
+
+            samples.clear();
+            store.readVector(v, options.fromTime, options.toTime, samples);
+            uint64_t run = ((uint64_t)s << 32) | vector.run;
+            for (const ResultSample& sample : samples) {
+                addValue(row, run, sample.value);
+                row.samples.push_back(sample.value);
+            }
+        }
+    }
+    // Per-run value of a vector is the mean of its samples
+    Options perRunMean = options;
+    perRunMean.sum = false;
+    printAggregation(perRunMean, rows, true);
+    return 0;
+}
+
+struct Comparison {
+    std::string metric;
+    std::string a, b;
+    const std::vector<double>* valuesA;
+    const std::vector<double>* valuesB;
+    TestResult welch;
+    TestResult mannWhitney;
+    Interval bootstrap;
+    double holmP = 1.0;
+};
+
+std::string joinLabel(const RowKey& key, size_t count)
+{
+    std::string label;
+    for (size_t i = 0; i < count; i++) {
+        label += (i ? " " : "") + key[i];
+    }
+    return label;
+}
+
+int compareConfigs(Options options)
+{
+    if (options.namePatterns == std::vector<std::string>{"*"}) {
+        options.namePatterns = {"requestSuccessRate:mean", "averageLatency:mean", "loadBalancingEfficiency:mean", "serviceLatency:mean"};
+    }
+    options.byModule = false;
+    auto stores = openStores(options);
+    std::map<RowKey, Row> rows = collectScalars(options, stores);
+
+    // metric -> group label -> per-run values
+    std::map<std::string, std::map<std::string, std::vector<double>>> metrics;
+    for (const auto& entry : rows) {
+        std::vector<double> values = perRunValues(options, entry.second);
+        metrics[entry.first.back()][joinLabel(entry.first, options.group.size())] = values;
+    }
+
+    std::vector<Comparison> comparisons;
+    for (const auto& metric : metrics) {
+        std::vector<const std::pair<const std::string, std::vector<double>>*> groups;
+        for (const auto& group : metric.second) {
+            groups.push_back(&group);
+        }
+        for (size_t i = 0; i < groups.size(); i++) {
+            for (size_t j = 0; j < groups.size(); j++) {
+                bool pair = options.baseline.empty() ? i < j : (i != j && globMatch(options.baseline.c_str(), groups[j]->first.c_str()) && !globMatch(options.baseline.c_str(), groups[i]->first.c_str()));
+                if (pair) {
+                    Comparison c;
+                    c.metric = metric.first;
+                    c.a = groups[i]->first;
+                    c.b = groups[j]->first;
+                    c.valuesA = &groups[i]->second;
+                    c.valuesB = &groups[j]->second;
+                    comparisons.push_back(c);
+                }
+            }
+        }
+    }
+
+    // The bootstrap dominates; spread comparisons over all cores
+    unsigned threads = options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < comparisons.size(); i = next++) {
+            Comparison& c = comparisons[i];
+            c.welch = welchTTest(*c.valuesA, *c.valuesB);
+            c.mannWhitney = mannWhitneyU(*c.valuesA, *c.valuesB);
+            c.bootstrap = bootstrapMeanDifference(*c.valuesA, *c.valuesB, options.confidence, options.resamples, options.seed + i);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < std::min<size_t>(threads, comparisons.size()); t++) {
+        pool.emplace_back(worker);
+    }
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+
+    for (size_t first = 0; first < comparisons.size();) {
+        size_t last = first;
+        std::vector<double> p;
+        while (last < comparisons.size() && comparisons[last].metric == comparisons[first].metric) {
+            p.push_back(comparisons[last++].welch.p);
+        }
+        std::vector<double> adjusted = holmAdjust(p);
+        for (size_t i = first; i < last; i++) {
+            comparisons[i].holmP = adjusted[i - first];
+        }
+        first = last;
+    }
+
+    std::vector<std::string> header = {"metric", "a", "b", "n_a", "n_b", "mean_a", "mean_b", "diff", "boot_low", "boot_high",
+                                       "welch_t", "welch_df", "welch_p", "mwu_u", "mwu_p", "holm_p", "result"};
+    std::vector<std::vector<std::string>> table;
+    for (const Comparison& c : comparisons) {
+        Summary sa = summarize(*c.valuesA), sb = summarize(*c.valuesB);
+        std::string result = c.holmP < options.alpha ? (sa.mean < sb.mean ? "a<b" : "a>b") : "";
+        table.push_back({c.metric, c.a, c.b, std::to_string(sa.n), std::to_string(sb.n), formatNumber(sa.mean), formatNumber(sb.mean),
+                         formatNumber(sa.mean - sb.mean), formatNumber(c.bootstrap.low), formatNumber(c.bootstrap.high),
+                         formatNumber(c.welch.statistic), formatNumber(c.welch.df), formatNumber(c.welch.p),
+                         formatNumber(c.mannWhitney.statistic), formatNumber(c.mannWhitney.p), formatNumber(c.holmP), result});
+    }
+    printTable(header, table, options.csv);
+    return 0;
+}
+
+void usage()
+{
+    fprintf(stderr, "usage: lasp_results import -o STORE PATH...\n");
+    fprintf(stderr, "       lasp_results runs STORE...\n");
+    fprintf(stderr, "       lasp_results scalars|vectors|compare STORE... [options]\n");
+    fprintf(stderr, "  --module GLOB        module path pattern (default *)\n");
+    fprintf(stderr, "  --name GLOB,...      result name patterns, e.g. 'averageLatency:*' (default *)\n");
+    fprintf(stderr, "  --group KEYS         run attributes or $itervars to group by (default experiment,measurement)\n");
+    fprintf(stderr, "  --by-module          one row per module instead of combining matching modules\n");
+    fprintf(stderr, "  --combine mean|sum   per-run value of several modules (scalars, default mean)\n");
+    fprintf(stderr, "  --percentiles LIST   percentiles to report (default 50,95,99)\n");
+    fprintf(stderr, "  --confidence L       confidence level of the interval (default 0.95)\n");
+    fprintf(stderr, "  --from T, --to T     vector time window in seconds, e.g. --from 30 to skip the warmup\n");
+    fprintf(stderr, "  --csv                CSV instead of an aligned table\n");
+    fprintf(stderr, "compare:\n");
+    fprintf(stderr, "  --baseline GLOB      compare every group with the groups matching GLOB (default: all pairs)\n");
+    fprintf(stderr, "  --alpha A            significance level after Holm adjustment (default 0.05)\n");
+    fprintf(stderr, "  --bootstrap N        bootstrap resamples (default 2000)\n");
+    fprintf(stderr, "  --threads N          worker threads (default: number of cores)\n");
+    fprintf(stderr, "  --seed N             bootstrap seed (default 1)\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+    std::string command = argv[1];
+    Options options;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--by-module") {
+            options.byModule = true;
+            continue;
+        }
+        if (arg == "--csv") {
+            options.csv = true;
+            continue;
+        }
+        if (arg.compare(0, 1, "-") != 0) {
+            options.inputs.push_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "-o") {
+            options.output = value;
+        }
+        else if (arg == "--module") {
+            options.modulePattern = value;
+        }
+        else if (arg == "--name") {
+            options.namePatterns = split(value, ',');
+        }
+        else if (arg == "--group") {
+            options.group = split(value, ',');
+        }
+        else if (arg == "--combine" && (value == "mean" || value == "sum")) {
+            options.sum = value == "sum";
+        }
+        else if (arg == "--percentiles") {
+            options.percentiles.clear();
+            for (const std::string& p : split(value, ',')) {
+                options.percentiles.push_back(std::atof(p.c_str()));
+            }
+        }
+        else if (arg == "--confidence") {
+            options.confidence = std::atof(value.c_str());
+        }
+        else if (arg == "--from") {
+            options.fromTime = std::atof(value.c_str());
+        }
+        else if (arg == "--to") {
+            options.toTime = std::atof(value.c_str());
+        }
+        else if (arg == "--baseline") {
+            options.baseline = value;
+        }
+        else if (arg == "--alpha") {
+            options.alpha = std::atof(value.c_str());
+        }
+        else if (arg == "--bootstrap") {
+            options.resamples = std::atoi(value.c_str());
+        }
+        else if (arg == "--threads") {
+            options.threads = (unsigned)std::atoi(value.c_str());
+        }
+        else if (arg == "--seed") {
+            options.seed = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    if (command == "import") {
+        return importFiles(options);
+    }
+    if (options.inputs.empty()) {
+        usage();
+        return 1;
+    }
+    try {
+        if (command == "runs") {
+            return listRuns(options);
+        }
+        if (command == "scalars") {
+            return aggregateScalars(options);
+        }
+        if (command == "vectors") {
+            return aggregateVectors(options);
+        }
+        if (command == "compare") {
+            return compareConfigs(options);
+        }
+    }
+    catch (const std::exception& e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    usage();
+    return 1;
+}
@@ -0,0 +1,141 @@
+//
+// Scenario generator for the LASP VEN simulation.
+//
+// Usage: lasp_scenario_gen [options] DIR
+//
+// Writes a SUMO network and routes, the veins_launchd launch file, the
+// edge topology descriptor (topology.xml) and a scenario.ini
+// into DIR. Run the result from the repository root with
+//
+//   src/lasp-ven -n src:simulations -f DIR/scenario.ini -c Scenario
+//
+// The same options and seed always produce identical files.
+//
+
+#include "ScenarioWriter.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+using namespace lasp_tools;
+
+namespace {
+
+void usage()
+{
+    fprintf(stderr, "usage: lasp_scenario_gen [options] DIR\n");
+    fprintf(stderr, "  --layout grid|arterial  Manhattan grid or one arterial with side streets (default grid)\n");
+    fprintf(stderr, "  --columns N             junctions along x (default 3)\n");
+    fprintf(stderr, "  --rows N                junctions along y, grid only (default 3)\n");
+    fprintf(stderr, "  --block M               block length in m (default 100)\n");
+    fprintf(stderr, "  --speed MPS             street speed limit (default 13.89)\n");
+    fprintf(stderr, "  --arterial-every N      grid: every N-th row and column is an arterial (default 0, none)\n");
+    fprintf(stderr, "  --arterial-lanes N      arterial lanes per direction (default 2)\n");
+    fprintf(stderr, "  --arterial-speed MPS    arterial speed limit (default 19.44)\n");
+    fprintf(stderr, "  --vehicles N            number of vehicles (default 10)\n");
+    fprintf(stderr, "  --demand CURVE          uniform, peak, ramp or t:rate,t:rate,... (default uniform)\n");
+    fprintf(stderr, "  --depart-end S          departures span [0, S) for named curves (default 100)\n");
+    fprintf(stderr, "  --sim-time S            simulation time limit (default 200)\n");
+    fprintf(stderr, "  --servers N             number of edge servers (default 4)\n");
+    fprintf(stderr, "  --seed N                random seed (default 1)\n");
+    fprintf(stderr, "  --base-ini PATH         ini included by scenario.ini, relative to DIR\n");
+    fprintf(stderr, "                          (default ../simulations/lasp_ven_simple_example/lasp_ven_simple.ini)\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    ScenarioSpec spec;
+    std::string demand = "uniform";
+    std::string baseIni = "../simulations/lasp_ven_simple_example/lasp_ven_simple.ini";
+    std::string directory;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg[0] != '-') {
+            directory = arg;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        const char *value = argv[++i];
+        if (arg == "--layout") {
+            std::string layout = value;
+            if (layout != "grid" && layout != "arterial") {
+                usage();
+                return 1;
+            }
+            spec.layout = layout == "arterial" ? Layout::Arterial : Layout::Grid;
+        }
+        else if (arg == "--columns") {
+            spec.gridColumns = std::atoi(value);
+        }
+        else if (arg == "--rows") {
+            spec.gridRows = std::atoi(value);
+        }
+        else if (arg == "--block") {
+            spec.blockLength = std::atof(value);
+        }
+        else if (arg == "--speed") {
+            spec.speedLimit = std::atof(value);
+        }
+        else if (arg == "--arterial-every") {
+            spec.arterialSpacing = std::atoi(value);
+        }
+        else if (arg == "--arterial-lanes") {
+            spec.arterialLanes = std::atoi(value);
+        }
+        else if (arg == "--arterial-speed") {
+            spec.arterialSpeedLimit = std::atof(value);
+        }
+        else if (arg == "--vehicles") {
+            spec.numVehicles = std::atoi(value);
+        }
+        else if (arg == "--demand") {
+            demand = value;
+        }
+        else if (arg == "--depart-end") {
+            spec.departEnd = std::atof(value);
+        }
+        else if (arg == "--sim-time") {
+            spec.simTime = std::atof(value);
+        }
+        else if (arg == "--servers") {
+            spec.numEdgeServers = std::atoi(value);
+        }
+        else if (arg == "--seed") {
+            spec.seed = (unsigned)std::atol(value);
+        }
+        else if (arg == "--base-ini") {
+            baseIni = value;
+        }
+        else {
+            usage();
+            return 1;
+        }
+    }
+    if (directory.empty()) {
+        usage();
+        return 1;
+    }
+
+    try {
+        spec.demand = parseDemandCurve(demand, spec.departEnd);
+        ScenarioWriter writer(spec);
+        writer.write(directory, baseIni);
+        printf("%s: %s %dx%d, %d vehicles, %d edge servers, %.0fm x %.0fm\n", directory.c_str(),
+               spec.layout == Layout::Arterial ? "arterial" : "grid", spec.gridColumns,
+               spec.layout == Layout::Arterial ? 3 : spec.gridRows, spec.numVehicles, spec.numEdgeServers,
+               writer.getWidth(), writer.getHeight());
+    }
+    catch (const std::exception& e) {
+        fprintf(stderr, "lasp_scenario_gen: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
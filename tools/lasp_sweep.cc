@@ -0,0 +1,837 @@
+//
+// Parallel parameter sweep runner for the LASP VEN simulation.
+//
+// Usage: lasp_sweep [options]
+//
+// Expands the runs of one ini configuration (iteration variables such as
+// ${strategy} and ${loadWeight} times repetitions) and runs them in Cmdenv on
+// all local cores. Every run borrows a port from a bounded pool for
+// *.veinsManager.port, so concurrent TraCI connections never share one.
+// With --launchd, one veins_launchd is started per pool port for the
+// duration of the sweep.
+//
+// Results are content addressed: a run's key is a hash of the simulation
+// binary, the NED files on the NED path, the fully expanded run
+// configuration (ini section with its parameters and seed-set, as printed by
+// "-q runconfig") and the --set overrides. A run writes to <cache>/<key>/
+// and is skipped when that directory is already complete, so re-running a
+// sweep after changing one strategy only recomputes the affected runs.
+// One line per run is written to the index CSV:
+//
+//   config,run,status,cached,wall_time_s,key,result_dir,iteration
+//
+// Files referenced by xmldoc() (launch configs, topology.xml) are not hashed;
+// use --force after editing them.
+//
+// With --adaptive METRIC, repetitions run in rounds: SequentialController
+// compares the strategies on METRIC after every round and only strategies
+// that are still part of an undecided comparison get more repetitions. The
+// runs and core-seconds saved against the fixed-N sweep are reported at the
+// end.
+//
+
+#include "ResultStore.h"
+#include "SequentialController.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <dirent.h>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#else
+#include <direct.h>
+#define getcwd _getcwd
+#define popen _popen
+#define pclose _pclose
+#endif
+
+using namespace lasp_tools;
+
+namespace {
+
+struct Options {
+    std::string simulation = "src/lasp-ven";
+    std::string nedPath = "src:simulations";
+    std::string ini = "simulations/lasp_ven_simple_example/lasp_ven_simple.ini";
+    std::string config = "General";
+    std::string runFilter;
+    std::string cacheDir = "sweep_cache";
+    std::string output = "sweep_results.csv";
+    std::string launchd;
+    std::vector<std::string> overrides;
+    std::vector<int> ports;
+    unsigned jobs = 0;
+    double timeout = 3600.0;
+    bool force = false;
+
+    std::string adaptiveMetric; // scalar name; empty runs every repetition
+    std::string metricModule = "*";
+    SequentialController::Settings sequential;
+};
+
+struct Run {
+    int number = 0;
+    std::string iteration; // "$strategy=\"greedy\", $repetition=0"
+    std::string measurement; // iteration without $repetition
+    int repetition = 0;
+    std::string key;
+    std::string status;
+    bool cached = false;
+    double wallTime = 0.0;
+};
+
+// 64-bit FNV-1a; enough to tell sweep inputs apart, not a security boundary
+class Hash {
+public:
+    void add(const void *data, size_t size)
+    {
+        const unsigned char *p = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; i++) {
+            value = (value ^ p[i]) * 0x100000001b3ULL;
+        }
+    }
+    void add(const std::string& text)
+    {
+        uint64_t size = text.size();
+        add(&size, sizeof(size)); // length prefix keeps field boundaries apart
+        add(text.data(), text.size());
+    }
+    bool addFile(const std::string& path)
+    {
+        FILE *f = fopen(path.c_str(), "rb");
+        if (!f) {
+            return false;
+        }
+        add(path);
+        char buffer[1 << 16];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+            add(buffer, n);
+        }
+        fclose(f);
+        return true;
+    }
+    std::string hex() const
+    {
+        // Final avalanche so keys of similar runs do not share long prefixes
+        uint64_t mixed = value;
+        mixed = (mixed ^ (mixed >> 33)) * 0xff51afd7ed558ccdULL;
+        mixed = (mixed ^ (mixed >> 33)) * 0xc4ceb9fe1a85ec53ULL;
+        mixed ^= mixed >> 33;
+        char text[17];
+        snprintf(text, sizeof(text), "%016llx", (unsigned long long)mixed);
+        return text;
+    }
+
+private:
+    uint64_t value = 0xcbf29ce484222325ULL;
+};
+
+// Bounded pool of TraCI ports; acquire() blocks until one is free
+class PortPool {
+public:
+    explicit PortPool(const std::vector<int>& ports) : free(ports.begin(), ports.end()) {}
+    int acquire()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        available.wait(lock, [this] { return !free.empty(); });
+        int port = free.front();
+        free.pop_front();
+        return port;
+    }
+    void release(int port)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            free.push_back(port);
+        }
+        available.notify_one();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable available;
+    std::deque<int> free;
+};
+
+std::string absolutePath(const std::string& path)
+{
+    if (path.empty() || path[0] == '/' || (path.size() > 1 && path[1] == ':')) {
+        return path;
+    }
+    char cwd[4096];
+    if (!getcwd(cwd, sizeof(cwd))) {
+        throw std::runtime_error("Cannot determine working directory");
+    }
+    return std::string(cwd) + "/" + path;
+}
+
+std::string absolutePathList(const std::string& paths)
+{
+    std::string result;
+    std::stringstream in(paths);
+    std::string item;
+    while (std::getline(in, item, ':')) {
+        result += (result.empty() ? "" : ":") + absolutePath(item);
+    }
+    return result;
+}
+
+std::string directoryOf(const std::string& path)
+{
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? "." : path.substr(0, slash);
+}
+
+std::string fileNameOf(const std::string& path)
+{
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+bool fileExists(const std::string& path)
+{
+    struct stat st;
+    return stat(path.c_str(), &st) == 0;
+}
+
+void makeDirectory(const std::string& path)
+{
+#ifdef _WIN32
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0755);
+#endif
+}
+
+std::vector<int> parsePorts(const std::string& text)
+{
+    std::vector<int> ports;
+    std::stringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        size_t dash = item.find('-');
+        int first = std::stoi(item.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+        for (int port = first; port <= last; port++) {
+            ports.push_back(port);
+        }
+    }
+    return ports;
+}
+
+// Hashes every .ned file below dir, in name order so the result is stable
+void hashNedFiles(Hash& hash, const std::string& dir)
+{
+    DIR *d = opendir(dir.c_str());
+    if (!d) {
+        return;
+    }
+    std::vector<std::string> entries;
+    while (struct dirent *entry = readdir(d)) {
+        std::string name = entry->d_name;
+        if (name != "." && name != "..") {
+            entries.push_back(name);
+        }
+    }
+    closedir(d);
+    std::sort(entries.begin(), entries.end());
+    for (const std::string& name : entries) {
+        std::string path = dir + "/" + name;
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) {
+            continue;
+        }
+        if (S_ISDIR(st.st_mode)) {
+            hashNedFiles(hash, path);
+        }
+        else if (name.size() > 4 && name.compare(name.size() - 4, 4, ".ned") == 0) {
+            hash.addFile(path);
+        }
+    }
+}
+
+// Common prefix of every simulation command: binary, Cmdenv, NED path, ini, config
+std::string baseCommand(const Options& options)
+{
+#ifdef _WIN32
+    std::string cd = "cd /d \"";
+#else
+    std::string cd = "cd \"";
+#endif
+    return cd + directoryOf(absolutePath(options.ini)) + "\" && \"" + absolutePath(options.simulation) + "\" -u Cmdenv -n \"" +
+           absolutePathList(options.nedPath) + "\" -f \"" + fileNameOf(options.ini) + "\" -c " + options.config;
+}
+
+std::string capture(const std::string& command, int *exitCode = nullptr)
+{
+    std::string output;
+    FILE *p = popen(command.c_str(), "r");
+    if (!p) {
+        throw std::runtime_error("Cannot run " + command);
+    }
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), p)) > 0) {
+        output.append(buffer, n);
+    }
+    int status = pclose(p);
+    if (exitCode) {
+        *exitCode = status;
+    }
+    return output;
+}
+
+std::string overrideArguments(const Options& options)
+{
+    std::string args;
+    for (const std::string& entry : options.overrides) {
+        args += " \"--" + entry + "\"";
+    }
+    return args;
+}
+
+// Run numbers and iteration variables from "-q runs" ("Run 3: $strategy=..., $repetition=0")
+std::vector<Run> listRuns(const Options& options)
+{
+    std::string command = baseCommand(options) + overrideArguments(options) + " -q runs";
+    if (!options.runFilter.empty()) {
+        command += " -r \"" + options.runFilter + "\"";
+    }
+    int exitCode = 0;
+    std::istringstream output(capture(command + " 2>&1", &exitCode));
+    std::vector<Run> runs;
+    std::string line;
+    while (std::getline(output, line)) {
+        if (line.compare(0, 4, "Run ") != 0) {
+            continue;
+        }
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        Run run;
+        run.number = std::atoi(line.c_str() + 4);
+        run.iteration = line.substr(colon + 1);
+        run.iteration.erase(0, run.iteration.find_first_not_of(' '));
+        run.iteration.erase(run.iteration.find_last_not_of("\r\n ") + 1);
+        std::istringstream variables(run.iteration);
+        std::string variable;
+        while (std::getline(variables, variable, ',')) {
+            variable.erase(0, variable.find_first_not_of(' '));
+            if (variable.compare(0, 12, "$repetition=") == 0) {
+                run.repetition = std::atoi(variable.c_str() + 12);
+            }
+            else {
+                run.measurement += (run.measurement.empty() ? "" : ", ") + variable;
+            }
+        }
+        runs.push_back(run);
+    }
+    if (runs.empty()) {
+        throw std::runtime_error("No runs found for config " + options.config + " (exit code " + std::to_string(exitCode) + ")");
+    }
+    return runs;
+}
+
+std::string runKey(const Options& options, const Hash& inputs, const Run& run)
+{
+    int exitCode = 0;
+    std::string runConfig = capture(baseCommand(options) + " -r " + std::to_string(run.number) + overrideArguments(options) + " -q runconfig 2>&1", &exitCode);
+    if (exitCode != 0) {
+        throw std::runtime_error("Cannot expand run " + std::to_string(run.number) + ":\n" + runConfig);
+    }
+    Hash hash = inputs;
+    hash.add(runConfig);
+    for (const std::string& entry : options.overrides) {
+        hash.add(entry);
+    }
+    return hash.hex();
+}
+
+#ifndef _WIN32
+int execute(const std::vector<std::string>& args, const std::string& directory, const std::string& logFile, double timeout, bool& timedOut)
+{
+    std::vector<char *> argv;
+    for (const std::string& arg : args) {
+        argv.push_back(const_cast<char *>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid < 0) {
+        throw std::runtime_error("fork failed");
+    }
+    if (pid == 0) {
+        if (chdir(directory.c_str()) != 0) {
+            _exit(127);
+        }
+        int log = open(logFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (log >= 0) {
+            dup2(log, 1);
+            dup2(log, 2);
+            close(log);
+        }
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+
+    int status = 0;
+    timedOut = false;
+    while (waitpid(pid, &status, WNOHANG) != pid) {
+        if (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > timeout) {
+            kill(pid, SIGKILL);
+            waitpid(pid, &status, 0);
+            timedOut = true;
+            break;
+        }
+        usleep(20000);
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
+#endif
+
+void simulate(const Options& options, Run& run, int port)
+{
+    std::string resultDir = absolutePath(options.cacheDir) + "/" + run.key;
+    std::string prefix = resultDir + "/" + options.config + "-" + std::to_string(run.number);
+    makeDirectory(resultDir);
+    remove((resultDir + "/complete").c_str());
+
+    std::vector<std::string> args = {
+        absolutePath(options.simulation), "-u", "Cmdenv", "-n", absolutePathList(options.nedPath),
+        "-f", fileNameOf(options.ini), "-c", options.config, "-r", std::to_string(run.number),
+        "--result-dir=" + resultDir,
+        "--output-scalar-file=" + prefix + ".sca",
+        "--output-vector-file=" + prefix + ".vec",
+        "--cmdenv-output-file=" + resultDir + "/log.txt",
+        "--cmdenv-express-mode=true",
+        "--*.veinsManager.port=" + std::to_string(port),
+    };
+    for (const std::string& entry : options.overrides) {
+        args.push_back("--" + entry);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int exitCode;
+    bool timedOut = false;
+#ifndef _WIN32
+    exitCode = execute(args, directoryOf(absolutePath(options.ini)), resultDir + "/stdout.log", options.timeout, timedOut);
+#else
+    // No timeout on Windows
+    std::string command = "cd /d \"" + directoryOf(absolutePath(options.ini)) + "\" &&";
+    for (const std::string& arg : args) {
+        command += " \"" + arg + "\"";
+    }
+    exitCode = std::system((command + " > \"" + resultDir + "/stdout.log\" 2>&1").c_str());
+#endif
+    run.wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (timedOut) {
+        run.status = "timeout";
+    }
+    else if (exitCode != 0) {
+        run.status = "failed";
+    }
+    else {
+        // Only complete directories count as cache hits
+        std::ofstream marker(resultDir + "/complete");
+        marker << "config " << options.config << "\nrun " << run.number << "\niteration " << run.iteration << "\n";
+        run.status = "ok";
+    }
+}
+
+// Mean of the scalars named options.adaptiveMetric in the run's .sca file,
+// NaN if the run recorded none
+double readMetric(const Options& options, const Run& run)
+{
+    std::string directory = options.cacheDir + "/" + run.key;
+    std::ifstream in(directory + "/" + options.config + "-" + std::to_string(run.number) + ".sca");
+    double sum = 0.0;
+    int count = 0;
+    std::string line;
+    std::string statisticModule, statisticName; // of the enclosing statistic block
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string kind, module, name, value;
+        fields >> kind;
+        if (kind == "statistic" && fields >> statisticModule >> statisticName) {
+            continue;
+        }
+        if (kind == "scalar") {
+            fields >> module >> name >> value;
+        }
+        else if (kind == "field" && fields >> name >> value) {
+            module = statisticModule;
+            name = statisticName + ":" + name;
+        }
+        else {
+            continue;
+        }
+        if (name == options.adaptiveMetric && globMatch(options.metricModule.c_str(), module.c_str())) {
+            sum += std::strtod(value.c_str(), nullptr);
+            count++;
+        }
+    }
+    return count ? sum / count : std::nan("");
+}
+
+std::vector<int> startLaunchd(const Options& options)
+{
+    std::vector<int> pids;
+#ifndef _WIN32
+    for (int port : options.ports) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            setpgid(0, 0);
+            std::string portText = std::to_string(port);
+            execlp(options.launchd.c_str(), options.launchd.c_str(), "-p", portText.c_str(), (char *)nullptr);
+            _exit(127);
+        }
+        if (pid > 0) {
+            pids.push_back(pid);
+        }
+    }
+    sleep(1); // let the daemons bind their ports
+#else
+    fprintf(stderr, "--launchd is not supported on Windows, start veins_launchd on every pool port by hand\n");
+#endif
+    return pids;
+}
+
+void stopLaunchd(const std::vector<int>& pids)
+{
+#ifndef _WIN32
+    for (int pid : pids) {
+        kill(-pid, SIGTERM); // launchd and the SUMO instances it forked
+        waitpid(pid, nullptr, 0);
+    }
+#endif
+}
+
+std::string csvQuote(const std::string& text)
+{
+    std::string quoted = "\"";
+    for (char c : text) {
+        quoted += c == '"' ? "\"\"" : std::string(1, c);
+    }
+    return quoted + "\"";
+}
+
+// Runs repetitions in rounds until SequentialController has decided every comparison
+template <typename RunBatch>
+void runAdaptive(const Options& options, std::vector<Run>& runs, RunBatch runBatch)
+{
+    std::map<std::string, std::vector<Run *>> byMeasurement;
+    for (Run& run : runs) {
+        byMeasurement[run.measurement].push_back(&run);
+    }
+    std::vector<std::string> groups;
+    std::vector<std::vector<Run *>> groupRuns;
+    int maxReps = INT32_MAX;
+    for (auto& entry : byMeasurement) {
+        std::sort(entry.second.begin(), entry.second.end(), [](const Run *a, const Run *b) { return a->repetition < b->repetition; });
+        groups.push_back(entry.first);
+        groupRuns.push_back(entry.second);
+        maxReps = std::min(maxReps, (int)entry.second.size());
+    }
+
+    SequentialController::Settings settings = options.sequential;
+    settings.maxReps = maxReps;
+    SequentialController controller(settings, groups);
+    fprintf(stderr, "adaptive: %zu groups, %zu comparisons of %s, at most %d repetitions and %d looks\n", groups.size(),
+            controller.getComparisons().size(), options.adaptiveMetric.c_str(), maxReps, controller.getMaxLooks());
+
+    std::vector<int> done(groups.size(), 0);
+    for (int round = 1;; round++) {
+        std::vector<int> wanted = controller.scheduleRound();
+        std::vector<Run *> batch;
+        std::vector<int> batchGroup;
+        for (size_t g = 0; g < groups.size(); g++) {
+            for (int r = done[g]; r < wanted[g]; r++) {
+                batch.push_back(groupRuns[g][r]);
+                batchGroup.push_back((int)g);
+            }
+            done[g] = wanted[g];
+        }
+        if (batch.empty()) {
+            break;
+        }
+        fprintf(stderr, "adaptive round %d: %zu runs\n", round, batch.size());
+        runBatch(batch);
+        for (size_t i = 0; i < batch.size(); i++) {
+            if (batch[i]->status == "ok") {
+                double value = readMetric(options, *batch[i]);
+                if (std::isnan(value)) {
+                    fprintf(stderr, "run %d recorded no %s\n", batch[i]->number, options.adaptiveMetric.c_str());
+                    continue;
+                }
+                controller.addObservation(batchGroup[i], value);
+            }
+        }
+        controller.update();
+        if (controller.isFinished()) {
+            break;
+        }
+    }
+
+    printf("%-40s %-40s %4s %4s %12s %12s %12s %10s  %s\n", "a", "b", "n_a", "n_b", "diff", "ci_low", "ci_high", "p", "decision");
+    for (const SequentialController::Comparison& c : controller.getComparisons()) {
+        printf("%-40s %-40s %4zu %4zu %12.6g %12.6g %12.6g %10.4g  %s\n", groups[c.a].c_str(), groups[c.b].c_str(),
+               controller.getObservations(c.a).size(), controller.getObservations(c.b).size(), c.difference,
+               c.difference - c.halfWidth, c.difference + c.halfWidth, c.p, SequentialController::decisionName(c.decision));
+    }
+
+    // Savings against running every group to maxReps
+    int used = 0, simulated = 0;
+    double simulatedTime = 0.0;
+    for (size_t g = 0; g < groups.size(); g++) {
+        used += done[g];
+        for (int r = 0; r < done[g]; r++) {
+            if (!groupRuns[g][r]->cached) {
+                simulated++;
+                simulatedTime += groupRuns[g][r]->wallTime;
+            }
+        }
+    }
+    int fixed = (int)groups.size() * maxReps;
+    double meanRunTime = simulated > 0 ? simulatedTime / simulated : 0.0;
+    printf("\nfixed-N sweep: %d runs; adaptive: %d runs (%d simulated, %.0f core-s); saved %d runs (%.0f%%, ~%.0f core-s)\n", fixed, used,
+           simulated, simulatedTime, fixed - used, fixed > 0 ? 100.0 * (fixed - used) / fixed : 0.0, (fixed - used) * meanRunTime);
+}
+
+void usage()
+{
+    fprintf(stderr, "usage: lasp_sweep [options]\n");
+    fprintf(stderr, "  --ini PATH           ini file (default simulations/lasp_ven_simple_example/lasp_ven_simple.ini)\n");
+    fprintf(stderr, "  --config NAME        configuration to sweep (default General)\n");
+    fprintf(stderr, "  --runs FILTER        run filter as for -r, e.g. '$strategy==\"greedy\"' (default all)\n");
+    fprintf(stderr, "  --set KEY=VALUE      extra configuration option, repeatable, e.g. --set sim-time-limit=100s\n");
+    fprintf(stderr, "  --jobs N             concurrent runs (default: number of cores)\n");
+    fprintf(stderr, "  --ports LIST         TraCI port pool, e.g. 9999-10006 or 9999,10001 (default 9999 + job index)\n");
+    fprintf(stderr, "  --launchd CMD        start CMD -p PORT (e.g. veins_launchd) for every pool port\n");
+    fprintf(stderr, "  --sim PATH           simulation binary (default src/lasp-ven)\n");
+    fprintf(stderr, "  --ned-path PATHS     NED path (default src:simulations)\n");
+    fprintf(stderr, "  --cache DIR          result cache (default sweep_cache)\n");
+    fprintf(stderr, "  --out FILE           index CSV (default sweep_results.csv)\n");
+    fprintf(stderr, "  --timeout S          wall-clock limit per run (default 3600)\n");
+    fprintf(stderr, "  --force              ignore cached results\n");
+    fprintf(stderr, "adaptive repetitions:\n");
+    fprintf(stderr, "  --adaptive METRIC    scalar deciding the comparisons, e.g. averageLatency:mean\n");
+    fprintf(stderr, "  --metric-module GLOB modules whose METRIC is averaged per run (default *)\n");
+    fprintf(stderr, "  --baseline GLOB      compare groups with those matching GLOB (default: all pairs)\n");
+    fprintf(stderr, "  --alpha A            overall significance level (default 0.05)\n");
+    fprintf(stderr, "  --target-width W     stop once the CI of the difference is narrower than W (default off)\n");
+    fprintf(stderr, "  --min-reps N         repetitions before the first look (default 3)\n");
+    fprintf(stderr, "  --round N            repetitions added per round (default 2)\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--force") {
+            options.force = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        const char *value = argv[++i];
+        if (arg == "--ini") {
+            options.ini = value;
+        }
+        else if (arg == "--config") {
+            options.config = value;
+        }
+        else if (arg == "--runs") {
+            options.runFilter = value;
+        }
+        else if (arg == "--set") {
+            options.overrides.push_back(value);
+        }
+        else if (arg == "--jobs") {
+            options.jobs = (unsigned)std::atoi(value);
+        }
+        else if (arg == "--ports") {
+            options.ports = parsePorts(value);
+        }
+        else if (arg == "--launchd") {
+            options.launchd = value;
+        }
+        else if (arg == "--sim") {
+            options.simulation = value;
+        }
+        else if (arg == "--ned-path") {
+            options.nedPath = value;
+        }
+        else if (arg == "--cache") {
+            options.cacheDir = value;
+        }
+        else if (arg == "--out") {
+            options.output = value;
+        }
+        else if (arg == "--timeout") {
+            options.timeout = std::atof(value);
+        }
+        else if (arg == "--adaptive") {
+            options.adaptiveMetric = value;
+        }
+        else if (arg == "--metric-module") {
+            options.metricModule = value;
+        }
+        else if (arg == "--baseline") {
+            options.sequential.baseline = value;
+        }
+        else if (arg == "--alpha") {
+            options.sequential.alpha = std::atof(value);
+        }
+        else if (arg == "--target-width") {
+            options.sequential.targetWidth = std::atof(value);
+        }
+        else if (arg == "--min-reps") {
+            options.sequential.minReps = std::atoi(value);
+        }
+        else if (arg == "--round") {
+            options.sequential.roundSize = std::atoi(value);
+        }
+        else {
+            usage();
+            return 1;
+        }
+    }
+    if (options.jobs == 0) {
+        options.jobs = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (options.ports.empty()) {
+        for (unsigned j = 0; j < options.jobs; j++) {
+            options.ports.push_back(9999 + (int)j);
+        }
+    }
+
+    std::vector<Run> runs;
+    Hash inputs;
+    try {
+        runs = listRuns(options);
+        if (!inputs.addFile(absolutePath(options.simulation))) {
+            throw std::runtime_error("Cannot read " + options.simulation);
+        }
+        std::stringstream nedPath(options.nedPath);
+        std::string dir;
+        while (std::getline(nedPath, dir, ':')) {
+            hashNedFiles(inputs, dir);
+        }
+    }
+    catch (const std::exception& e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    makeDirectory(options.cacheDir);
+    fprintf(stderr, "%zu runs of %s, %u jobs, %zu TraCI ports\n", runs.size(), options.config.c_str(), options.jobs, options.ports.size());
+
+    std::vector<int> launchdPids;
+    if (!options.launchd.empty()) {
+        launchdPids = startLaunchd(options);
+    }
+
+    PortPool ports(options.ports);
+    std::mutex logMutex;
+    auto runBatch = [&](const std::vector<Run *>& batch) {
+        std::atomic<size_t> nextRun(0);
+        auto worker = [&]() {
+            for (size_t i = nextRun++; i < batch.size(); i = nextRun++) {
+                Run& run = *batch[i];
+                try {
+                    run.key = runKey(options, inputs, run);
+                    if (!options.force && fileExists(options.cacheDir + "/" + run.key + "/complete")) {
+                        run.cached = true;
+                        run.status = "ok";
+                    }
+                    else {
+                        int port = ports.acquire();
+                        try {
+                            simulate(options, run, port);
+                        }
+                        catch (...) {
+                            ports.release(port);
+                            throw;
+                        }
+                        ports.release(port);
+                    }
+                }
+                catch (const std::exception& e) {
+                    run.status = "failed";
+                    std::lock_guard<std::mutex> lock(logMutex);
+                    fprintf(stderr, "run %d: %s\n", run.number, e.what());
+                }
+                std::lock_guard<std::mutex> lock(logMutex);
+                fprintf(stderr, "run %d %s%s %.1fs  %s\n", run.number, run.status.c_str(), run.cached ? " (cached)" : "", run.wallTime, run.iteration.c_str());
+            }
+        };
+        std::vector<std::thread> threads;
+        for (unsigned j = 0; j < std::min<size_t>(options.jobs, batch.size()); j++) {
+            threads.emplace_back(worker);
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    };
+
+    if (options.adaptiveMetric.empty()) {
+        std::vector<Run *> all;
+        for (Run& run : runs) {
+            all.push_back(&run);
+        }
+        runBatch(all);
+    }
+    else {
+        runAdaptive(options, runs, runBatch);
+    }
+    stopLaunchd(launchdPids);
+
+    FILE *out = fopen(options.output.c_str(), "w");
+    if (!out) {
+        fprintf(stderr, "cannot write %s\n", options.output.c_str());
+        return 1;
+    }
+    fprintf(out, "config,run,status,cached,wall_time_s,key,result_dir,iteration\n");
+    int executed = 0, failures = 0, cached = 0;
+    for (const Run& run : runs) {
+        if (run.status.empty()) {
+            continue; // not needed by the adaptive sweep
+        }
+        fprintf(out, "%s,%d,%s,%d,%.3f,%s,%s,%s\n", options.config.c_str(), run.number, run.status.c_str(), run.cached ? 1 : 0, run.wallTime,
+                run.key.c_str(), (options.cacheDir + "/" + run.key).c_str(), csvQuote(run.iteration).c_str());
+        executed++;
+        failures += run.status != "ok";
+        cached += run.cached;
+    }
+    fclose(out);
+    fprintf(stderr, "%d runs: %d cached, %d simulated, %d failed\n", executed, cached, executed - cached - failures, failures);
+    return failures > 0 ? 2 : 0;
+}
@@ -0,0 +1,166 @@
+//
+// Offline decoder for the binary trace files written by the LASP modules
+// (see src/lasp_ven_simple/utils/Trace.h).
+//
+// Usage: lasp_trace_decode [-e EVENT]... FILE.trc...
+//
+// Records of all given files are merged in simulation time order and printed
+// one per line:
+//   <time> <module path> <EVENT> <description> label=value ...
+//
+
+#include "Trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace lasp_ven_simple;
+
+namespace {
+
+struct DecodedRecord {
+    TraceRecord record;
+    size_t file;
+};
+
+bool readTraceFile(const char *fileName, size_t fileIndex, std::vector<std::string>& modulePaths, std::vector<DecodedRecord>& out)
+{
+    FILE *f = fopen(fileName, "rb");
+    if (!f) {
+        fprintf(stderr, "%s: cannot open file\n", fileName);
+        return false;
+    }
+
+    TraceFileHeader header;
+    if (fread(&header, sizeof(header), 1, f) != 1 || memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0) {
+        fprintf(stderr, "%s: not a LASP trace file\n", fileName);
+        fclose(f);
+        return false;
+    }
+    if (header.version != TRACE_VERSION || header.recordSize != sizeof(TraceRecord)) {
+        fprintf(stderr, "%s: unsupported trace version %u (record size %u)\n", fileName, header.version, header.recordSize);
+        fclose(f);
+        return false;
+    }
+    header.modulePath[sizeof(header.modulePath) - 1] = '\0';
+    modulePaths.push_back(header.modulePath);
+
+    TraceRecord buffer[1024];
+    size_t n;
+    while ((n = fread(buffer, sizeof(TraceRecord), 1024, f)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            out.push_back(DecodedRecord{buffer[i], fileIndex});
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+void printArgument(const char *label, long long value)
+{
+    if (!label || !*label) {
+        return;
+    }
+    size_t len = strlen(label);
+    if (len >= 4 && strcmp(label + len - 4, "Addr") == 0) {
+        unsigned long long a = (unsigned long long)value;
+        printf(" %s=%llu.%llu.%llu.%llu", label, (a >> 24) & 0xff, (a >> 16) & 0xff, (a >> 8) & 0xff, a & 0xff);
+    }
+    else {
+        printf(" %s=%lld", label, value);
+    }
+}
+
+void printRecord(const DecodedRecord& r, const std::vector<std::string>& modulePaths)
+{
+    const TraceRecord& rec = r.record;
+    printf("%.9f %s", rec.time, modulePaths[r.file].c_str());
+
+    const TraceEventInfo *info = getTraceEventInfo(rec.event);
+    if (!info) {
+        printf(" UNKNOWN(%d) arg0=%d arg1=%lld arg2=%lld value=%g\n", rec.event, rec.arg0, (long long)rec.arg1, (long long)rec.arg2, rec.value);
+        return;
+    }
+
+    printf(" %s %s", info->name, info->description);
+    printArgument(info->labels[0], rec.arg0);
+    printArgument(info->labels[1], rec.arg1);
+    printArgument(info->labels[2], rec.arg2);
+    if (info->labels[3][0]) {
+        printf(" %s=%g", info->labels[3], rec.value);
+    }
+    printf("\n");
+}
+
+void usage()
+{
+    fprintf(stderr, "usage: lasp_trace_decode [-e EVENT]... FILE.trc...\n");
+    fprintf(stderr, "  -e EVENT  only print records of this event (repeatable), e.g. -e RESPONSE_RECEIVED\n");
+    fprintf(stderr, "events:");
+    for (int32_t i = 0; i < (int32_t)TraceEvent::NUM_EVENTS; i++) {
+        fprintf(stderr, " %s", getTraceEventInfo(i)->name);
+    }
+    fprintf(stderr, "\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::set<int32_t> eventFilter;
+    std::vector<const char *> files;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+            const char *name = argv[++i];
+            int32_t event = -1;
+            for (int32_t e = 0; e < (int32_t)TraceEvent::NUM_EVENTS; e++) {
+                if (strcmp(getTraceEventInfo(e)->name, name) == 0) {
+                    event = e;
+                }
+            }
+            if (event < 0) {
+                fprintf(stderr, "unknown event %s\n", name);
+                usage();
+                return 1;
+            }
+            eventFilter.insert(event);
+        }
+        else if (argv[i][0] == '-') {
+            usage();
+            return 1;
+        }
+        else {
+            files.push_back(argv[i]);
+        }
+    }
+    if (files.empty()) {
+        usage();
+        return 1;
+    }
+
+    std::vector<std::string> modulePaths;
+    std::vector<DecodedRecord> records;
+    bool ok = true;
+    for (const char *file : files) {
+        if (readTraceFile(file, modulePaths.size(), modulePaths, records) == false) {
+            ok = false;
+        }
+    }
+
+    // Files are individually in time order; a stable sort keeps same-time records in file order
+    std::stable_sort(records.begin(), records.end(), [](const DecodedRecord& a, const DecodedRecord& b) {
+        return a.record.time < b.record.time;
+    });
+
+    for (const DecodedRecord& r : records) {
+        if (eventFilter.empty() || eventFilter.count(r.record.event)) {
+            printRecord(r, modulePaths);
+        }
+    }
+    return ok ? 0 : 1;
+}
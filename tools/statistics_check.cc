@@ -0,0 +1,70 @@
+//
+// Checks of the Statistics functions against table values, run by make check.
+// Prints every failed check and exits non-zero if there was one.
+//
+
+#include "Statistics.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace lasp_tools;
+
+static int failures = 0;
+
+static void check(const char* what, double actual, double expected, double tolerance)
+{
+    if (!(std::fabs(actual - expected) <= tolerance)) {
+        std::fprintf(stderr, "FAIL %s: got %.9g, expected %.9g\n", what, actual, expected);
+        failures++;
+    }
+}
+
+int main()
+{
+    // Two-sided t-table critical values
+    check("studentTQuantile(0.975, 1)", studentTQuantile(0.975, 1), 12.7062, 1e-3);
+    check("studentTQuantile(0.975, 10)", studentTQuantile(0.975, 10), 2.2281, 1e-3);
+    check("studentTQuantile(0.975, 30)", studentTQuantile(0.975, 30), 2.0423, 1e-3);
+    check("studentTQuantile(0.95, 5)", studentTQuantile(0.95, 5), 2.0150, 1e-3);
+    check("studentTQuantile(0.995, 20)", studentTQuantile(0.995, 20), 2.8453, 1e-3);
+    check("studentTQuantile(0.025, 10)", studentTQuantile(0.025, 10), -2.2281, 1e-3);
+    check("studentTQuantile(0.5, 7)", studentTQuantile(0.5, 7), 0.0, 1e-9);
+
+    for (double df : {1.0, 2.0, 10.0, 100.0}) {
+        check("studentTCdf(0, df)", studentTCdf(0.0, df), 0.5, 0.0);
+    }
+    check("studentTCdf(2.2281, 10)", studentTCdf(2.2281, 10), 0.975, 1e-4);
+    check("studentTCdf(-12.7062, 1)", studentTCdf(-12.7062, 1), 0.025, 1e-4);
+    check("studentTCdf(1, 1)", studentTCdf(1.0, 1), 0.75, 1e-9); // Cauchy
+
+    // I_x(a, 1) = x^a, I_x(1, 1) = x, I_x(a, b) = 1 - I_(1-x)(b, a)
+    check("incompleteBeta(2, 1, 0.5)", incompleteBeta(2, 1, 0.5), 0.25, 1e-9);
+    check("incompleteBeta(1, 1, 0.3)", incompleteBeta(1, 1, 0.3), 0.3, 1e-9);
+    check("incompleteBeta symmetry", incompleteBeta(2.5, 4, 0.7), 1.0 - incompleteBeta(4, 2.5, 0.3), 1e-9);
+    check("incompleteBeta(3, 2, 0)", incompleteBeta(3, 2, 0.0), 0.0, 0.0);
+    check("incompleteBeta(3, 2, 1)", incompleteBeta(3, 2, 1.0), 1.0, 0.0);
+
+    std::vector<double> sorted = {1, 2, 3, 4};
+    check("percentileSorted(50)", percentileSorted(sorted, 50), 2.5, 1e-12);
+    check("percentileSorted(0)", percentileSorted(sorted, 0), 1.0, 0.0);
+    check("percentileSorted(100)", percentileSorted(sorted, 100), 4.0, 0.0);
+    if (!std::isnan(percentileSorted({}, 50))) {
+        std::fprintf(stderr, "FAIL percentileSorted of an empty vector is not NaN\n");
+        failures++;
+    }
+
+    Summary summary = summarize({2, 4, 4, 4, 5, 5, 7, 9});
+    check("summarize mean", summary.mean, 5.0, 1e-12);
+    check("summarize stddev", summary.stddev, std::sqrt(32.0 / 7.0), 1e-12);
+    check("confidenceHalfWidth(0.95)", confidenceHalfWidth(summary, 0.95),
+          2.3646 * summary.stddev / std::sqrt(8.0), 1e-3);
+
+    if (failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("All statistics checks passed\n");
+    return 0;
+}